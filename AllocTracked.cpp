@@ -0,0 +1,102 @@
+#include "AllocTracked.h"
+
+#include <new>
+
+
+struct AllocCounters
+{
+	long Objects;
+	long Bytes;
+	long Peak;
+	long Allocations;       // Objects allocated since the start
+};
+
+static AllocCounters counters[ALLOC_CATEGORY_COUNT];
+static long totalBytes = 0;
+static long totalPeak = 0;
+
+static const char *categoryNames[ALLOC_CATEGORY_COUNT] =
+{
+	"Signal",
+	"Connection",
+	"OuterConnection",
+	"Instance",
+	"Module",
+	"SymbolTable",
+	"ExpressionArray",
+	"Parameter",
+	"StringBuffer chunks",
+};
+
+
+void AllocTrackNew(AllocCategory category, size_t size)
+{
+	AllocCounters &c = counters[category];
+	c.Objects++;
+	c.Allocations++;
+	c.Bytes += size;
+	if (c.Bytes > c.Peak)
+		c.Peak = c.Bytes;
+
+	totalBytes += size;
+	if (totalBytes > totalPeak)
+		totalPeak = totalBytes;
+}
+
+void AllocTrackDelete(AllocCategory category, size_t size)
+{
+	AllocCounters &c = counters[category];
+	c.Objects--;
+	c.Bytes -= size;
+	totalBytes -= size;
+}
+
+void *TrackedAllocate(AllocCategory category, size_t size)
+{
+	void *p = ::operator new(size);
+	AllocTrackNew(category, size);
+	return p;
+}
+
+void TrackedFree(AllocCategory category, void *p, size_t size)
+{
+	if (p)
+	{
+		AllocTrackDelete(category, size);
+		::operator delete(p);
+	}
+}
+
+void AllocTrackBytes(AllocCategory category, long delta)
+{
+	AllocCounters &c = counters[category];
+	c.Bytes += delta;
+	if (c.Bytes > c.Peak)
+		c.Peak = c.Bytes;
+
+	totalBytes += delta;
+	if (totalBytes > totalPeak)
+		totalPeak = totalBytes;
+}
+
+
+void PrintAllocationStatistics(FILE *f, const char *phase)
+{
+	fprintf(f, "Memory after %s:\n", phase);
+	fprintf(f, "  %-20s %12s %14s %14s %14s\n", "category", "live objects", "live bytes", "peak bytes", "allocations");
+
+	long objects = 0, allocations = 0;
+	for (int i=0; i < ALLOC_CATEGORY_COUNT; i++)
+	{
+		AllocCounters &c = counters[i];
+		fprintf(f, "  %-20s %12ld %14ld %14ld %14ld\n", categoryNames[i], c.Objects, c.Bytes, c.Peak, c.Allocations);
+
+		objects += c.Objects;
+		allocations += c.Allocations;
+
+		c.Peak = c.Bytes;
+	}
+
+	fprintf(f, "  %-20s %12ld %14ld %14ld %14ld\n", "total", objects, totalBytes, totalPeak, allocations);
+	totalPeak = totalBytes;
+}
@@ -0,0 +1,59 @@
+#ifndef ALLOC_TRACKED_H
+#define ALLOC_TRACKED_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+
+// Categories of compiler data structures whose memory is accounted
+enum AllocCategory
+{
+	ALLOC_SIGNAL,
+	ALLOC_CONNECTION,
+	ALLOC_OUTER_CONNECTION,
+	ALLOC_INSTANCE,
+	ALLOC_MODULE,
+	ALLOC_SYMBOL_TABLE,
+	ALLOC_EXPRESSION_ARRAY,
+	ALLOC_PARAMETER,
+	ALLOC_STRING_CHUNK,
+
+	ALLOC_CATEGORY_COUNT
+};
+
+// Counts an object of a category being allocated or freed
+extern void AllocTrackNew(AllocCategory category, size_t size);
+extern void AllocTrackDelete(AllocCategory category, size_t size);
+
+// Allocates or frees a counted object, for the operators of AllocTracked
+extern void *TrackedAllocate(AllocCategory category, size_t size);
+extern void TrackedFree(AllocCategory category, void *p, size_t size);
+
+// Counts a change in the bytes of storage owned by objects of a category, such as their arrays
+extern void AllocTrackBytes(AllocCategory category, long delta);
+
+// Prints live objects, live bytes and peak bytes of each category, with the peaks since the previous report.
+// Peaks are then restarted from the live bytes.
+extern void PrintAllocationStatistics(FILE *f, const char *phase);
+
+
+// Base class which accounts the objects of a class hierarchy in a category, through class-specific new and delete.
+// Only the objects themselves are counted, not the containers they own.
+// Classes which are deleted through a base pointer must have a virtual destructor, so that the size freed is right.
+template <AllocCategory category>
+class AllocTracked
+{
+public:
+	static void *operator new(size_t size)
+	{
+		return TrackedAllocate(category, size);
+	}
+
+	static void operator delete(void *p, size_t size)
+	{
+		TrackedFree(category, p, size);
+	}
+};
+
+
+#endif
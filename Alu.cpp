@@ -24,6 +24,11 @@ Alu::~Alu()
 	}
 }
 
+int Alu::InstructionCount() const
+{
+	return num_instructions;
+}
+
 AluInstruction *Alu::AddInstruction(AluInstruction *inst)
 {
 	// Check for too many instructions
@@ -248,6 +253,11 @@ void Alu::Print(FILE *f) const
 			instructions[i]->Print(f);
 		}
 		fprintf(f, "\t}\n");
+
+		fprintf(f, "\tprogram\n");
+		fprintf(f, "\t{\n");
+		PrintProgramAnalysis(f, "\t\t");
+		fprintf(f, "\t}\n");
 	}
 }
 
@@ -753,81 +763,98 @@ const SiliconObjectDefinition *Alu::Definition() const
 	return BuiltinDefinition();
 }
 
-const SiliconObjectDefinition *Alu::BuiltinDefinition()
+// ALU Signals
+static const PortTableEntry aluPorts[] =
 {
-	// Return singleton instance if already created
-	if (definition)
-		return definition;
+	// These signals cannot be used outside of the ALU
+	{ "status",         DATA_TYPE_BIT,  DIR_NONE },
+	{ "carry",          DATA_TYPE_BIT,  DIR_NONE },
+	{ "zero",           DATA_TYPE_BIT,  DIR_NONE },
+	{ "negative",       DATA_TYPE_BIT,  DIR_NONE },
+	{ "overflow",       DATA_TYPE_BIT,  DIR_NONE },
 
-	// Create a new builtin singleton symbol table instance
-	SymbolTable *symbols = new SymbolTable(true);
+	// These signals can be connected to as inputs
+	{ "v_in",           DATA_TYPE_BIT,  DIR_IN },
+	{ "warm_reset",     DATA_TYPE_BIT,  DIR_IN },
+};
 
+const BuiltinObjectTable Alu::Table = { "ALU", aluPorts, countof(aluPorts), NULL, 0 };
 
-	// ALU Signals
 
-	// These signals cannot be used outside of the ALU
-	symbols->Add(new Signal("status",       BEHAVIOR_BUILTIN,  DATA_TYPE_BIT,  DIR_NONE ));
-	symbols->Add(new Signal("carry",        BEHAVIOR_BUILTIN,  DATA_TYPE_BIT,  DIR_NONE ));
-	symbols->Add(new Signal("zero",         BEHAVIOR_BUILTIN,  DATA_TYPE_BIT,  DIR_NONE ));
-	symbols->Add(new Signal("negative",     BEHAVIOR_BUILTIN,  DATA_TYPE_BIT,  DIR_NONE ));
-	symbols->Add(new Signal("overflow",     BEHAVIOR_BUILTIN,  DATA_TYPE_BIT,  DIR_NONE ));
+// ALU Functions   (Some functions are repeated with varying numbers of arguments)
+struct AluFunctionTableEntry
+{
+	const char *Name;
+	const char *Args;
+};
 
-	// These signals can be connected to as inputs
-	symbols->Add(new Signal("v_in",         BEHAVIOR_BUILTIN,  DATA_TYPE_BIT,  DIR_IN ));
-	symbols->Add(new Signal("warm_reset",   BEHAVIOR_BUILTIN,  DATA_TYPE_BIT,  DIR_IN ));
+static const AluFunctionTableEntry aluFunctions[] =
+{
+	{ "add",     "ww" },
+	{ "hadd",    "wwb" },
+	{ "and",     "ww" },
+	{ "and",     "www" },
+	{ "avg",     "ww" },
+	{ "havg",    "wwb" },
+	{ "bmux",    "www" },
+	{ "cmp",     "ww" },
+	{ "hcmp",    "wwb" },
+	{ "dec",     "w" },
+	{ "hdec",    "wb" },
+	{ "dshl",    "www" },
+	{ "dshli",   "wwk" },
+	{ "dshri",   "wwk" },
+	{ "inc",     "w" },
+	{ "hinc",    "wb" },
+	{ "inv",     "w" },
+	{ "mov",     "w" },
+	{ "mux",     "ww" },
+	{ "neg",     "w" },
+	{ "hneg",    "wb" },
+	{ "or",      "ww" },
+	{ "or",      "www" },
+	{ "roli",    "wk" },
+	{ "rol",     "ww" },
+	{ "rori",    "wk" },
+	{ "setsb",   "" },
+	{ "shli",    "wk" },
+	{ "shl",     "w" },
+	{ "shri",    "wk" },
+	{ "sub",     "ww" },
+	{ "hsub",    "wb" },
+	{ "xor",     "ww" },
+	{ "xor",     "www" },
+	{ "xoradd",  "www" },
+	{ "hxoradd", "wwbw" },
+	{ "xoravg",  "www" },
+	{ "hxoravg", "wwbw" },
+	{ "xorcmp",  "www" },
+	{ "hxorcmp", "wwbw" },
+	{ "zero",    "" },          // Note: does not conflict with signal "zero", because functions have a mangled name.
+};
+
+
+const SiliconObjectDefinition *Alu::BuiltinDefinition()
+{
+	// Return singleton instance if already created
+	if (definition)
+		return definition;
 
+	// Create a new singleton definition, with the ports from the static table
+	definition = new SiliconObjectDefinition(Table, AluFactory);
+	SymbolTable *symbols = definition->Symbols();
 
 	// ALU Enumerations
 	// hold is a valid RHS for v_out in ALU instruction.
 	// It is not added to the global symbol table like many enum values, because it is only valid in the "inst" section of an ALU.
 	symbols->Add(new EnumValue("hold"));
 
-	// ALU Functions   (Some functions are repeated with varying numbers of arguments)
-	symbols->Add(new AluFunction("add",     "ww"));
-	symbols->Add(new AluFunction("hadd",    "wwb"));
-	symbols->Add(new AluFunction("and",     "ww"));
-	symbols->Add(new AluFunction("and",     "www"));
-	symbols->Add(new AluFunction("avg",     "ww"));
-	symbols->Add(new AluFunction("havg",    "wwb"));
-	symbols->Add(new AluFunction("bmux",    "www"));
-	symbols->Add(new AluFunction("cmp",     "ww"));
-	symbols->Add(new AluFunction("hcmp",    "wwb"));
-	symbols->Add(new AluFunction("dec",     "w"));
-	symbols->Add(new AluFunction("hdec",    "wb"));
-	symbols->Add(new AluFunction("dshl",    "www"));
-	symbols->Add(new AluFunction("dshli",   "wwk"));
-	symbols->Add(new AluFunction("dshri",   "wwk"));
-	symbols->Add(new AluFunction("inc",     "w"));
-	symbols->Add(new AluFunction("hinc",    "wb"));
-	symbols->Add(new AluFunction("inv",     "w"));
-	symbols->Add(new AluFunction("mov",     "w"));
-	symbols->Add(new AluFunction("mux",     "ww"));
-	symbols->Add(new AluFunction("neg",     "w"));
-	symbols->Add(new AluFunction("hneg",    "wb"));
-	symbols->Add(new AluFunction("or",      "ww"));
-	symbols->Add(new AluFunction("or",      "www"));
-	symbols->Add(new AluFunction("roli",    "wk"));
-	symbols->Add(new AluFunction("rol",     "ww"));
-	symbols->Add(new AluFunction("rori",    "wk"));
-	symbols->Add(new AluFunction("setsb",   ""));
-	symbols->Add(new AluFunction("shli",    "wk"));
-	symbols->Add(new AluFunction("shl",     "w"));
-	symbols->Add(new AluFunction("shri",    "wk"));
-	symbols->Add(new AluFunction("sub",     "ww"));
-	symbols->Add(new AluFunction("hsub",    "wb"));
-	symbols->Add(new AluFunction("xor",     "ww"));
-	symbols->Add(new AluFunction("xor",     "www"));
-	symbols->Add(new AluFunction("xoradd",  "www"));
-	symbols->Add(new AluFunction("hxoradd", "wwbw"));
-	symbols->Add(new AluFunction("xoravg",  "www"));
-	symbols->Add(new AluFunction("hxoravg", "wwbw"));
-	symbols->Add(new AluFunction("xorcmp",  "www"));
-	symbols->Add(new AluFunction("hxorcmp", "wwbw"));
-	symbols->Add(new AluFunction("zero",    ""));           // Note: does not conflict with signal "zero", because functions have a mangled name.
-
-
-	// Create a new singleton definition
-	definition = new SiliconObjectDefinition("ALU", symbols, AluFactory);
+	// The definition outlives the global string buffer, so function keys are kept in a buffer of their own
+	StringBuffer *keyStrings = new StringBuffer(1024);
+	for (int i=0; i < (int) countof(aluFunctions); i++)
+	{
+		symbols->Add(new AluFunction(aluFunctions[i].Name, aluFunctions[i].Args, keyStrings));
+	}
 
 	return definition;
 }
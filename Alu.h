@@ -49,6 +49,31 @@
 
 class AluInstruction;
 
+// A loop in the instruction control-flow graph of an ALU program:  one strongly connected set of instructions
+struct AluLoop
+{
+	unsigned Members;       // Bit mask of instruction indexes in the loop
+	int MinCycles;          // Shortest and longest iteration through the loop, in cycles
+	int MaxCycles;
+	bool Stalls;            // Some instruction in the loop waits for v_in, so an iteration may take longer
+	bool Steady;            // No branch leaves the loop, so the program stays in it once entered
+};
+
+// Cycle behavior of an ALU program, assuming each instruction takes one cycle unless it waits for v_in
+struct AluProgramAnalysis
+{
+	int NumInstructions;
+	bool Reachable[MAX_ALU_INSTRUCTIONS];
+	bool WaitsForV[MAX_ALU_INSTRUCTIONS];
+	vector<AluLoop> Loops;
+
+	// Steady-state initiation interval, from the loops the program ends up in
+	bool HasInterval;
+	int MinInterval;
+	int MaxInterval;
+	bool IntervalStalls;
+};
+
 class Alu : public TF_Module
 {
 public:
@@ -58,18 +83,25 @@ public:
 	// Provide definition on instances as well as via a static method
 	virtual const SiliconObjectDefinition *Definition() const;
 	static  const SiliconObjectDefinition *BuiltinDefinition();
+	static  const BuiltinObjectTable Table;
 
 	virtual void Print(FILE *f) const;
 
 	AluInstruction *AddInstruction(AluInstruction *inst);
+	int InstructionCount() const;
 	Signal *AddTFA(Signal *dest, const TruthFunction &tf);
 
 	Signal *SignalFromRegisterNumber(int n) const;
 	static const char *RegisterNameFromRegisterNumber(int n);
 
+	// Defined in Alu_Analyze
+	void AnalyzeProgram(AluProgramAnalysis &analysis) const;
+	void PrintProgramAnalysis(FILE *f, const char *prefix) const;
+
 	// Defined in Alu_GenerateVerilog
-	virtual void GenerateVerilog(FILE *f) const;
+	virtual void GenerateVerilog(FILE *f, bool neutralName = false) const;
 	void GenerateVerilogMappingComment(FILE *f) const;
+	void GenerateVerilogProgramComment(FILE *f) const;
 
 protected:
 	// Calls made after parsing module
@@ -108,6 +140,10 @@ private:
 
 	// Singleton instance for built-in special definition, created on-demand
 	static SiliconObjectDefinition *definition;
+
+	// The simulator interprets the resolved program directly
+	friend class AluSimulator;
+	friend class NetlistWriter;
 };
 
 
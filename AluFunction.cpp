@@ -4,8 +4,8 @@
 #include "Common.h"
 
 
-AluFunction::AluFunction(const char *name, const char *args)
-	: Function(name, args)
+AluFunction::AluFunction(const char *name, const char *args, StringBuffer *keyStrings)
+	: Function(name, args, keyStrings)
 {
 }
 
@@ -11,7 +11,7 @@ class SymbolTable;
 class AluFunction : public Function
 {
 public:
-	AluFunction(const char *name, const char *args = NULL);
+	AluFunction(const char *name, const char *args = NULL, StringBuffer *keyStrings = NULL);
 	virtual ~AluFunction();
 
 	virtual SymbolTypeId SymbolType() const { return SYMBOL_ALU_INST; }
@@ -85,6 +85,8 @@ private:
 
 	// Alu class directly manipulates instructions after parsing
 	friend class Alu;
+	friend class AluSimulator;
+	friend class NetlistWriter;
 };
 
 
@@ -0,0 +1,705 @@
+#include "AluSimulator.h"
+#include "AluInstruction.h"
+#include "AluFunction.h"
+#include "Common.h"
+
+#include <string.h>
+#include <string>
+
+
+// Arithmetic of the ALU functions
+enum AluOpcode
+{
+	ALU_OP_ZERO,
+	ALU_OP_MOV,
+	ALU_OP_INV,
+	ALU_OP_INC,         // a + cin, cin defaults to 1
+	ALU_OP_DEC,         // a + 0xFFFF + cin, cin defaults to 0
+	ALU_OP_ADD,         // a + b + cin, cin defaults to 0
+	ALU_OP_SUB,         // a + ~b + cin, cin defaults to 1
+	ALU_OP_AND,
+	ALU_OP_OR,
+	ALU_OP_XOR
+};
+
+// One row per ALU function and argument signature, as declared in Alu::BuiltinDefinition.
+// Word arguments are passed in order as a, b, c.  A bit argument is the carry in.
+//
+// Only functions whose arithmetic is fixed by their name have a row:  moves, bitwise logic, and two's complement
+// add, subtract, increment and decrement.  There is no model of the hardware ALU in this tree to check the others
+// against, such as the shifts, rotates, muxes, compares, averages and the xor-arithmetic forms, so programs using
+// them are rejected rather than run with guessed arithmetic.
+struct AluOperation
+{
+	const char *Name;
+	const char *Args;
+	AluOpcode Opcode;
+	bool StatusIsCarry;     // Status is the carry out, rather than a non-zero result
+};
+
+static const AluOperation operations[] =
+{
+	{ "add",     "ww",   ALU_OP_ADD,     true  },
+	{ "hadd",    "wwb",  ALU_OP_ADD,     true  },
+	{ "and",     "ww",   ALU_OP_AND,     false },
+	{ "and",     "www",  ALU_OP_AND,     false },
+	{ "dec",     "w",    ALU_OP_DEC,     true  },
+	{ "hdec",    "wb",   ALU_OP_DEC,     true  },
+	{ "inc",     "w",    ALU_OP_INC,     true  },
+	{ "hinc",    "wb",   ALU_OP_INC,     true  },
+	{ "inv",     "w",    ALU_OP_INV,     false },
+	{ "mov",     "w",    ALU_OP_MOV,     false },
+	{ "or",      "ww",   ALU_OP_OR,      false },
+	{ "or",      "www",  ALU_OP_OR,      false },
+	{ "sub",     "ww",   ALU_OP_SUB,     true  },
+	{ "xor",     "ww",   ALU_OP_XOR,     false },
+	{ "xor",     "www",  ALU_OP_XOR,     false },
+	{ "zero",    "",     ALU_OP_ZERO,    false },
+	{ NULL,      NULL,   ALU_OP_ZERO,    false }
+};
+
+static const AluOperation *FindOperation(const AluFunction *fcn)
+{
+	string args;
+	for (int i=0; i < fcn->NumArgs(); i++)
+		args += fcn->ArgType(i);
+
+	for (const AluOperation *op = operations; op->Name; op++)
+	{
+		if (strcmp(op->Name, fcn->Name()) == 0 && args == op->Args)
+			return op;
+	}
+	return NULL;
+}
+
+
+AluSimulator::AluSimulator(const Alu *alu)
+	: alu(alu), pc(0), supported(true)
+{
+	Compile();
+	Reset();
+}
+
+const Alu *AluSimulator::Definition() const
+{
+	return alu;
+}
+
+bool AluSimulator::Supported() const
+{
+	return supported;
+}
+
+
+int AluSimulator::Slot(const Signal *sig) const
+{
+	if (!sig)
+		return -1;
+
+	int n = alu->SignalCount();
+	for (int i=0; i < n; i++)
+	{
+		if (alu->GetSignal(i) == sig)
+			return i;
+	}
+
+	const SymbolTable *symbols = Alu::BuiltinDefinition()->Symbols();
+	if (sig == symbols->Get("status"))      return statusSlot;
+	if (sig == symbols->Get("carry"))       return carrySlot;
+	if (sig == symbols->Get("zero"))        return zeroSlot;
+	if (sig == symbols->Get("negative"))    return negativeSlot;
+	if (sig == symbols->Get("overflow"))    return overflowSlot;
+	if (sig == symbols->Get("v_in"))        return vInSlot;
+	if (sig == symbols->Get("warm_reset"))  return warmResetSlot;
+
+	return -1;
+}
+
+int AluSimulator::InputSlot(const char *name) const
+{
+	if (strcmp(name, "v_in") == 0)
+		return vInSlot;
+	if (strcmp(name, "warm_reset") == 0)
+		return warmResetSlot;
+
+	// Resource names
+	int index;
+	char extra;
+	if (sscanf(name, "word%d_in%c", &index, &extra) == 1 && index >= 0 && index < alu->num_word_ins)
+		return Slot(alu->word_ins[index]);
+	if (sscanf(name, "carry%d_in%c", &index, &extra) == 1 && index >= 0 && index < alu->num_carry_ins)
+		return Slot(alu->carry_ins[index]);
+
+	// Wires and delays by name
+	const Signal *sig = alu->GetSignal(name);
+	if (sig && (sig->Behavior == BEHAVIOR_WIRE || sig->Behavior == BEHAVIOR_DELAY))
+		return Slot(sig);
+
+	return -1;
+}
+
+
+unsigned AluSimulator::Value(int slot) const
+{
+	return values[slot];
+}
+
+void AluSimulator::SetInput(int slot, unsigned value)
+{
+	values[slot] = value;
+	driven[slot] = true;
+}
+
+int AluSimulator::InstructionIndex() const
+{
+	return pc;
+}
+
+
+// Builds slots for all signals, and compiles the program, TFA and TF logic to operate on slots
+void AluSimulator::Compile()
+{
+	int n = alu->SignalCount();
+	statusSlot    = n;
+	carrySlot     = n + 1;
+	zeroSlot      = n + 2;
+	negativeSlot  = n + 3;
+	overflowSlot  = n + 4;
+	vInSlot       = n + 5;
+	warmResetSlot = n + 6;
+	numSlots      = n + 7;
+
+	condBypassSlot = Slot(alu->cond_bypass);
+	condUpdateSlot = Slot(alu->cond_update);
+
+	// Latched word_ins are read from a separate slot, captured by instructions which latch them
+	latchSlots.assign(n, -1);
+	for (int i=0; i < alu->num_instructions; i++)
+	{
+		const AluInstruction *inst = alu->instructions[i];
+		for (int j=0; j < inst->num_latches; j++)
+		{
+			int slot = Slot(inst->latches[j]);
+			if (slot >= 0 && slot < n && latchSlots[slot] < 0)
+				latchSlots[slot] = numSlots++;
+		}
+	}
+
+	values.assign(numSlots, 0);
+	driven.assign(numSlots, false);
+
+	// Delays, from the previous tap of a chain or from the base signal
+	for (int i=0; i < n; i++)
+	{
+		const Signal *sig = alu->GetSignal(i);
+		if (sig->Behavior != BEHAVIOR_DELAY || !sig->BaseSignal)
+			continue;
+
+		const Signal *source = sig->DelaySource ? sig->DelaySource : sig->BaseSignal;
+		int delay = sig->DelayCount - (source->Behavior == BEHAVIOR_DELAY ? source->DelayCount : 0);
+
+		DelayLine line;
+		line.Dest = i;
+		line.Source = Slot(source);
+		line.History.assign(delay > 0 ? delay : 1, 0);
+		line.Position = 0;
+		if (line.Source >= 0)
+			delays.push_back(line);
+	}
+
+	// Bit-slices and local connections, ordered so that every source is computed before it is used
+	vector<Derived> unordered;
+	for (int i=0; i < n; i++)
+	{
+		const Signal *sig = alu->GetSignal(i);
+		if (sig->Behavior == BEHAVIOR_BIT_SLICE && sig->BaseSignal)
+		{
+			Derived d;
+			d.Dest = i;
+			d.Source = Slot(sig->BaseSignal);
+			d.BitSlice = sig->BitSliceIndex;
+			if (d.Source >= 0)
+				unordered.push_back(d);
+		}
+	}
+
+	int ncon = alu->ConnectionCount();
+	for (int i=0; i < ncon; i++)
+	{
+		const Connection *c = alu->GetConnection(i);
+		if (c->Source.ResolvedInstance || c->Destination.ResolvedInstance)
+			continue;
+
+		Derived d;
+		d.Dest = Slot(c->Destination.ResolvedSignal);
+		d.Source = Slot(c->Source.ResolvedSignal);
+		d.BitSlice = -1;
+		if (d.Dest >= 0 && d.Source >= 0)
+			unordered.push_back(d);
+	}
+
+	while (!unordered.empty())
+	{
+		size_t before = unordered.size();
+		for (size_t i=0; i < unordered.size(); )
+		{
+			bool ready = true;
+			for (size_t j=0; j < unordered.size(); j++)
+			{
+				if (j != i && unordered[j].Dest == unordered[i].Source)
+					ready = false;
+			}
+
+			if (ready)
+			{
+				derived.push_back(unordered[i]);
+				unordered.erase(unordered.begin() + i);
+			}
+			else
+			{
+				i++;
+			}
+		}
+
+		// Combinational loop:  evaluate the rest in declaration order
+		if (unordered.size() == before)
+		{
+			derived.insert(derived.end(), unordered.begin(), unordered.end());
+			unordered.clear();
+		}
+	}
+
+	// TFA and TF registers
+	for (int i=0; i < alu->num_branches + 2; i++)
+	{
+		const Signal *dest;
+		const TruthFunction *tf;
+		if (i < alu->num_branches)
+		{
+			dest = alu->branches[i];
+			tf = &alu->branch_logic[i];
+		}
+		else if (i == alu->num_branches)
+		{
+			dest = alu->cond_bypass;
+			tf = &alu->cond_bypass_logic;
+		}
+		else
+		{
+			dest = alu->cond_update;
+			tf = &alu->cond_update_logic;
+		}
+
+		if (!dest)
+			continue;
+
+		Logic logic;
+		logic.Dest = Slot(dest);
+		logic.Table = tf->Logic;
+		for (int a=0; a < 4; a++)
+			logic.Args[a] = Slot(tf->Args[a]);
+		tfa.push_back(logic);
+	}
+
+	for (int i=0; i < alu->num_tfs; i++)
+	{
+		Logic logic;
+		logic.Dest = Slot(alu->tf_regs[i]);
+		logic.Table = alu->tf_logic[i].Logic;
+		for (int a=0; a < 4; a++)
+			logic.Args[a] = Slot(alu->tf_logic[i].Args[a]);
+		tfs.push_back(logic);
+	}
+
+	// Instructions
+	for (int i=0; i < alu->num_instructions; i++)
+	{
+		const AluInstruction *inst = alu->instructions[i];
+
+		Operation op;
+		op.Opcode = ALU_OP_ZERO;
+		op.StatusIsCarry = false;
+		op.HasFunction = false;
+		op.NumOperands = 0;
+
+		if (inst->fcn.Fcn)
+		{
+			const AluOperation *operation = FindOperation(inst->fcn.Fcn);
+			if (operation)
+			{
+				op.Opcode = operation->Opcode;
+				op.StatusIsCarry = operation->StatusIsCarry;
+				op.HasFunction = true;
+			}
+			else
+			{
+				yyerrorfl(inst->Location, "ALU function '%s' has no verified model, so ALU '%s' cannot be simulated", inst->fcn.Fcn->Name(), alu->Name());
+				supported = false;
+			}
+
+			op.NumOperands = inst->fcn.Fcn->NumArgs();
+			for (int a=0; a < op.NumOperands; a++)
+			{
+				char type = inst->fcn.Fcn->ArgType(a);
+				op.WordOperand[a] = (type != 'b');
+				if (type == 'k')
+				{
+					op.Operands[a] = -1;
+					op.Immediates[a] = inst->fcn.Args[a].i;
+				}
+				else
+				{
+					int slot = Slot(inst->fcn.Args[a].sig);
+					if (slot >= 0 && slot < n && latchSlots[slot] >= 0)
+						slot = latchSlots[slot];
+					op.Operands[a] = slot;
+					op.Immediates[a] = 0;
+				}
+			}
+		}
+
+		for (int d=0; d < inst->num_dests; d++)
+		{
+			const Signal *dest = inst->dests[d];
+			int regnum = dest->RegisterNumber;
+			if (regnum >= ALU_TF_REG_OFFSET && regnum < ALU_TF_REG_OFFSET + MAX_TFS)
+				op.TFDests.push_back(regnum - ALU_TF_REG_OFFSET);
+			else if (Slot(dest) >= 0)
+				op.WordDests.push_back(Slot(dest));
+		}
+
+		for (int t=0; t < inst->num_tf_overrides; t++)
+		{
+			op.TFOverrides.push_back(inst->tf_overrides[t]->RegisterNumber - ALU_TF_REG_OFFSET);
+			op.TFOverrideValues.push_back(inst->tf_override_values[t]);
+		}
+
+		for (int l=0; l < inst->num_latches; l++)
+		{
+			int slot = Slot(inst->latches[l]);
+			if (slot >= 0 && slot < n && latchSlots[slot] >= 0)
+				op.Latches.push_back(make_pair(slot, latchSlots[slot]));
+		}
+
+		for (int b=0; b < 2; b++)
+			op.BranchConds[b] = Slot(inst->branch_conds[b]);
+		for (int b=0; b < 4; b++)
+			op.Next[b] = (inst->branch_indexes[b] >= 0) ? inst->branch_indexes[b] : 0;
+
+		op.CondBypass = inst->cond_bypass > 0;
+		op.CondUpdateVR = inst->cond_update_vr > 0;
+		op.CondUpdateTF = inst->cond_update_tf > 0;
+		op.WaitForV = inst->wait_for_v > 0;
+		op.VOut = inst->v_out;
+
+		program.push_back(op);
+	}
+}
+
+
+void AluSimulator::Reset()
+{
+	int n = alu->SignalCount();
+	for (int i=0; i < numSlots; i++)
+	{
+		if (driven[i])
+			continue;
+
+		values[i] = 0;
+		if (i < n)
+		{
+			const Signal *sig = alu->GetSignal(i);
+			if ((sig->Behavior == BEHAVIOR_REG || sig->Behavior == BEHAVIOR_CONST) && sig->InitialValue >= 0)
+				values[i] = sig->DataType == DATA_TYPE_BIT ? (sig->InitialValue & 1) : (sig->InitialValue & 0x1FFFF);
+		}
+	}
+
+	for (size_t i=0; i < delays.size(); i++)
+	{
+		delays[i].History.assign(delays[i].History.size(), 0);
+		delays[i].Position = 0;
+	}
+
+	pc = 0;
+}
+
+
+int AluSimulator::EvaluateLogic(const Logic &logic) const
+{
+	int index = 0;
+	for (int a=0; a < 4; a++)
+	{
+		if (logic.Args[a] >= 0 && (values[logic.Args[a]] & 1))
+			index |= 1 << a;
+	}
+	return (logic.Table >> index) & 1;
+}
+
+
+void AluSimulator::Evaluate()
+{
+	for (size_t i=0; i < delays.size(); i++)
+	{
+		const DelayLine &line = delays[i];
+		if (!driven[line.Dest])
+			values[line.Dest] = line.History[line.Position];
+	}
+
+	for (size_t i=0; i < derived.size(); i++)
+	{
+		const Derived &d = derived[i];
+		if (driven[d.Dest])
+			continue;
+
+		if (d.BitSlice >= 0)
+			values[d.Dest] = (values[d.Source] >> d.BitSlice) & 1;
+		else
+			values[d.Dest] = values[d.Source];
+	}
+
+	for (size_t i=0; i < tfa.size(); i++)
+		values[tfa[i].Dest] = EvaluateLogic(tfa[i]);
+}
+
+
+// Computes the 16-bit result of an operation
+unsigned AluSimulator::Execute(const Operation &op, unsigned operands[4], bool &carry, bool &overflow, bool &status) const
+{
+	// Word and immediate operands in order as a, b, c, and a bit operand as the carry in
+	unsigned w[4] = {0, 0, 0, 0};
+	int nw = 0;
+	int cin = -1;
+	for (int i=0; i < op.NumOperands; i++)
+	{
+		if (op.WordOperand[i])
+			w[nw++] = operands[i] & 0xFFFF;
+		else
+			cin = operands[i] & 1;
+	}
+
+	unsigned x = 0, y = 0;
+	int cinDefault = 0;
+	bool arithmetic = true;
+	unsigned result = 0;
+	carry = false;
+	overflow = false;
+
+	switch (op.Opcode)
+	{
+		case ALU_OP_ADD:     x = w[0];         y = w[1];               cinDefault = 0;  break;
+		case ALU_OP_SUB:     x = w[0];         y = ~w[1] & 0xFFFF;     cinDefault = 1;  break;
+		case ALU_OP_INC:     x = w[0];         y = 0;                  cinDefault = 1;  break;
+		case ALU_OP_DEC:     x = w[0];         y = 0xFFFF;             cinDefault = 0;  break;
+
+		default:
+			arithmetic = false;
+			break;
+	}
+
+	if (arithmetic)
+	{
+		unsigned sum = x + y + (cin >= 0 ? cin : cinDefault);
+		carry = (sum >> 16) & 1;
+		overflow = ((x ^ sum) & (y ^ sum) & 0x8000) != 0;
+		result = sum;
+	}
+	else
+	{
+		switch (op.Opcode)
+		{
+			case ALU_OP_ZERO:   result = 0;                                     break;
+			case ALU_OP_MOV:    result = w[0];                                  break;
+			case ALU_OP_INV:    result = ~w[0];                                 break;
+			case ALU_OP_AND:    result = w[0] & w[1] & (nw > 2 ? w[2] : 0xFFFF);  break;
+			case ALU_OP_OR:     result = w[0] | w[1] | w[2];                    break;
+			case ALU_OP_XOR:    result = w[0] ^ w[1] ^ w[2];                    break;
+		}
+	}
+
+	result &= 0xFFFF;
+
+	if (op.StatusIsCarry)
+		status = carry;
+	else
+		status = result != 0;
+
+	return result;
+}
+
+
+void AluSimulator::Clock()
+{
+	if (program.empty())
+		return;
+
+	const Operation &op = program[pc];
+
+	// Warm reset restores registers which use it, and restarts the program
+	if (values[warmResetSlot] & 1)
+	{
+		int n = alu->SignalCount();
+		for (int i=0; i < n; i++)
+		{
+			const Signal *sig = alu->GetSignal(i);
+			if (sig->UsesWarmReset && sig->Behavior == BEHAVIOR_REG && !driven[i])
+				values[i] = sig->InitialValue >= 0 ? (sig->InitialValue & 0x1FFFF) : 0;
+		}
+		pc = 0;
+	}
+
+	// Stall until v_in is set
+	else if (!op.WaitForV || (values[vInSlot] & 1))
+	{
+		unsigned operands[4];
+		for (int a=0; a < op.NumOperands; a++)
+			operands[a] = op.Operands[a] >= 0 ? values[op.Operands[a]] : (unsigned) op.Immediates[a];
+
+		bool carry = false, overflow = false, status = false;
+		unsigned result = op.HasFunction ? Execute(op, operands, carry, overflow, status) : 0;
+
+		bool update = condUpdateSlot >= 0 && (values[condUpdateSlot] & 1);
+		bool bypass = op.CondBypass && condBypassSlot >= 0 && (values[condBypassSlot] & 1);
+		bool updateVR = !op.CondUpdateVR || update;
+		bool updateTF = !op.CondUpdateTF || update;
+
+		// TF registers all take their next values together
+		unsigned next[MAX_TFS];
+		for (size_t t=0; t < tfs.size(); t++)
+			next[t] = EvaluateLogic(tfs[t]);
+		for (size_t t=0; t < op.TFDests.size(); t++)
+			next[op.TFDests[t]] = result & 1;
+		for (size_t t=0; t < op.TFOverrides.size(); t++)
+			next[op.TFOverrides[t]] = op.TFOverrideValues[t];
+		if (updateTF && !bypass)
+		{
+			for (size_t t=0; t < tfs.size(); t++)
+				values[tfs[t].Dest] = next[t];
+		}
+
+		// Word registers, with the v-bit from v_out
+		if (updateVR && !bypass && op.HasFunction)
+		{
+			for (size_t d=0; d < op.WordDests.size(); d++)
+			{
+				int slot = op.WordDests[d];
+				unsigned v = 0;
+				switch (op.VOut)
+				{
+					case 1:  v = 1;                              break;
+					case 2:  v = values[vInSlot] & 1;            break;
+					case 3:  v = (values[slot] >> 16) & 1;       break;
+				}
+				values[slot] = result | (v << 16);
+			}
+		}
+
+		for (size_t l=0; l < op.Latches.size(); l++)
+			values[op.Latches[l].second] = values[op.Latches[l].first];
+
+		if (op.HasFunction)
+		{
+			values[statusSlot]   = status;
+			values[carrySlot]    = carry;
+			values[zeroSlot]     = result == 0;
+			values[negativeSlot] = (result >> 15) & 1;
+			values[overflowSlot] = overflow;
+		}
+
+		int b0 = op.BranchConds[0] >= 0 ? (values[op.BranchConds[0]] & 1) : 0;
+		int b1 = op.BranchConds[1] >= 0 ? (values[op.BranchConds[1]] & 1) : 0;
+		pc = op.Next[b0 + 2*b1];
+	}
+
+	// Delay lines move on every cycle
+	for (size_t i=0; i < delays.size(); i++)
+	{
+		DelayLine &line = delays[i];
+		line.History[line.Position] = values[line.Source];
+		line.Position = (line.Position + 1) % line.History.size();
+	}
+}
+
+
+// Traced signals are ports and registers
+static bool Traced(const Signal *sig)
+{
+	return sig->Direction == DIR_IN || sig->Direction == DIR_OUT || sig->Behavior == BEHAVIOR_REG;
+}
+
+void AluSimulator::TraceHeader(FILE *f) const
+{
+	fprintf(f, "# Words are 17-bit hexadecimal, with the v-bit as the leading digit\n");
+	fprintf(f, "cycle\tinst");
+
+	int n = alu->SignalCount();
+	for (int i=0; i < n; i++)
+	{
+		const Signal *sig = alu->GetSignal(i);
+		if (Traced(sig))
+			fprintf(f, "\t%s", sig->Name());
+	}
+	fprintf(f, "\tstatus\tcarry\n");
+}
+
+void AluSimulator::TraceCycle(FILE *f, int cycle) const
+{
+	fprintf(f, "%d\t%d", cycle, pc);
+
+	int n = alu->SignalCount();
+	for (int i=0; i < n; i++)
+	{
+		const Signal *sig = alu->GetSignal(i);
+		if (!Traced(sig))
+			continue;
+
+		if (sig->DataType == DATA_TYPE_BIT)
+			fprintf(f, "\t%u", values[i] & 1);
+		else
+			fprintf(f, "\t%05X", values[i] & 0x1FFFF);
+	}
+	fprintf(f, "\t%u\t%u\n", values[statusSlot] & 1, values[carrySlot] & 1);
+}
+
+
+bool AluSimulator::Run(const Stimulus &stimulus, int cycles, FILE *trace)
+{
+	// Functions without a model were reported when the program was compiled
+	if (!supported)
+		return false;
+
+	// Bind stimulus columns to inputs
+	vector<int> slots;
+	bool ok = true;
+	for (int c=0; c < stimulus.Columns(); c++)
+	{
+		int slot = InputSlot(stimulus.ColumnName(c));
+		if (slot < 0)
+		{
+			yyerrorfl(FileLocation(stimulus.Filename()), "Stimulus column '%s' is not an input of ALU '%s'", stimulus.ColumnName(c), alu->Name());
+			ok = false;
+		}
+		slots.push_back(slot);
+	}
+	if (!ok)
+		return false;
+
+	for (size_t c=0; c < slots.size(); c++)
+		driven[slots[c]] = true;
+	Reset();
+
+	if (trace)
+		TraceHeader(trace);
+
+	for (int cycle = 0; cycle < cycles; cycle++)
+	{
+		for (size_t c=0; c < slots.size(); c++)
+			values[slots[c]] = stimulus.Value(cycle, c) & 0x1FFFF;
+
+		Evaluate();
+		if (trace)
+			TraceCycle(trace, cycle);
+		Clock();
+	}
+
+	return true;
+}
@@ -0,0 +1,140 @@
+#ifndef ALU_SIMULATOR_H
+#define ALU_SIMULATOR_H
+
+#include "Alu.h"
+#include "Stimulus.h"
+
+#include <stdio.h>
+#include <vector>
+using namespace std;
+
+
+// Cycle-by-cycle interpreter for the program of one ALU, used to test ALU programs without Verilog simulation.
+//
+// Every signal of the ALU is given a slot holding its current value:  words are 17 bits with the v-bit in bit 16,
+// and bits are 0 or 1.  Each cycle, the inputs are set, Evaluate computes delays, bit-slices, local connections
+// and the TFA, and Clock executes the current instruction:  the function result is written to the destination
+// word registers, every TF register takes the value of its truth function, the flags are updated,
+// and the next instruction is chosen from the branch conditions.
+//
+// The arithmetic of the ALU functions is defined by a table in AluSimulator.cpp.  It only has the functions whose
+// arithmetic is fixed by their name, and a program using any other function is reported as an error, and not run.
+class AluSimulator
+{
+public:
+	AluSimulator(const Alu *alu);
+
+	const Alu *Definition() const;
+
+	// False if the program uses an ALU function without a model, which was reported as an error
+	bool Supported() const;
+
+	// Slot of a signal of the ALU, including the built-in status, flag, v_in and warm_reset signals.
+	// Returns -1 if the signal does not belong to the ALU.
+	int Slot(const Signal *sig) const;
+
+	// Slot of an input by signal name, or by resource name such as word0_in or carry1_in.  Returns -1 if not found.
+	int InputSlot(const char *name) const;
+
+	unsigned Value(int slot) const;
+
+	// Drives an input each cycle.  Driven slots are not overwritten by connections or delays within the ALU.
+	void SetInput(int slot, unsigned value);
+
+	// Returns registers, flags and delays to their initial values, and restarts the program
+	void Reset();
+
+	// Computes the values of delayed, bit-sliced and connected signals and the TFA, from the inputs and registers
+	void Evaluate();
+
+	// Executes the current instruction, after Evaluate
+	void Clock();
+
+	// Current instruction index
+	int InstructionIndex() const;
+
+	// Runs the program for a number of cycles, with inputs from the stimulus columns, tracing one line per cycle.
+	// Returns false, after reporting errors, if a stimulus column does not name an input, or if not Supported.
+	bool Run(const Stimulus &stimulus, int cycles, FILE *trace);
+
+private:
+	// Compiled form of an ALU instruction, with operands as slots
+	struct Operation
+	{
+		int Opcode;
+		bool StatusIsCarry;
+		bool HasFunction;
+		int Operands[4];            // Slots of word and bit arguments, or -1 for an immediate
+		int Immediates[4];
+		bool WordOperand[4];
+		int NumOperands;
+
+		vector<int> WordDests;      // Slots of destination word registers
+		vector<int> TFDests;        // Indexes of destination TF registers, written with bit 0 of the result
+		vector<int> TFOverrides;    // Indexes of TF registers forced to a value
+		vector<int> TFOverrideValues;
+		vector<pair<int,int> > Latches;     // Live word_in slot, and the slot holding its latched value
+
+		int BranchConds[2];         // Slots of the branch conditions, or -1
+		int Next[4];
+		bool CondBypass;
+		bool CondUpdateVR;
+		bool CondUpdateTF;
+		bool WaitForV;
+		int VOut;
+	};
+
+	// Compiled truth function, with arguments as slots
+	struct Logic
+	{
+		int Dest;
+		int Args[4];
+		int Table;
+	};
+
+	// Signal computed from another signal within a cycle
+	struct Derived
+	{
+		int Dest;
+		int Source;
+		int BitSlice;               // -1 for a copy
+	};
+
+	// Delayed signal, with a ring of past values of its source
+	struct DelayLine
+	{
+		int Dest;
+		int Source;
+		vector<unsigned> History;
+		int Position;
+	};
+
+	void Compile();
+	int EvaluateLogic(const Logic &logic) const;
+	unsigned Execute(const Operation &op, unsigned operands[4], bool &carry, bool &overflow, bool &status) const;
+	void TraceHeader(FILE *f) const;
+	void TraceCycle(FILE *f, int cycle) const;
+
+	const Alu *alu;
+
+	vector<unsigned> values;
+	vector<bool> driven;
+	int numSlots;
+
+	// Slots of built-in signals
+	int statusSlot, carrySlot, zeroSlot, negativeSlot, overflowSlot, vInSlot, warmResetSlot;
+	int condBypassSlot, condUpdateSlot;
+
+	vector<Operation> program;
+	vector<Logic> tfa;              // Branch, cond_bypass and cond_update logic, evaluated each cycle
+	vector<Logic> tfs;              // TF register logic, clocked each cycle
+	vector<Derived> derived;        // In evaluation order
+	vector<DelayLine> delays;
+	vector<int> latchSlots;         // Slots holding latched word_ins, indexed by signal index
+
+	int pc;
+	bool supported;
+};
+
+
+#endif
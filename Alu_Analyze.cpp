@@ -0,0 +1,179 @@
+#include "Alu.h"
+#include "AluInstruction.h"
+#include "Common.h"
+
+
+// Returns the distinct instructions which may follow an instruction, as a bit mask
+static unsigned Successors(const int branch_indexes[4], int num_instructions)
+{
+	unsigned next = 0;
+	for (int b=0; b < 4; b++)
+	{
+		if (branch_indexes[b] >= 0 && branch_indexes[b] < num_instructions)
+			next |= 1u << branch_indexes[b];
+	}
+	return next;
+}
+
+// Finds the shortest and longest simple cycles through start, visiting only members above start.
+// Every simple cycle in a loop is found exactly once, from its lowest instruction.
+static void FindCycles(const unsigned next[], int start, int i, unsigned members, unsigned visited, int length, int &minCycles, int &maxCycles)
+{
+	for (int j=0; j < MAX_ALU_INSTRUCTIONS; j++)
+	{
+		if (!(next[i] & (1u << j)))
+			continue;
+
+		if (j == start)
+		{
+			if (minCycles < 0 || length < minCycles)
+				minCycles = length;
+			if (length > maxCycles)
+				maxCycles = length;
+		}
+		else if (j > start && (members & (1u << j)) && !(visited & (1u << j)))
+		{
+			FindCycles(next, start, j, members, visited | (1u << j), length + 1, minCycles, maxCycles);
+		}
+	}
+}
+
+
+// Builds the instruction control-flow graph, and finds unreachable instructions, loops,
+// and the steady-state initiation interval of the program
+void Alu::AnalyzeProgram(AluProgramAnalysis &analysis) const
+{
+	int n = num_instructions;
+	analysis.NumInstructions = n;
+	analysis.Loops.clear();
+	analysis.HasInterval = false;
+	analysis.MinInterval = 0;
+	analysis.MaxInterval = 0;
+	analysis.IntervalStalls = false;
+
+	// Edges, and transitive closure of paths of one or more instructions
+	unsigned next[MAX_ALU_INSTRUCTIONS];
+	unsigned reach[MAX_ALU_INSTRUCTIONS];
+	for (int i=0; i < MAX_ALU_INSTRUCTIONS; i++)
+	{
+		next[i] = (i < n) ? Successors(instructions[i]->branch_indexes, n) : 0;
+		reach[i] = next[i];
+		analysis.WaitsForV[i] = (i < n) && instructions[i]->wait_for_v > 0;
+	}
+
+	for (int k=0; k < n; k++)
+	{
+		for (int i=0; i < n; i++)
+		{
+			if (reach[i] & (1u << k))
+				reach[i] |= reach[k];
+		}
+	}
+
+	// Execution starts at the first instruction
+	for (int i=0; i < MAX_ALU_INSTRUCTIONS; i++)
+		analysis.Reachable[i] = (i == 0 && n > 0) || (n > 0 && (reach[0] & (1u << i)));
+
+	// Each instruction on a cycle belongs to the loop of all instructions it reaches and is reached from
+	unsigned assigned = 0;
+	for (int i=0; i < n; i++)
+	{
+		if ((assigned & (1u << i)) || !(reach[i] & (1u << i)))
+			continue;
+
+		AluLoop loop;
+		loop.Members = 0;
+		for (int j=0; j < n; j++)
+		{
+			if ((reach[i] & (1u << j)) && (reach[j] & (1u << i)))
+				loop.Members |= 1u << j;
+		}
+		assigned |= loop.Members;
+
+		loop.MinCycles = -1;
+		loop.MaxCycles = 0;
+		loop.Stalls = false;
+		loop.Steady = true;
+		for (int j=0; j < n; j++)
+		{
+			if (!(loop.Members & (1u << j)))
+				continue;
+
+			FindCycles(next, j, j, loop.Members, 1u << j, 1, loop.MinCycles, loop.MaxCycles);
+
+			if (analysis.WaitsForV[j])
+				loop.Stalls = true;
+			if (next[j] & ~loop.Members)
+				loop.Steady = false;
+		}
+
+		analysis.Loops.push_back(loop);
+
+		// Reachable loops with no way out determine the steady-state rate of the program
+		if (loop.Steady && analysis.Reachable[i])
+		{
+			if (!analysis.HasInterval || loop.MinCycles < analysis.MinInterval)
+				analysis.MinInterval = loop.MinCycles;
+			if (!analysis.HasInterval || loop.MaxCycles > analysis.MaxInterval)
+				analysis.MaxInterval = loop.MaxCycles;
+			if (loop.Stalls)
+				analysis.IntervalStalls = true;
+			analysis.HasInterval = true;
+		}
+	}
+}
+
+
+// Prints the program analysis, one finding per line, each line starting with prefix
+void Alu::PrintProgramAnalysis(FILE *f, const char *prefix) const
+{
+	AluProgramAnalysis analysis;
+	AnalyzeProgram(analysis);
+
+	if (analysis.NumInstructions == 0)
+		return;
+
+	for (int i=0; i < analysis.NumInstructions; i++)
+	{
+		const char *label = instructions[i]->Label() ? instructions[i]->Label() : "";
+
+		if (!analysis.Reachable[i])
+			fprintf(f, "%sinstruction %d '%s' is unreachable\n", prefix, i, label);
+		else if (analysis.WaitsForV[i])
+			fprintf(f, "%sinstruction %d '%s' stalls until v_in is set (wait_for_v)\n", prefix, i, label);
+	}
+
+	for (size_t l=0; l < analysis.Loops.size(); l++)
+	{
+		const AluLoop &loop = analysis.Loops[l];
+
+		fprintf(f, "%sloop", prefix);
+		const char *sep = " ";
+		for (int i=0; i < analysis.NumInstructions; i++)
+		{
+			if (loop.Members & (1u << i))
+			{
+				fprintf(f, "%s%d", sep, i);
+				sep = ",";
+			}
+		}
+
+		if (loop.MinCycles == loop.MaxCycles)
+			fprintf(f, ": %d cycle(s) per iteration", loop.MinCycles);
+		else
+			fprintf(f, ": %d to %d cycles per iteration", loop.MinCycles, loop.MaxCycles);
+
+		if (loop.Stalls)
+			fprintf(f, ", plus wait_for_v stalls");
+		if (!loop.Steady)
+			fprintf(f, ", may exit");
+		fprintf(f, "\n");
+	}
+
+	if (!analysis.HasInterval)
+		fprintf(f, "%sinitiation interval: none (no steady-state loop)\n", prefix);
+	else if (analysis.MinInterval == analysis.MaxInterval)
+		fprintf(f, "%sinitiation interval: %d cycle(s)%s\n", prefix, analysis.MinInterval, analysis.IntervalStalls ? " or more (wait_for_v)" : "");
+	else
+		fprintf(f, "%sinitiation interval: %d to %d cycles%s\n", prefix, analysis.MinInterval, analysis.MaxInterval, analysis.IntervalStalls ? " or more (wait_for_v)" : "");
+}
@@ -3,8 +3,6 @@
 #include "AluInstruction.h"
 #include "Common.h"
 
-#define TF_STRING_BUFFER_LENGTH     (1024)
-
 // Returns a string such as "word0_reg", "word2_in", "tf0_reg", "add_carry", or even just "1"
 static const char *ToInstructionString(Signal *sig)
 {
@@ -41,6 +39,20 @@ static const char *ToInstructionString(Signal *sig)
 }
 
 
+// Generates an assign of a truth function, with its logic and arguments in a trailing comment,
+// such as "assign Clock$_next = ~Clock;  // TF 0x5555 Clock", so the generated file can be checked with --check-tf
+static void GenerateVerilogTF(FILE *f, const char *name, const char *suffix, const TruthFunction *tf)
+{
+	const char *tf_expr = tf->ToVerilogExpression();
+	F4("\tassign %s%s = %s;\t\t// TF 0x%04X", name, suffix, tf_expr, tf->Logic);
+
+	int nargs = tf->NumArgs();
+	for (int i=0; i < nargs; i++)
+		F1(" %s", tf->Args[i]->Name());
+	F0("\n");
+}
+
+
 // Generate a Verilog comment that contains
 // the signal-to-resource mapping, such as Count -> word0_reg
 void Alu::GenerateVerilogMappingComment(FILE *f) const
@@ -64,16 +76,28 @@ void Alu::GenerateVerilogMappingComment(FILE *f) const
 	F0("//\n");
 }
 
+// Generate a Verilog comment that describes the cycle behavior of the program,
+// such as loops, the initiation interval, and unreachable instructions
+void Alu::GenerateVerilogProgramComment(FILE *f) const
+{
+	if (num_instructions == 0)
+		return;
+
+	PrintProgramAnalysis(f, "// ");
+	F0("//\n");
+}
+
 
-void Alu::GenerateVerilog(FILE *f) const
+void Alu::GenerateVerilog(FILE *f, bool neutralName) const
 {
 	F0("\n");
 
 	F0("//\n");
-	F2("// ================ %s - %s ================\n", ModuleTypeName(), Name());
+	F2("// ================ %s - %s ================\n", ModuleTypeName(), VerilogLocalName(neutralName));
 	F0("//\n");
 
 	GenerateVerilogMappingComment(f);
+	GenerateVerilogProgramComment(f);
 
 	int n = SignalCount();
 
@@ -84,7 +108,7 @@ void Alu::GenerateVerilog(FILE *f) const
 	// );
 
 	F0("module ");
-	GenerateVerilogModuleName(f);
+	GenerateVerilogModuleName(f, neutralName);
 	F0(" (");
 
 	bool first = true;
@@ -133,7 +157,7 @@ void Alu::GenerateVerilog(FILE *f) const
 	F0("\twire          overflow;\n");
 
 	// Wire up a port to view the current ALU state
-	F1("\n\twire   [2:0]  instruction = %s.current_state;\n", Name());
+	F1("\n\twire   [2:0]  instruction = %s.current_state;\n", VerilogLocalName(neutralName));
 	F0("\n");
 
 	// Named constants that do not connect directly to the word_reg outputs
@@ -153,13 +177,9 @@ void Alu::GenerateVerilog(FILE *f) const
 
 	// TFA branch logic
 	// assign BranchCond0 = ~BitReg3 & BitWire2;
-	char tf_str_buf[TF_STRING_BUFFER_LENGTH];
 	for (int i=0; i < num_branches; i++)
 	{
-		const Signal *sig = branches[i];
-		const TruthFunction *tf = &branch_logic[i];
-		const char *tf_expr = tf->ToVerilogExpression(tf_str_buf, TF_STRING_BUFFER_LENGTH);
-		F2("\tassign %s = %s;\n", sig->Name(), tf_expr);
+		GenerateVerilogTF(f, branches[i]->Name(), "", &branch_logic[i]);
 	}
 
 
@@ -176,8 +196,7 @@ void Alu::GenerateVerilog(FILE *f) const
 			const Signal *sig = tf_regs[i];
 			if (!tf->IsFalse() && !tf->IsTrue() && !tf->IsHold(sig))
 			{
-				const char *tf_expr = tf->ToVerilogExpression(tf_str_buf, TF_STRING_BUFFER_LENGTH);
-				F2("\tassign %s$_next = %s;\n", sig->Name(), tf_expr);
+				GenerateVerilogTF(f, sig->Name(), "$_next", tf);
 			}
 		}
 	}
@@ -398,7 +417,7 @@ void Alu::GenerateVerilog(FILE *f) const
 
 	// ModuleName
 	// (
-	F1("%s\n", Name());
+	F1("%s\n", VerilogLocalName(neutralName));
 	F0("\t(\n");
 
 
@@ -27,6 +27,28 @@ SourceCodeLocation CurrentLocation()
 	return loc;
 }
 
+SourceCodeLocation FileLocation(const char *filename)
+{
+	SourceCodeLocation loc;
+	loc.Filename = filename;
+	loc.Line = 0;
+	return loc;
+}
+
+
+// Writes the start of a diagnostic, without a line for a FileLocation
+static void WriteDiagnosticPrefix(const char *severity, SourceCodeLocation loc)
+{
+	if (loc.Line <= 0 && loc.Filename)
+		fprintf(stderr, "%s in %s: ", severity, loc.Filename);
+	else if (loc.Line <= 0)
+		fprintf(stderr, "%s - ", severity);
+	else if (loc.Filename)
+		fprintf(stderr, "%s in %s on line %d: ", severity, loc.Filename, loc.Line);
+	else
+		fprintf(stderr, "%s on line %d: ", severity, loc.Line);
+}
+
 
 // Error handlers
 void yyerror(const char *str)
@@ -60,16 +82,30 @@ void yyerrorfv(const char *str, va_list args)
 	yyerrorflv(CurrentLocation(), str, args);
 }
 
+// Passes a diagnostic to the handler, if one is set
+static bool HandleDiagnostic(DiagnosticSeverity severity, SourceCodeLocation loc, const char *str, va_list args)
+{
+	if (!diagnosticHandler)
+		return false;
+
+	char message[1024];
+	vsnprintf(message, sizeof(message), str, args);
+	diagnosticHandler(severity, loc, str, message);
+	return true;
+}
+
+DiagnosticHandler diagnosticHandler = NULL;
+
+
 void yyerrorflv(SourceCodeLocation loc, const char *str, va_list args)
 {
-	if (loc.Filename)
-		fprintf(stderr, "ERROR in %s on line %d: ", loc.Filename, loc.Line);
-	else
-		fprintf(stderr, "ERROR on line %d: ", loc.Line);
+	errorCount++;
+	if (HandleDiagnostic(DIAGNOSTIC_ERROR, loc, str, args))
+		return;
+
+	WriteDiagnosticPrefix("ERROR", loc);
 	vfprintf(stderr, str, args);
 	fprintf(stderr, "\n");
-
-	errorCount++;
 }
 
 int errorCount = 0;
@@ -121,22 +157,22 @@ void yywarnflv(SourceCodeLocation loc, const char *str, va_list args)
 	}
 	else
 	{
+		warnCount++;
+		if (HandleDiagnostic(DIAGNOSTIC_WARNING, loc, str, args))
+			return;
+
 #ifndef TEST_COMMON
-		if (loc.Filename)
-			fprintf(stderr, "WARNING in %s on line %d: ", loc.Filename, loc.Line);
-		else
-			fprintf(stderr, "WARNING on line %d: ", loc.Line);
+		WriteDiagnosticPrefix("WARNING", loc);
 #else
 		fprintf(stderr, "WARNING: ");
 #endif
 		vfprintf(stderr, str, args);
 		fprintf(stderr, "\n");
-
-		warnCount++;
 	}
 }
 
 int warnCount = 0;
+bool warnAsError = false;
 
 
 
@@ -173,18 +209,17 @@ void yyfatalfv(const char *str, va_list args)
 
 void yyfatalflv(SourceCodeLocation loc, const char *str, va_list args)
 {
+	fatalCount++;
+	if (HandleDiagnostic(DIAGNOSTIC_FATAL, loc, str, args))
+		return;
+
 #ifndef TEST_COMMON
-	if (loc.Filename)
-		fprintf(stderr, "FATAL in %s on line %d: ", loc.Filename, loc.Line);
-	else
-		fprintf(stderr, "FATAL on line %d: ", loc.Line);
+	WriteDiagnosticPrefix("FATAL", loc);
 #else
 		fprintf(stderr, "WARNING: ");
 #endif
 	vfprintf(stderr, str, args);
 	fprintf(stderr, "\n");
-
-	fatalCount++;
 }
 
 
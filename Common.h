@@ -37,6 +37,9 @@ struct SourceCodeLocation
 // Return current location
 extern SourceCodeLocation CurrentLocation();
 
+// Location of a whole file, or of nothing if filename is NULL, for diagnostics not about one line
+extern SourceCodeLocation FileLocation(const char *filename);
+
 
 /*
  * Dynamic string buffer used during parse
@@ -69,6 +72,21 @@ extern int fatalCount;
 
 extern bool warnAsError;
 
+/*
+ * When set, errors, warnings and fatal errors are passed to the handler, formatted without their location,
+ * instead of being written to stderr.  They are still counted.  The kind is the unformatted format string,
+ * which is the same for every diagnostic of one kind.
+ */
+enum DiagnosticSeverity
+{
+	DIAGNOSTIC_WARNING,
+	DIAGNOSTIC_ERROR,
+	DIAGNOSTIC_FATAL,
+};
+
+typedef void (*DiagnosticHandler)(DiagnosticSeverity severity, SourceCodeLocation loc, const char *kind, const char *message);
+extern DiagnosticHandler diagnosticHandler;
+
 extern int yydebug;
 
 extern const char *currentFilename;
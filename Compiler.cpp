@@ -0,0 +1,516 @@
+/*
+ *  Compiler passes, and the compiler library interface
+ */
+
+#include "Compiler.h"
+#include "DeadLogic.h"
+#include "Diagnostics.h"
+#include "NetlistWriter.h"
+#include "SiliconObjectRegistry.h"
+#include "Trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <map>
+#include <algorithm>
+
+
+// Version Information
+const char *oasm2verilog_version = "0.3";
+
+
+
+/*
+ *  Passes over all top-level modules
+ */
+
+bool ResolveInstances()
+{
+	TraceSpan span("ResolveInstances pass");
+
+	bool ok = true;
+	for (int i=0; i < modules.Count(); i++)
+	{
+		Module *module = (Module *) modules.Get(i);
+		if (!module->ResolveInstances())
+			ok = false;
+	}
+	return ok;
+}
+
+
+bool ResolveConnections()
+{
+	TraceSpan span("ResolveConnections pass");
+
+	bool ok = true;
+	for (int i=0; i < modules.Count(); i++)
+	{
+		Module *module = (Module *) modules.Get(i);
+		if (!module->ResolveConnections())
+			ok = false;
+	}
+	return ok;
+}
+
+
+int ShareEquivalentDefinitions()
+{
+	// Signatures are shared across all top-level modules, so identical inner definitions
+	// in different modules also use a single Verilog module
+	Module::SignatureMap signatures;
+
+	int nshared = 0;
+	for (int i=0; i < modules.Count(); i++)
+	{
+		Module *module = (Module *) modules.Get(i);
+		if (!module->IsExtern())
+			nshared += module->ShareEquivalentDefinitions(signatures);
+	}
+	return nshared;
+}
+
+
+void BuildDelayChains()
+{
+	TraceSpan span("BuildDelayChains pass");
+
+	for (int i=0; i < modules.Count(); i++)
+	{
+		Module *module = (Module *) modules.Get(i);
+		if (!module->IsExtern())
+			module->BuildDelayChains();
+	}
+}
+
+
+void DeleteModules()
+{
+	for (int i=0; i < modules.Count(); i++)
+	{
+		Module *module = (Module *) modules.Get(i);
+		delete module;  module = NULL;
+	}
+	modules.Clear();
+}
+
+
+// Generate embedded OASM section in hot comments, declaring the interfaces of all top-level modules
+void GenerateVerilogEmbeddedOasm(FILE *f)
+{
+	int n = modules.Count();
+
+	fprintf(f, "//+++EMBEDDED_OASM+++\n");
+	for (int i=0; i < n; i++)
+	{
+		Module *module = (Module *) modules.Get(i);
+
+		// Skip extern modules
+		if (!module->IsExtern())
+		{
+			module->GenerateVerilogEmbeddedExtern(f, true);
+		}
+	}
+	fprintf(f, "//+++END_EMBEDDED_OASM+++\n");
+	fprintf(f, "\n");
+}
+
+
+// Generate Verilog into the output file provided
+void GenerateVerilog(FILE *f, bool generateEmbeddedOasmSection, bool timestamp)
+{
+	TraceSpan span("GenerateVerilog pass");
+
+	// Start with a boilerplate header
+	Module::GenerateVerilogHeader(f, timestamp);
+
+	int n = modules.Count();
+
+	// Generate embedded OASM section at the top of the file
+	if (generateEmbeddedOasmSection)
+	{
+		GenerateVerilogEmbeddedOasm(f);
+	}
+
+	// Generate Verilog for each non-extern top-level module, followed by its inner modules
+	for (int i=0; i < n; i++)
+	{
+		Module *module = (Module *) modules.Get(i);
+
+		// Skip extern modules
+		if (!module->IsExtern())
+		{
+			module->GenerateVerilogHierarchy(f);
+		}
+	}
+}
+
+
+/*
+ *  Generation into memory
+ */
+
+// File generated into memory, then passed whole to a sink.
+// If there is no memory for it, a fatal error is reported and the file is not open.
+class MemoryFile
+{
+public:
+	MemoryFile() : data(NULL), length(0)
+	{
+		f = open_memstream(&data, &length);
+		if (!f)
+			yyfatalfl(FileLocation(NULL), "Out of memory for generated output");
+	}
+
+	~MemoryFile()
+	{
+		if (f)
+			fclose(f);
+		free(data);
+	}
+
+	bool IsOpen() const
+	{
+		return f != NULL;
+	}
+
+	FILE *File() const
+	{
+		return f;
+	}
+
+	// Close the file and pass its contents to the sink
+	bool WriteTo(OutputSink &sink, const char *name)
+	{
+		if (!f)
+			return false;
+		fclose(f);  f = NULL;
+		return sink.Write(name, data, length);
+	}
+
+private:
+	FILE *f;
+	char *data;
+	size_t length;
+};
+
+
+// Name of the file generated for a module.  Mangled names use '$', which tools expand as a variable in
+// filelists, so it is replaced by '.', which cannot appear in OASM names.
+static string ModuleFilename(const Module *module)
+{
+	string name = module->MangledName();
+	replace(name.begin(), name.end(), '$', '.');
+	return name + ".v";
+}
+
+static bool GenerateVerilogModuleFiles(const Module *module, OutputSink &sink)
+{
+	bool ok = true;
+
+	if (module->SharedDefinition() == module)
+	{
+		MemoryFile file;
+		if (!file.IsOpen())
+			return false;
+
+		Module::GenerateVerilogHeader(file.File(), false);
+		{
+			TraceSpan span("GenerateVerilog", module);
+			module->GenerateVerilog(file.File());
+		}
+
+		string filename = ModuleFilename(module);
+		if (!file.WriteTo(sink, filename.c_str()))
+			ok = false;
+	}
+
+	int nmodules = module->InnerModuleCount();
+	for (int i=0; i < nmodules; i++)
+	{
+		const Module *innerModule = module->GetInnerModule(i);
+		if (innerModule && !GenerateVerilogModuleFiles(innerModule, sink))
+			ok = false;
+	}
+
+	return ok;
+}
+
+bool GenerateVerilogModuleFiles(OutputSink &sink)
+{
+	TraceSpan span("GenerateVerilog pass");
+
+	bool ok = true;
+	for (int i=0; i < modules.Count(); i++)
+	{
+		Module *module = (Module *) modules.Get(i);
+
+		// Skip extern modules
+		if (!module->IsExtern())
+		{
+			if (!GenerateVerilogModuleFiles(module, sink))
+				ok = false;
+		}
+	}
+	return ok;
+}
+
+
+
+/*
+ *  Compiler library
+ */
+
+CompileOptions::CompileOptions()
+	: EmbeddedOasm(true), Timestamp(false), FilePerModule(false), ShareDefinitions(false),
+	  PruneDeadLogic(false), ParseOnly(false), WarningsAsErrors(false), Netlist(false)
+{
+}
+
+
+CompilerContext *CompilerContext::current = NULL;
+
+CompilerContext *CompilerContext::Create()
+{
+	if (current)
+		return NULL;
+	return new CompilerContext();
+}
+
+CompilerContext::CompilerContext()
+	: previousHandler(NULL), started(false)
+{
+	current = this;
+
+	InitParser();
+}
+
+CompilerContext::~CompilerContext()
+{
+	Reset();
+	CleanupParser();
+	current = NULL;
+}
+
+bool CompilerContext::LoadDeviceDescription(const char *filename)
+{
+	StartDiagnostics();
+
+	bool ok = false;
+	if (started)
+		yyerrorfl(FileLocation(filename), "Device descriptions must be loaded before the first compilation");
+	else
+		ok = ::LoadDeviceDescription(filename);
+
+	EndDiagnostics();
+	return ok;
+}
+
+void CompilerContext::AddSource(const char *name, const char *text, size_t length)
+{
+	Source source;
+	source.Name = name ? name : "";
+	source.Text.assign(text, length);
+	source.Mode = PARSE_OASM;
+	sources.push_back(source);
+}
+
+void CompilerContext::AddLibrary(const char *name, const char *text, size_t length)
+{
+	AddSource(name, text, length);
+	sources.back().Mode = PARSE_EMBEDDED_OASM;
+}
+
+const vector<Diagnostic> &CompilerContext::Diagnostics() const
+{
+	return diagnostics;
+}
+
+const vector<DeadLogicRemoval> &CompilerContext::RemovedDeadLogic() const
+{
+	return removedDeadLogic;
+}
+
+
+bool CompilerContext::Compile(const CompileOptions &options, OutputSink &sink)
+{
+	TraceSpan span("Compile");
+
+	// Definitions and built-in symbols are kept between compilations, and everything after them is released
+	if (!started)
+	{
+		CreateAllObjectDefinitions();
+		strings->SetMark();
+		started = true;
+	}
+
+	StartDiagnostics();
+	warnAsError = options.WarningsAsErrors;
+	removedDeadLogic.clear();
+
+	bool ok = ParseSources();
+
+	if (ok)
+		ok = ResolveInstances();
+
+	if (ok)
+		ok = ResolveConnections();
+
+	if (ok && options.PruneDeadLogic && !options.ParseOnly)
+	{
+		DeadLogicEliminator eliminator;
+		eliminator.Run(modules, NULL);
+		removedDeadLogic = eliminator.Removals;
+	}
+
+	if (ok && !options.ParseOnly)
+		BuildDelayChains();
+
+	if (ok && options.ShareDefinitions && !options.ParseOnly)
+		ShareEquivalentDefinitions();
+
+	if (errorCount > 0 || fatalCount > 0)
+		ok = false;
+
+	if (ok && !options.ParseOnly)
+		ok = GenerateOutputs(options, sink);
+
+	EndDiagnostics();
+	Reset();
+
+	return ok;
+}
+
+// Parse all sources, stopping after the first with errors, as oasm2verilog does
+bool CompilerContext::ParseSources()
+{
+	for (int i=0; i < (int) sources.size(); i++)
+	{
+		const Source &source = sources[i];
+		const char *name = source.Name.empty() ? NULL : source.Name.c_str();
+
+		// Empty sources declare nothing, and cannot be opened as memory streams
+		if (source.Text.empty())
+		{
+			if (name)
+				parsedFilenames.push_back(strings->AddString(name));
+			continue;
+		}
+
+		FILE *f = fmemopen((void *) source.Text.data(), source.Text.size(), "r");
+		if (!f)
+		{
+			yyerrorf("Cannot open source: %s", name ? name : "(unnamed)");
+			return false;
+		}
+
+		int err = ParseFile(f, name, source.Mode);
+		fclose(f);
+
+		if (err != 0 || errorCount > 0)
+			return false;
+	}
+
+	return true;
+}
+
+bool CompilerContext::GenerateOutputs(const CompileOptions &options, OutputSink &sink)
+{
+	bool ok = true;
+	string name = "netlist";
+
+	if (options.FilePerModule)
+	{
+		if (!GenerateVerilogModuleFiles(sink))
+			ok = false;
+
+		if (options.EmbeddedOasm)
+		{
+			MemoryFile file;
+			if (file.IsOpen())
+			{
+				Module::GenerateVerilogHeader(file.File(), false);
+				GenerateVerilogEmbeddedOasm(file.File());
+			}
+			if (!file.WriteTo(sink, "interface.v"))
+				ok = false;
+		}
+	}
+	else
+	{
+		// A single output, named after the first source without its directory and extension
+		name = "out";
+		if (!sources.empty() && !sources[0].Name.empty())
+		{
+			name = sources[0].Name;
+			size_t slash = name.find_last_of('/');
+			if (slash != string::npos)
+				name = name.substr(slash + 1);
+			size_t dot = name.find_last_of('.');
+			if (dot != string::npos && dot > 0)
+				name = name.substr(0, dot);
+		}
+
+		MemoryFile file;
+		if (file.IsOpen())
+			GenerateVerilog(file.File(), options.EmbeddedOasm, options.Timestamp);
+		if (!file.WriteTo(sink, (name + ".v").c_str()))
+			ok = false;
+	}
+
+	if (options.Netlist)
+	{
+		MemoryFile file;
+		NetlistWriter writer;
+		if (!file.IsOpen() || !writer.Write(file.File(), modules) || !file.WriteTo(sink, (name + ".oanl").c_str()))
+			ok = false;
+	}
+
+	return ok;
+}
+
+// Collect diagnostics, rather than passing them to the handler set by the caller, with zeroed counts
+void CompilerContext::StartDiagnostics()
+{
+	diagnostics.clear();
+	errorCount = 0;
+	warnCount = 0;
+	fatalCount = 0;
+
+	previousHandler = diagnosticHandler;
+	diagnosticHandler = CollectDiagnostic;
+}
+
+void CompilerContext::EndDiagnostics()
+{
+	diagnosticHandler = previousHandler;
+}
+
+// Free everything created by a compilation, keeping the parser and built-in definitions
+void CompilerContext::Reset()
+{
+	DeleteModules();
+	parsedFilenames.clear();
+	parsedModules.clear();
+	fileScopeVars.clear();
+	module = NULL;
+	alu_instruction = NULL;
+	currentFilename = NULL;
+
+	if (started)
+		strings->ReleaseToMark();
+
+	sources.clear();
+}
+
+void CompilerContext::CollectDiagnostic(DiagnosticSeverity severity, SourceCodeLocation loc, const char *kind, const char *message)
+{
+	Diagnostic diagnostic;
+	diagnostic.Severity = severity;
+	diagnostic.Kind = kind;
+	diagnostic.Module = DiagnosticModuleName();
+	diagnostic.Filename = loc.Filename ? loc.Filename : "";
+	diagnostic.Line = loc.Line;
+	diagnostic.Message = message;
+	current->diagnostics.push_back(diagnostic);
+}
@@ -0,0 +1,150 @@
+#ifndef COMPILER_H
+#define COMPILER_H
+
+#include "parser.h"
+#include "DeadLogic.h"
+#include <stdio.h>
+#include <string>
+#include <vector>
+using namespace std;
+
+
+// Version of the compiler, shown in usage and generated headers
+extern const char *oasm2verilog_version;
+
+
+/*
+ * Passes over all parsed top-level modules, shared by oasm2verilog and CompilerContext
+ */
+extern bool ResolveInstances();
+extern bool ResolveConnections();
+extern void BuildDelayChains();
+extern int ShareEquivalentDefinitions();            // Returns the number of definitions shared
+
+// Deletes all parsed modules, and clears the modules collection
+extern void DeleteModules();
+
+// Generate Verilog for all non-extern top-level modules into one file, optionally with the embedded OASM section.
+// The header carries the generation time when timestamp is set.
+extern void GenerateVerilog(FILE *f, bool generateEmbeddedOasmSection, bool timestamp);
+
+// Generate only the embedded OASM section, declaring the interfaces of all top-level modules
+extern void GenerateVerilogEmbeddedOasm(FILE *f);
+
+
+/*
+ * Destination of generated files, each passed whole
+ */
+class OutputSink
+{
+public:
+	virtual ~OutputSink() {}
+
+	// Receives one generated file, which is not null-terminated.  Returns false if it cannot be written.
+	virtual bool Write(const char *name, const char *data, size_t length) = 0;
+};
+
+// Generate one Verilog file per module, and recursively for inner modules, named by mangled module name with
+// '.' in place of '$' and a .v suffix, such as Top.Inner.v.  Definitions which share the Verilog module of an
+// equivalent definition get no file of their own.  Headers carry no generation time, so that a module's file
+// only changes when the module does.
+extern bool GenerateVerilogModuleFiles(OutputSink &sink);
+
+
+/*
+ * Options of one compilation by CompilerContext, matching the command-line switches of oasm2verilog
+ */
+struct CompileOptions
+{
+	CompileOptions();
+
+	bool EmbeddedOasm;          // Generate the embedded OASM section (cleared by -n)
+	bool Timestamp;             // Generation time in headers (false by default, as with -d)
+	bool FilePerModule;         // One output per module, and interface.v, all without a generation time (-O)
+	bool ShareDefinitions;      // One Verilog module for structurally identical definitions (-s)
+	bool PruneDeadLogic;        // Remove logic which feeds no output (--prune-dead)
+	bool ParseOnly;             // No output (-p)
+	bool WarningsAsErrors;      // Warnings fail the compilation (-w)
+	bool Netlist;               // Also a binary netlist, named like the Verilog with a .oanl suffix, or netlist.oanl (--netlist)
+};
+
+// Error, warning or fatal error reported during a compilation
+struct Diagnostic
+{
+	DiagnosticSeverity Severity;
+	string Kind;                // Format string of the message, the same for every diagnostic of one kind
+	string Module;              // Mangled name of the module being processed, empty if none
+	string Filename;            // Source name, empty if unknown
+	int Line;
+	string Message;
+};
+
+
+/*
+ * Compiler for use as a library, taking sources from memory and passing outputs to a sink.
+ *
+ * The parser is initialized once, when the context is created, and the context can then be used for any number
+ * of compilations.  Each compilation starts from only the built-in definitions, with the sources added since the
+ * last one, and frees all of its modules and strings when it finishes.
+ *
+ * The parser keeps global state, so only one context may exist at a time, and it is not thread-safe.
+ * Errors are returned to the caller as diagnostics, and the library never prints or exits.
+ */
+class CompilerContext
+{
+public:
+	// Creates the context, or returns NULL if another context exists
+	static CompilerContext *Create();
+	virtual ~CompilerContext();
+
+	// Add the objects of a device description file (as with --device).  Only allowed before the first compilation.
+	// Returns false if the file cannot be read or has errors, which are then in Diagnostics.
+	bool LoadDeviceDescription(const char *filename);
+
+	// Add a source to the next compilation.  The text is copied, and name is used in diagnostics.
+	void AddSource(const char *name, const char *text, size_t length);
+
+	// Add a Verilog library file, from which only the embedded OASM interfaces are read (as with -l)
+	void AddLibrary(const char *name, const char *text, size_t length);
+
+	// Compile the sources added since the last compilation, passing the generated Verilog to the sink.
+	// A single output is named after the first source with a .v suffix.  Diagnostics are collected rather than printed.
+	// Returns false if any error occurred.
+	bool Compile(const CompileOptions &options, OutputSink &sink);
+
+	// Diagnostics of the last compilation or device description, in the order reported
+	const vector<Diagnostic> &Diagnostics() const;
+
+	// Logic removed from each module by the last compilation, with PruneDeadLogic
+	const vector<DeadLogicRemoval> &RemovedDeadLogic() const;
+
+protected:
+	CompilerContext();
+
+private:
+	struct Source
+	{
+		string Name;
+		string Text;
+		ParseMode Mode;
+	};
+
+	bool ParseSources();
+	void StartDiagnostics();
+	void EndDiagnostics();
+	bool GenerateOutputs(const CompileOptions &options, OutputSink &sink);
+	void Reset();
+
+	static void CollectDiagnostic(DiagnosticSeverity severity, SourceCodeLocation loc, const char *kind, const char *message);
+
+	vector<Source> sources;
+	vector<Diagnostic> diagnostics;
+	vector<DeadLogicRemoval> removedDeadLogic;
+	DiagnosticHandler previousHandler;
+	bool started;               // Set by the first compilation, after which strings are released back to a mark
+
+	static CompilerContext *current;
+};
+
+
+#endif
@@ -187,8 +187,7 @@ bool Connection::Resolve()
 			}
 			else
 			{
-				char buf[256];
-				yyerrorfl(Location, "Illegal inward connection in top-level module '%s' from signal '%s'", module->Name(), Source.Id.ToString(buf, sizeof(buf)) );
+				yyerrorfl(Location, "Illegal inward connection in top-level module '%s' from signal '%s'", module->Name(), Source.Id.ToString() );
 			}
 		}
 		else
@@ -211,8 +210,7 @@ bool Connection::Resolve()
 			}
 			else
 			{
-				char buf[256];
-				yyerrorfl(Location, "Illegal outward connection in top-level module '%s' to signal '%s'", module->Name(), Destination.Id.ToString(buf, sizeof(buf)));
+				yyerrorfl(Location, "Illegal outward connection in top-level module '%s' to signal '%s'", module->Name(), Destination.Id.ToString());
 			}
 		}
 		else
@@ -300,8 +298,7 @@ bool Connection::LookUpForSignal(const Module *module, const DottedIdentifier &i
 			// Currently, there is no signal nesting supprted (i.e. structs or bundles)
 			if (id.Next)
 			{
-				char buf[256];
-				yyerrorfl(Location, "Illegal reference to signal within a signal: '%s'", id.ToString(buf, sizeof(buf)));
+				yyerrorfl(Location, "Illegal reference to signal within a signal: '%s'", id.ToString());
 				sigref.ResolvedSignal = NULL;
 				sigref.ResolvedInstance = NULL;
 				return false;
@@ -321,8 +318,7 @@ bool Connection::LookUpForSignal(const Module *module, const DottedIdentifier &i
 			// It is illegal to refer to an instance in a connection
 			if (id.Next == NULL)
 			{
-				char buf[256];
-				yyerrorfl(Location, "Illegal reference to an instance.  Connections must refer to signals: '%s'", id.ToString(buf, sizeof(buf)));
+				yyerrorfl(Location, "Illegal reference to an instance.  Connections must refer to signals: '%s'", id.ToString());
 				sigref.ResolvedSignal = NULL;
 				sigref.ResolvedInstance = NULL;
 				return false;
@@ -355,8 +351,7 @@ bool Connection::LookUpForSignal(const Module *module, const DottedIdentifier &i
 	// If anchor not found in any module scope, the signal does not exist
 	if (id.Next)
 	{
-		char buf[256];
-		yyerrorfl(Location, "Instance '%s' not found.  Cannot resolve signal '%s'", firstId, id.ToString(buf, sizeof(buf)));
+		yyerrorfl(Location, "Instance '%s' not found.  Cannot resolve signal '%s'", firstId, id.ToString());
 	}
 	else
 	{
@@ -380,8 +375,7 @@ bool Connection::LookDownForSignal(const Module *module, const DottedIdentifier
 		// Currently, there is no signal nesting supprted (i.e. structs or bundles)
 		if (id.Next)
 		{
-			char buf[256];
-			yyerrorfl(Location, "Illegal reference to signal within a signal: '%s'", id.ToString(buf, sizeof(buf)));
+			yyerrorfl(Location, "Illegal reference to signal within a signal: '%s'", id.ToString());
 			sigref.ResolvedSignal = NULL;
 			sigref.ResolvedInstance = NULL;
 			return false;
@@ -437,8 +431,7 @@ bool Connection::LookDownForSignal(const Module *module, const DottedIdentifier
 	// If anchor not found in any module scope, the signal does not exist
 	if (id.Next)
 	{
-		char buf[256];
-		yyerrorfl(Location, "Instance '%s' not found.  Cannot resolve signal: '%s'", id.Name, id.ToString(buf, sizeof(buf)));
+		yyerrorfl(Location, "Instance '%s' not found.  Cannot resolve signal: '%s'", id.Name, id.ToString());
 	}
 	else
 	{
@@ -497,36 +490,9 @@ bool Connection::Flatten()
 			}
 			else
 			{
-				// Create an input port in the current module with the name "module$signal"
-				// Add a new outer connection to the current module, from the original source to the new port
-				// Modify this connection to come from the new port
-
-				// Create port name
-				strings->StartString();
-				strings->AppendString(Source.ResolvedSignal->module->Name());
-				strings->AppendChar('$');
-				strings->AppendString(Source.ResolvedSignal->Name());
-				const char *portName = strings->FinishString();
-
-				// Get existing or create new input port
-				Signal *port = module->GetSignal(portName);
-				if (port)
-				{
-					// Port has already been added
-				}
-				else
-				{
-					port = new Signal(portName, BEHAVIOR_WIRE, Source.ResolvedSignal->DataType, DIR_IN);
-					port->Automatic = true;
-					module->AddSignal(port);
-				}
-
-				// Create a new outer connection input from the original source, to the new port
-				OuterConnection *outer = new OuterConnection(module, DIR_IN, Source.ResolvedSignal, NULL, port, NULL);
-				module->AddOuterConnection(outer);
-
-				// Modify connection to come from the new port
-				Source.ResolvedSignal = port;
+				// Route the source through an input port in the current module with the name "module$signal"
+				// Modify this connection to come from the port
+				Source.ResolvedSignal = RouteOuterSignal(Source.ResolvedSignal, NULL, DIR_IN);
 				Source.ResolvedInstance = NULL;
 			}
 		}
@@ -555,38 +521,9 @@ bool Connection::Flatten()
 			}
 			else
 			{
-				// Create an input port with the name "module$instance$signal"
-				// Add a new outer connection, from the original source to the new port
-				// Modify this connection to come from the new port
-
-				// Create port name
-				strings->StartString();
-				strings->AppendString(Source.ResolvedInstance->module->Name());
-				strings->AppendChar('$');
-				strings->AppendString(Source.ResolvedInstance->Name());
-				strings->AppendChar('$');
-				strings->AppendString(Source.ResolvedSignal->Name());
-				const char *portName = strings->FinishString();
-
-				// Get existing or create new input port
-				Signal *port = module->GetSignal(portName);
-				if (port)
-				{
-					// Port has already been added
-				}
-				else
-				{
-					port = new Signal(portName, BEHAVIOR_WIRE, Source.ResolvedSignal->DataType, DIR_IN);
-					port->Automatic = true;
-					module->AddSignal(port);
-				}
-
-				// Create a new outer connection input from the original source, to the new port
-				OuterConnection *outer = new OuterConnection(module, DIR_IN, Source.ResolvedSignal, Source.ResolvedInstance, port, NULL);
-				module->AddOuterConnection(outer);
-
-				// Modify connection to come from the new port
-				Source.ResolvedSignal = port;
+				// Route the source through an input port with the name "module$instance$signal"
+				// Modify this connection to come from the port
+				Source.ResolvedSignal = RouteOuterSignal(Source.ResolvedSignal, Source.ResolvedInstance, DIR_IN);
 				Source.ResolvedInstance = NULL;
 			}
 		}
@@ -618,36 +555,9 @@ bool Connection::Flatten()
 			}
 			else
 			{
-				// Create an output port with the name "module$signal"
-				// Add a new outer connection, from the new port to the original destination
-				// Modify this connection to go to the new port
-
-				// Create port name
-				strings->StartString();
-				strings->AppendString(Destination.ResolvedSignal->module->Name());
-				strings->AppendChar('$');
-				strings->AppendString(Destination.ResolvedSignal->Name());
-				const char *portName = strings->FinishString();
-
-				// Get existing or create new output port
-				Signal *port = module->GetSignal(portName);
-				if (port)
-				{
-					// Port has already been added
-				}
-				else
-				{
-					port = new Signal(portName, BEHAVIOR_WIRE, Destination.ResolvedSignal->DataType, DIR_OUT);
-					port->Automatic = true;
-					module->AddSignal(port);
-				}
-
-				// Create a new outer connection output to the original destination, from the new port
-				OuterConnection *outer = new OuterConnection(module, DIR_OUT, port, NULL, Destination.ResolvedSignal, NULL);
-				module->AddOuterConnection(outer);
-
-				// Modify connection to go to the new port
-				Destination.ResolvedSignal = port;
+				// Route the destination through an output port with the name "module$signal"
+				// Modify this connection to go to the port
+				Destination.ResolvedSignal = RouteOuterSignal(Destination.ResolvedSignal, NULL, DIR_OUT);
 				Destination.ResolvedInstance = NULL;
 			}
 		}
@@ -675,38 +585,9 @@ bool Connection::Flatten()
 			}
 			else
 			{
-				// Create an output port with the name "module$instance$signal"
-				// Add a new outer connection, from the new port to the original destination
-				// Modify this connection to go to the new port
-
-				// Create port name
-				strings->StartString();
-				strings->AppendString(Destination.ResolvedInstance->module->Name());
-				strings->AppendChar('$');
-				strings->AppendString(Destination.ResolvedInstance->Name());
-				strings->AppendChar('$');
-				strings->AppendString(Destination.ResolvedSignal->Name());
-				const char *portName = strings->FinishString();
-
-				// Get existing or create new output port
-				Signal *port = module->GetSignal(portName);
-				if (port)
-				{
-					// Port has already been added
-				}
-				else
-				{
-					port = new Signal(portName, BEHAVIOR_WIRE, Destination.ResolvedSignal->DataType, DIR_OUT);
-					port->Automatic = true;
-					module->AddSignal(port);
-				}
-
-				// Create a new outer connection output to the original destination, from the new port
-				OuterConnection *outer = new OuterConnection(module, DIR_OUT, port, NULL, Destination.ResolvedSignal, Destination.ResolvedInstance);
-				module->AddOuterConnection(outer);
-
-				// Modify connection to go to the new port
-				Destination.ResolvedSignal = port;
+				// Route the destination through an output port with the name "module$instance$signal"
+				// Modify this connection to go to the port
+				Destination.ResolvedSignal = RouteOuterSignal(Destination.ResolvedSignal, Destination.ResolvedInstance, DIR_OUT);
 				Destination.ResolvedInstance = NULL;
 			}
 		}
@@ -788,6 +669,65 @@ bool Connection::Flatten()
 
 
 
+// Returns the automatic port which routes a signal at a higher scope into (DIR_IN) or out of (DIR_OUT) the module.
+// The first request for a route creates the port, named "module$signal" or "module$instance$signal",
+// along with an outer connection to be stitched up at the next level of hierarchy.
+// Later requests for the same outer signal return the memoized port, so that every connection in the module
+// shares a single port, and the name and outer connection are not rebuilt for each consumer.
+Signal *Connection::RouteOuterSignal(Signal *signal, Instance *instance, SignalDirection direction)
+{
+	// Reuse the port if this route has already been computed for the module
+	Signal *port = module->GetOuterPort(signal, instance, direction);
+	if (port)
+		return port;
+
+	// Create port name
+	strings->StartString();
+	if (instance)
+	{
+		strings->AppendString(instance->module->Name());
+		strings->AppendChar('$');
+		strings->AppendString(instance->Name());
+	}
+	else
+	{
+		strings->AppendString(signal->module->Name());
+	}
+	strings->AppendChar('$');
+	strings->AppendString(signal->Name());
+	const char *portName = strings->FinishString();
+
+	// Get existing or create new port
+	port = module->GetSignal(portName);
+	if (port)
+	{
+		// Port has already been added
+	}
+	else
+	{
+		port = new Signal(portName, BEHAVIOR_WIRE, signal->DataType, direction);
+		port->Automatic = true;
+		module->AddSignal(port);
+	}
+
+	// Create a new outer connection between the original signal and the new port
+	OuterConnection *outer;
+	if (direction == DIR_IN)
+		outer = new OuterConnection(module, DIR_IN, signal, instance, port, NULL);
+	else
+		outer = new OuterConnection(module, DIR_OUT, port, NULL, signal, instance);
+
+	if (!module->AddOuterConnection(outer))
+		delete outer;
+
+	// Remember the route for later connections in this module
+	module->AddOuterPort(signal, instance, direction, port);
+
+	return port;
+}
+
+
+
 // OuterConnection struct, used during ResolveConnections phase to create ports and connections in inner module hierarchies
 OuterConnection::OuterConnection()
 	: module(NULL), Direction(DIR_NONE), SourceSignal(NULL), SourceInstance(NULL), DestinationSignal(NULL), DestinationInstance(NULL)
@@ -890,3 +830,22 @@ bool OuterConnection::operator!=(const OuterConnection &outerConnection) const
 	// Invert result of operator==
 	return !(*this == outerConnection);
 }
+
+
+
+// Key for memoized outer ports, ordered by signal, instance, and direction
+OuterPortKey::OuterPortKey(const Signal *signal, const Instance *instance, SignalDirection direction)
+	: OuterSignal(signal), OuterInstance(instance), Direction(direction)
+{
+}
+
+bool OuterPortKey::operator<(const OuterPortKey &key) const
+{
+	if (OuterSignal != key.OuterSignal)
+		return OuterSignal < key.OuterSignal;
+
+	if (OuterInstance != key.OuterInstance)
+		return OuterInstance < key.OuterInstance;
+
+	return Direction < key.Direction;
+}
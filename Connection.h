@@ -4,11 +4,12 @@
 
 #include "Signal.h"
 #include "Common.h"
+#include "AllocTracked.h"
 
 class Module;
 class Instance;
 
-class Connection
+class Connection : public AllocTracked<ALLOC_CONNECTION>
 {
 public:
 	Connection();
@@ -43,12 +44,17 @@ private:
 	// The sigref provided to these methods are modified to resolve the instance and signal
 	bool LookUpForSignal(const Module *module, const DottedIdentifier &id, SignalReference &sigref) const;
 	bool LookDownForSignal(const Module *module, const DottedIdentifier &id, SignalReference &sigref) const;
+
+	// Returns the automatic port which routes a signal at a higher scope into or out of the module.
+	// The port and its outer connection are created only the first time a route is requested,
+	// and are shared by every later connection in the module that uses the same outer signal.
+	Signal *RouteOuterSignal(Signal *signal, Instance *instance, SignalDirection direction);
 };
 
 
 // Unresolved connection to a higher-level signal, to be flatted at each level up the
 // inner module hierarchy, during ResolveConnections phase.
-struct OuterConnection
+struct OuterConnection : public AllocTracked<ALLOC_OUTER_CONNECTION>
 {
 	OuterConnection();
 	OuterConnection(Module *module, SignalDirection direction, Signal *sourceSignal, Instance *sourceInstance, Signal *destinationSignal, Instance *destinationInstance);
@@ -67,4 +73,18 @@ struct OuterConnection
 	bool operator!=(const OuterConnection &outerConnection) const;
 };
 
+
+// Key used by modules to look up the automatic port created for an outer signal,
+// so that each route through the hierarchy is computed only once per module.
+struct OuterPortKey
+{
+	OuterPortKey(const Signal *signal, const Instance *instance, SignalDirection direction);
+
+	const Signal *OuterSignal;
+	const Instance *OuterInstance;
+	SignalDirection Direction;
+
+	bool operator<(const OuterPortKey &key) const;
+};
+
 #endif
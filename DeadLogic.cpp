@@ -0,0 +1,274 @@
+#include "DeadLogic.h"
+#include "SiliconObject.h"
+#include "Common.h"
+
+
+DeadLogicEliminator::DeadLogicEliminator()
+	: RemovedWires(0), RemovedDelays(0), RemovedPorts(0), RemovedConnections(0)
+{
+}
+
+
+void DeadLogicEliminator::Run(StringMap &modules, FILE *report)
+{
+	int n = modules.Count();
+	for (int i=0; i < n; i++)
+	{
+		Module *module = (Module *) modules.Get(i);
+		if (!module->IsExtern())
+			IndexModule(module);
+	}
+
+	// Mark roots in every module, then follow connections backward until nothing new is marked
+	for (int i=0; i < (int) transparentModules.size(); i++)
+		MarkRoots(transparentModules[i]);
+
+	while (!pending.empty())
+	{
+		const Signal *signal = pending.back();
+		pending.pop_back();
+		Propagate(signal);
+	}
+
+	for (int i=0; i < (int) transparentModules.size(); i++)
+		Sweep(transparentModules[i], report);
+
+	// Outer connections may refer to removed ports, or to removed signals in a parent module
+	for (int i=0; i < n; i++)
+	{
+		Module *module = (Module *) modules.Get(i);
+		if (!module->IsExtern())
+			RemoveStaleOuterConnections(module);
+	}
+}
+
+
+bool DeadLogicEliminator::IsTransparent(const Module *module)
+{
+	if (module->IsExtern())
+		return false;
+
+	// The top-level FPOA is a silicon object, but contains ordinary structural logic
+	if (dynamic_cast<const SiliconObject*>(module) && !module->IsFPOA())
+		return false;
+
+	return true;
+}
+
+
+// Record instantiations, and drivers of local signals, for the module and its inner modules
+void DeadLogicEliminator::IndexModule(Module *module)
+{
+	int ninst = module->InstanceCount();
+	for (int i=0; i < ninst; i++)
+	{
+		const Instance *inst = module->GetInstance(i);
+		if (inst->Definition)
+			instantiations[inst->Definition].push_back(inst);
+	}
+
+	if (IsTransparent(module))
+	{
+		transparentModules.push_back(module);
+
+		int ncon = module->ConnectionCount();
+		for (int i=0; i < ncon; i++)
+		{
+			const Connection *c = module->GetConnection(i);
+			if (c->Destination.ResolvedInstance == NULL)
+				drivers.insert(make_pair(c->Destination.ResolvedSignal, c));
+		}
+	}
+
+	int nmodules = module->InnerModuleCount();
+	for (int i=0; i < nmodules; i++)
+	{
+		Module *innerModule = module->GetInnerModule(i);
+		if (innerModule)
+			IndexModule(innerModule);
+	}
+}
+
+
+void DeadLogicEliminator::MarkRoots(Module *module)
+{
+	// Declared ports are part of the module interface.
+	// Outputs are read from outside, and inputs keep their connections in instantiating modules.
+	int nsignals = module->SignalCount();
+	for (int i=0; i < nsignals; i++)
+	{
+		const Signal *sig = module->GetSignal(i);
+		if (sig->Direction != DIR_NONE && !sig->Automatic)
+			MarkSignal(sig);
+	}
+
+	// Connections into silicon objects, externs, and built-in signals are all consumed
+	int ncon = module->ConnectionCount();
+	for (int i=0; i < ncon; i++)
+	{
+		const Connection *c = module->GetConnection(i);
+		const Instance *inst = c->Destination.ResolvedInstance;
+
+		if ((inst && inst->Definition && !IsTransparent(inst->Definition)) ||
+			(c->Destination.ResolvedSignal->Behavior == BEHAVIOR_BUILTIN))
+		{
+			MarkConnection(c);
+		}
+	}
+}
+
+
+void DeadLogicEliminator::MarkSignal(const Signal *signal)
+{
+	if (signal && liveSignals.insert(signal).second)
+		pending.push_back(signal);
+}
+
+
+// A live connection makes its source live.  An instance output port is marked in the instance definition.
+void DeadLogicEliminator::MarkConnection(const Connection *connection)
+{
+	if (liveConnections.insert(connection).second)
+		MarkSignal(connection->Source.ResolvedSignal);
+}
+
+
+void DeadLogicEliminator::Propagate(const Signal *signal)
+{
+	const Module *module = signal->module;
+	if (module == NULL || !IsTransparent(module))
+		return;
+
+	// Local drivers
+	multimap<const Signal*, const Connection*>::const_iterator it = drivers.lower_bound(signal);
+	multimap<const Signal*, const Connection*>::const_iterator end = drivers.upper_bound(signal);
+	for (; it != end; ++it)
+		MarkConnection(it->second);
+
+	// Delays and bit-slices read their base signal, and delays also read the previous tap in their chain
+	if (signal->Behavior == BEHAVIOR_DELAY || signal->Behavior == BEHAVIOR_BIT_SLICE)
+		MarkSignal(signal->BaseSignal);
+
+	if (signal->Behavior == BEHAVIOR_DELAY)
+		MarkSignal(signal->DelaySource);
+
+	// Input ports are driven in each module where the definition is instantiated
+	if (signal->Direction == DIR_IN)
+	{
+		map<const Module*, vector<const Instance*> >::const_iterator found = instantiations.find(module);
+		if (found != instantiations.end())
+		{
+			const vector<const Instance*> &insts = found->second;
+			for (int i=0; i < (int) insts.size(); i++)
+			{
+				const Instance *inst = insts[i];
+				int ncon = inst->ConnectionCount();
+				for (int j=0; j < ncon; j++)
+				{
+					const Connection *c = inst->GetConnection(j);
+					if (c->Destination.ResolvedInstance == inst && c->Destination.ResolvedSignal == signal)
+						MarkConnection(c);
+				}
+			}
+		}
+	}
+}
+
+
+void DeadLogicEliminator::Sweep(Module *module, FILE *report)
+{
+	int wires = 0;
+	int delays = 0;
+	int ports = 0;
+	int connections = 0;
+
+	// Remove dead connections, from the module and from the instances they connect
+	for (int i = module->ConnectionCount() - 1; i >= 0; i--)
+	{
+		Connection *c = module->GetConnection(i);
+		if (liveConnections.find(c) == liveConnections.end())
+		{
+			if (c->Source.ResolvedInstance)
+				c->Source.ResolvedInstance->RemoveConnection(c);
+			if (c->Destination.ResolvedInstance)
+				c->Destination.ResolvedInstance->RemoveConnection(c);
+
+			module->RemoveConnectionAt(i);
+			delete c;
+			connections++;
+		}
+	}
+
+	// Collect dead signals first, because removal changes signal indexes
+	vector<Signal*> dead;
+	int nsignals = module->SignalCount();
+	for (int i=0; i < nsignals; i++)
+	{
+		Signal *sig = module->GetSignal(i);
+		if (liveSignals.find(sig) != liveSignals.end())
+			continue;
+
+		bool removable = (sig->Behavior == BEHAVIOR_WIRE || sig->Behavior == BEHAVIOR_DELAY || sig->Behavior == BEHAVIOR_BIT_SLICE) &&
+			(sig->Direction == DIR_NONE || sig->Automatic);
+
+		if (removable)
+			dead.push_back(sig);
+	}
+
+	for (int i=0; i < (int) dead.size(); i++)
+	{
+		Signal *sig = dead[i];
+
+		if (yydebug && report)
+			fprintf(report, "Removing unused signal '%s' from module '%s'\n", sig->Name(), module->MangledName().c_str());
+
+		if (sig->Direction != DIR_NONE)
+			ports++;
+		else if (sig->Behavior == BEHAVIOR_DELAY)
+			delays++;
+		else if (sig->Behavior == BEHAVIOR_WIRE)
+			wires++;
+
+		removedSignals.insert(sig);
+		module->RemoveSignal(sig);
+	}
+
+	if (wires || delays || ports || connections)
+	{
+		DeadLogicRemoval removal;
+		removal.Module = module->MangledName();
+		removal.Wires = wires;
+		removal.Delays = delays;
+		removal.Ports = ports;
+		removal.Connections = connections;
+		Removals.push_back(removal);
+	}
+
+	RemovedWires += wires;
+	RemovedDelays += delays;
+	RemovedPorts += ports;
+	RemovedConnections += connections;
+}
+
+
+void DeadLogicEliminator::RemoveStaleOuterConnections(Module *module)
+{
+	for (int i = module->OuterConnectionCount() - 1; i >= 0; i--)
+	{
+		OuterConnection *oc = module->GetOuterConnection(i);
+		if (removedSignals.find(oc->SourceSignal) != removedSignals.end() ||
+			removedSignals.find(oc->DestinationSignal) != removedSignals.end())
+		{
+			module->RemoveOuterConnection(oc);
+			delete oc;
+		}
+	}
+
+	int nmodules = module->InnerModuleCount();
+	for (int i=0; i < nmodules; i++)
+	{
+		Module *innerModule = module->GetInnerModule(i);
+		if (innerModule)
+			RemoveStaleOuterConnections(innerModule);
+	}
+}
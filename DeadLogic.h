@@ -0,0 +1,84 @@
+#ifndef DEAD_LOGIC_H
+#define DEAD_LOGIC_H
+
+#include "Module.h"
+
+#include <stdio.h>
+#include <set>
+#include <map>
+#include <string>
+#include <vector>
+using namespace std;
+
+
+// Logic removed from one module
+struct DeadLogicRemoval
+{
+	string Module;              // Mangled name
+	int Wires;
+	int Delays;
+	int Ports;
+	int Connections;
+};
+
+
+// Removes logic which cannot affect any output of the design, after ResolveConnections.
+//
+// Signals are marked live backward through connections, starting from the declared output ports
+// of every module, the inputs of silicon objects and extern modules, and built-in signals.
+// Liveness crosses the hierarchy through automatic ports: an automatic input port that is live
+// makes its drivers live in every module where the definition is instantiated, and an automatic
+// output port is live only if it feeds live logic in one of those modules.
+//
+// Unmarked wires, delays, bit-slices, automatic ports and connections are then removed
+// from all modules except silicon objects, whose contents are left untouched.
+// Declared ports are never removed, so module interfaces do not change.
+class DeadLogicEliminator
+{
+public:
+	DeadLogicEliminator();
+
+	// Runs the pass over all top-level modules and their inner modules.
+	// With yydebug, each removed signal is reported to the given file, if not NULL.
+	void Run(StringMap &modules, FILE *report);
+
+	// Totals removed by the pass
+	int RemovedWires;
+	int RemovedDelays;
+	int RemovedPorts;
+	int RemovedConnections;
+
+	// Each module with removed logic, in the order swept
+	vector<DeadLogicRemoval> Removals;
+
+private:
+	// Modules whose contents are visible to the pass, as opposed to silicon objects and externs
+	static bool IsTransparent(const Module *module);
+
+	void IndexModule(Module *module);
+	void MarkRoots(Module *module);
+	void MarkSignal(const Signal *signal);
+	void MarkConnection(const Connection *connection);
+	void Propagate(const Signal *signal);
+	void Sweep(Module *module, FILE *report);
+	void RemoveStaleOuterConnections(Module *module);
+
+	// All transparent modules in the design
+	vector<Module*> transparentModules;
+
+	// Instances of each definition, used to follow input ports up into the instantiating modules
+	map<const Module*, vector<const Instance*> > instantiations;
+
+	// Connections driving each local signal
+	multimap<const Signal*, const Connection*> drivers;
+
+	set<const Signal*> liveSignals;
+	set<const Connection*> liveConnections;
+	vector<const Signal*> pending;
+
+	// Removed signals, whose outer connections must also be removed
+	set<const Signal*> removedSignals;
+};
+
+
+#endif
@@ -0,0 +1,568 @@
+#include "DesignSimulator.h"
+#include "Alu.h"
+#include "Instance.h"
+#include "Parameter.h"
+#include "RF.h"
+#include "TF.h"
+#include "Common.h"
+
+#include <string.h>
+
+
+#define RAM_ENTRIES     (64)
+
+
+static long IntegerParameter(const Module *module, const char *name, long value)
+{
+	const Parameter *param = module->GetParameter(name);
+	if (param && param->Value.type == CONST_INT)
+		return param->Value.val.i;
+	return value;
+}
+
+static bool EnumParameterIs(const Module *module, const char *name, const char *value)
+{
+	const Parameter *param = module->GetParameter(name);
+	if (param && (param->Value.type == CONST_ENUM || param->Value.type == CONST_STRING))
+		return strcmp(param->Value.val.s, value) == 0;
+	return false;
+}
+
+static const Signal *RamPort(const char *name)
+{
+	return (const Signal *) RF_RAM::BuiltinDefinition()->Symbols()->Get(name);
+}
+
+
+DesignSimulator::DesignSimulator(const Module *top)
+	: top(top)
+{
+	vector<Copy> unordered;
+	Elaborate(top, top->Name(), unordered);
+
+	// Top-level ports
+	int n = top->SignalCount();
+	for (int i=0; i < n; i++)
+	{
+		const Signal *sig = top->GetSignal(i);
+		if (sig->Direction == DIR_IN || sig->Direction == DIR_OUT)
+		{
+			ports.push_back(sig);
+			portSlots.push_back(SlotFor(0, sig));
+		}
+	}
+
+	values.assign(slotSignals.size(), 0);
+	driven.assign(slotSignals.size(), false);
+	for (size_t i=0; i < ports.size(); i++)
+	{
+		if (ports[i]->Direction == DIR_IN)
+			driven[portSlots[i]] = true;
+	}
+
+	Levelize(unordered);
+
+	// ALU signals driven from the design are inputs of the ALU, and all others are read back as outputs
+	map<pair<int, const Signal*>, int>::const_iterator it;
+	for (it = slots.begin(); it != slots.end(); ++it)
+	{
+		for (size_t a=0; a < alus.size(); a++)
+		{
+			if (aluContexts[a] != it->first.first)
+				continue;
+
+			AluPort port;
+			port.Alu = a;
+			port.AluSlot = alus[a]->Slot(it->first.second);
+			port.Slot = it->second;
+			port.Input = driven[it->second];
+			if (port.AluSlot >= 0)
+				aluPorts.push_back(port);
+		}
+	}
+
+	nextTFs.assign(tfs.size(), 0);
+
+	Reset();
+}
+
+DesignSimulator::~DesignSimulator()
+{
+	for (size_t i=0; i < alus.size(); i++)
+		delete alus[i];
+}
+
+const Module *DesignSimulator::Top() const
+{
+	return top;
+}
+
+
+int DesignSimulator::SlotFor(int ctx, const Signal *sig)
+{
+	pair<int, const Signal*> key(ctx, sig);
+	map<pair<int, const Signal*>, int>::const_iterator found = slots.find(key);
+	if (found != slots.end())
+		return found->second;
+
+	int slot = slotSignals.size();
+	slots[key] = slot;
+	slotContexts.push_back(ctx);
+	slotSignals.push_back(sig);
+	return slot;
+}
+
+
+void DesignSimulator::Warn(const Module *module, const char *what)
+{
+	for (size_t i=0; i < warned.size(); i++)
+	{
+		if (warned[i] == module)
+			return;
+	}
+
+	warned.push_back(module);
+	yywarnfl(module->Location, "%s '%s' is not simulated, and its outputs are 0", what, module->Name());
+}
+
+
+// Flattens an instance of a module into slots, returning its context.
+// Connections and bit-slices are collected into unordered, to be levelized once the whole design is known.
+int DesignSimulator::Elaborate(const Module *module, const string &path, vector<Copy> &unordered)
+{
+	int ctx = contexts.size();
+	Context context;
+	context.Definition = module;
+	context.Path = path;
+	contexts.push_back(context);
+
+	if (module->IsExtern())
+	{
+		Warn(module, "Extern module");
+		return ctx;
+	}
+
+	// ALUs are simulated as a whole, and connected by their ports once all slots are known
+	const Alu *alu = dynamic_cast<const Alu *>(module);
+	if (alu)
+	{
+		alus.push_back(new AluSimulator(alu));
+		aluContexts.push_back(ctx);
+		return ctx;
+	}
+
+	// Delays, bit-slices, and initial values of constants and registers
+	int n = module->SignalCount();
+	for (int i=0; i < n; i++)
+	{
+		const Signal *sig = module->GetSignal(i);
+		int slot = SlotFor(ctx, sig);
+
+		if (sig->Behavior == BEHAVIOR_DELAY && sig->BaseSignal)
+		{
+			// Each tap of a delay chain follows the previous tap
+			const Signal *source = sig->DelaySource ? sig->DelaySource : sig->BaseSignal;
+			int delay = sig->DelayCount - (source->Behavior == BEHAVIOR_DELAY ? source->DelayCount : 0);
+
+			DelayLine line;
+			line.Dest = slot;
+			line.Source = SlotFor(ctx, source);
+			line.History.assign(delay > 0 ? delay : 1, 0);
+			line.Position = 0;
+			delays.push_back(line);
+		}
+		else if (sig->Behavior == BEHAVIOR_BIT_SLICE && sig->BaseSignal)
+		{
+			Copy copy;
+			copy.Dest = slot;
+			copy.Source = SlotFor(ctx, sig->BaseSignal);
+			copy.BitSlice = sig->BitSliceIndex;
+			unordered.push_back(copy);
+		}
+		else if ((sig->Behavior == BEHAVIOR_CONST || sig->Behavior == BEHAVIOR_REG) && sig->InitialValue >= 0)
+		{
+			unsigned value = sig->DataType == DATA_TYPE_BIT ? (sig->InitialValue & 1) : (sig->InitialValue & 0x1FFFF);
+			initialValues.push_back(make_pair(slot, value));
+		}
+	}
+
+	// Silicon objects
+	const FloatingTF *tf = dynamic_cast<const FloatingTF *>(module);
+	if (tf)
+	{
+		for (int i=0; i < tf->TFCount(); i++)
+		{
+			const TruthFunction &function = tf->TFLogic(i);
+			Logic logic;
+			logic.Dest = SlotFor(ctx, tf->TFRegister(i));
+			logic.Table = function.Logic;
+			for (int a=0; a < 4; a++)
+				logic.Args[a] = function.Args[a] ? SlotFor(ctx, function.Args[a]) : -1;
+			tfs.push_back(logic);
+		}
+	}
+	else if (dynamic_cast<const RF_RAM *>(module))
+	{
+		ElaborateRam(ctx, module);
+	}
+	else if (dynamic_cast<const SiliconObject *>(module) && !module->IsFPOA())
+	{
+		Warn(module, "Silicon object");
+	}
+
+	// Instances, before the connections to their ports
+	int ninst = module->InstanceCount();
+	for (int i=0; i < ninst; i++)
+	{
+		const Instance *inst = module->GetInstance(i);
+		if (inst->Definition)
+			children[make_pair(ctx, inst)] = Elaborate(inst->Definition, path + "." + inst->Name(), unordered);
+	}
+
+	int ncon = module->ConnectionCount();
+	for (int i=0; i < ncon; i++)
+	{
+		const Connection *c = module->GetConnection(i);
+		if (!c->Source.ResolvedSignal || !c->Destination.ResolvedSignal)
+			continue;
+
+		int sourceCtx = c->Source.ResolvedInstance ? children[make_pair(ctx, (const Instance *) c->Source.ResolvedInstance)] : ctx;
+		int destCtx = c->Destination.ResolvedInstance ? children[make_pair(ctx, (const Instance *) c->Destination.ResolvedInstance)] : ctx;
+
+		Copy copy;
+		copy.Dest = SlotFor(destCtx, c->Destination.ResolvedSignal);
+		copy.Source = SlotFor(sourceCtx, c->Source.ResolvedSignal);
+		copy.BitSlice = -1;
+		unordered.push_back(copy);
+	}
+
+	return ctx;
+}
+
+
+void DesignSimulator::ElaborateRam(int ctx, const Module *module)
+{
+	Ram ram;
+	ram.Wr = SlotFor(ctx, RamPort("wr"));
+	ram.WrAddr = SlotFor(ctx, RamPort("wr_addr"));
+	ram.Rd = SlotFor(ctx, RamPort("rd"));
+	ram.RdAddr = SlotFor(ctx, RamPort("rd_addr"));
+	ram.Flush = SlotFor(ctx, RamPort("flush"));
+
+	const char *enables[3] = { "word_bits15to8", "word_bits7to0", "tags" };
+	for (int p=0; p < 2; p++)
+	{
+		char name[64];
+		sprintf(name, "wr_data%d_word", p);
+		ram.WrData[p][0] = SlotFor(ctx, RamPort(name));
+		sprintf(name, "rd_data%d_word", p);
+		ram.RdData[p][0] = SlotFor(ctx, RamPort(name));
+
+		for (int t=0; t < 4; t++)
+		{
+			sprintf(name, "wr_data%d_tag%d", p, t);
+			ram.WrData[p][1 + t] = SlotFor(ctx, RamPort(name));
+			sprintf(name, "rd_data%d_tag%d", p, t);
+			ram.RdData[p][1 + t] = SlotFor(ctx, RamPort(name));
+		}
+
+		for (int e=0; e < 3; e++)
+		{
+			sprintf(name, "be_wr_data%d_%s", p, enables[e]);
+			ram.ByteEnables[p][e] = SlotFor(ctx, RamPort(name));
+
+			sprintf(name, "be_wr_data%d_%s_mode", p, enables[e]);
+			ram.ByteEnableModes[p][e] = EnumParameterIs(module, name, "active_never") ? 1 : EnumParameterIs(module, name, "active_high") ? 2 : 0;
+		}
+	}
+
+	ram.WrWidth = IntegerParameter(module, "wr_width", 1);
+	ram.RdWidth = IntegerParameter(module, "rd_width", 1);
+	ram.WrActiveLow = EnumParameterIs(module, "wr_mode", "active_low");
+	ram.RdActiveLow = EnumParameterIs(module, "rd_mode", "active_low");
+
+	ram.Init.assign(RAM_ENTRIES, 0);
+	const Parameter *init = module->GetParameter("init_data");
+	if (init && init->Value.type == EXPRESSION_ARRAY)
+	{
+		int count = init->Value.val.array->Count();
+		for (int i=0; i < count && i < RAM_ENTRIES; i++)
+		{
+			Expression value = init->Value.val.array->GetValue(i);
+			if (value.type == CONST_INT)
+				ram.Init[i] = value.val.i & 0xFFFFF;
+		}
+	}
+
+	rams.push_back(ram);
+}
+
+
+// Orders copies so that every source is computed before it is used
+void DesignSimulator::Levelize(vector<Copy> &unordered)
+{
+	int n = unordered.size();
+	vector<int> producer(values.size(), -1);
+	for (int i=0; i < n; i++)
+	{
+		producer[unordered[i].Dest] = i;
+		driven[unordered[i].Dest] = true;
+	}
+
+	// Depth-first, without recursion, as chains of connections through a large design can be long
+	vector<int> state(n, 0);        // 0 = not visited, 1 = waiting for its source, 2 = ordered
+	vector<int> stack;
+	for (int i=0; i < n; i++)
+	{
+		stack.push_back(i);
+		while (!stack.empty())
+		{
+			int c = stack.back();
+			if (state[c] == 0)
+			{
+				state[c] = 1;
+				int source = producer[unordered[c].Source];
+				if (source >= 0 && state[source] == 0)
+				{
+					stack.push_back(source);
+				}
+				else if (source >= 0 && state[source] == 1)
+				{
+					const Signal *sig = slotSignals[unordered[c].Source];
+					const Context &context = contexts[slotContexts[unordered[c].Source]];
+					yywarnfl(context.Definition->Location, "Combinational loop through '%s.%s' is evaluated in connection order",
+						context.Path.c_str(), sig->Name());
+				}
+			}
+			else
+			{
+				if (state[c] == 1)
+					copies.push_back(unordered[c]);
+				state[c] = 2;
+				stack.pop_back();
+			}
+		}
+	}
+}
+
+
+void DesignSimulator::Reset()
+{
+	values.assign(values.size(), 0);
+	for (size_t i=0; i < initialValues.size(); i++)
+		values[initialValues[i].first] = initialValues[i].second;
+
+	for (size_t i=0; i < delays.size(); i++)
+	{
+		delays[i].History.assign(delays[i].History.size(), 0);
+		delays[i].Position = 0;
+	}
+
+	for (size_t i=0; i < rams.size(); i++)
+		rams[i].Memory = rams[i].Init;
+
+	for (size_t i=0; i < aluPorts.size(); i++)
+	{
+		if (aluPorts[i].Input)
+			alus[aluPorts[i].Alu]->SetInput(aluPorts[i].AluSlot, 0);
+	}
+
+	for (size_t i=0; i < alus.size(); i++)
+	{
+		alus[i]->Reset();
+		alus[i]->Evaluate();
+	}
+}
+
+
+unsigned DesignSimulator::Lookup(const Logic &logic) const
+{
+	int index = 0;
+	for (int a=0; a < 4; a++)
+	{
+		if (logic.Args[a] >= 0 && (values[logic.Args[a]] & 1))
+			index |= 1 << a;
+	}
+	return (logic.Table >> index) & 1;
+}
+
+
+void DesignSimulator::Evaluate()
+{
+	for (size_t i=0; i < delays.size(); i++)
+		values[delays[i].Dest] = delays[i].History[delays[i].Position];
+
+	for (size_t i=0; i < aluPorts.size(); i++)
+	{
+		const AluPort &port = aluPorts[i];
+		if (!port.Input)
+			values[port.Slot] = alus[port.Alu]->Value(port.AluSlot);
+	}
+
+	for (size_t i=0; i < copies.size(); i++)
+	{
+		const Copy &copy = copies[i];
+		if (copy.BitSlice >= 0)
+			values[copy.Dest] = (values[copy.Source] >> copy.BitSlice) & 1;
+		else
+			values[copy.Dest] = values[copy.Source];
+	}
+}
+
+
+void DesignSimulator::Clock()
+{
+	// ALUs execute one instruction, and compute the outputs seen in the next cycle
+	for (size_t i=0; i < aluPorts.size(); i++)
+	{
+		const AluPort &port = aluPorts[i];
+		if (port.Input)
+			alus[port.Alu]->SetInput(port.AluSlot, values[port.Slot]);
+	}
+
+	for (size_t i=0; i < alus.size(); i++)
+	{
+		alus[i]->Evaluate();
+		alus[i]->Clock();
+		alus[i]->Evaluate();
+	}
+
+	for (size_t i=0; i < delays.size(); i++)
+	{
+		DelayLine &line = delays[i];
+		line.History[line.Position] = values[line.Source];
+		line.Position = (line.Position + 1) % line.History.size();
+	}
+
+	// TF registers all take their next values together
+	for (size_t i=0; i < tfs.size(); i++)
+		nextTFs[i] = Lookup(tfs[i]);
+	for (size_t i=0; i < tfs.size(); i++)
+		values[tfs[i].Dest] = nextTFs[i];
+
+	for (size_t i=0; i < rams.size(); i++)
+		ClockRam(rams[i]);
+}
+
+
+// Reads return the memory contents before a write in the same cycle.
+// With a width of 2, the second data port reads or writes the neighbouring entry, at the address with bit 0 inverted.
+void DesignSimulator::ClockRam(Ram &ram)
+{
+	bool wr = (values[ram.Wr] & 1) != (unsigned) ram.WrActiveLow;
+	bool rd = (values[ram.Rd] & 1) != (unsigned) ram.RdActiveLow;
+
+	unsigned read[2] = { 0, 0 };
+	if (rd)
+	{
+		int addr = values[ram.RdAddr] & (RAM_ENTRIES - 1);
+		for (int p=0; p < ram.RdWidth && p < 2; p++)
+			read[p] = ram.Memory[p ? (addr ^ 1) : addr];
+	}
+
+	if (wr)
+	{
+		int addr = values[ram.WrAddr] & (RAM_ENTRIES - 1);
+		for (int p=0; p < ram.WrWidth && p < 2; p++)
+		{
+			unsigned data = values[ram.WrData[p][0]] & 0xFFFF;
+			for (int t=0; t < 4; t++)
+				data |= (values[ram.WrData[p][1 + t]] & 1) << (16 + t);
+
+			static const unsigned masks[3] = { 0x0FF00, 0x000FF, 0xF0000 };
+			unsigned mask = 0;
+			for (int e=0; e < 3; e++)
+			{
+				int mode = ram.ByteEnableModes[p][e];
+				if (mode == 0 || (mode == 2 && (values[ram.ByteEnables[p][e]] & 1)))
+					mask |= masks[e];
+			}
+
+			unsigned &entry = ram.Memory[p ? (addr ^ 1) : addr];
+			entry = (entry & ~mask) | (data & mask);
+		}
+	}
+
+	// Outputs are registered, and cleared by flush
+	bool flush = values[ram.Flush] & 1;
+	if (rd || flush)
+	{
+		for (int p=0; p < 2; p++)
+		{
+			unsigned data = flush ? 0 : read[p];
+			values[ram.RdData[p][0]] = data & 0xFFFF;
+			for (int t=0; t < 4; t++)
+				values[ram.RdData[p][1 + t]] = (data >> (16 + t)) & 1;
+		}
+	}
+}
+
+
+void DesignSimulator::TraceHeader(FILE *f) const
+{
+	fprintf(f, "# Words are 17-bit hexadecimal, with the v-bit as the leading digit\n");
+	fprintf(f, "cycle");
+	for (size_t i=0; i < ports.size(); i++)
+		fprintf(f, "\t%s", ports[i]->Name());
+	fprintf(f, "\n");
+}
+
+void DesignSimulator::TraceCycle(FILE *f, int cycle) const
+{
+	fprintf(f, "%d", cycle);
+	for (size_t i=0; i < ports.size(); i++)
+	{
+		unsigned value = values[portSlots[i]];
+		if (ports[i]->DataType == DATA_TYPE_BIT)
+			fprintf(f, "\t%u", value & 1);
+		else
+			fprintf(f, "\t%05X", value & 0x1FFFF);
+	}
+	fprintf(f, "\n");
+}
+
+
+bool DesignSimulator::Run(const Stimulus &stimulus, int cycles, FILE *trace)
+{
+	// ALUs using functions without a model were reported when they were elaborated
+	bool ok = true;
+	for (size_t i=0; i < alus.size(); i++)
+	{
+		if (!alus[i]->Supported())
+			ok = false;
+	}
+
+	// Bind stimulus columns to top-level inputs
+	vector<int> inputs;
+	for (int c=0; c < stimulus.Columns(); c++)
+	{
+		const Signal *sig = top->GetSignal(stimulus.ColumnName(c));
+		if (!sig || sig->Direction != DIR_IN)
+		{
+			yyerrorfl(FileLocation(stimulus.Filename()), "Stimulus column '%s' is not an input of module '%s'", stimulus.ColumnName(c), top->Name());
+			ok = false;
+			continue;
+		}
+		inputs.push_back(SlotFor(0, sig));
+	}
+	if (!ok)
+		return false;
+
+	Reset();
+
+	if (trace)
+		TraceHeader(trace);
+
+	for (int cycle = 0; cycle < cycles; cycle++)
+	{
+		for (size_t c=0; c < inputs.size(); c++)
+			values[inputs[c]] = stimulus.Value(cycle, c) & 0x1FFFF;
+
+		Evaluate();
+		if (trace)
+			TraceCycle(trace, cycle);
+		Clock();
+	}
+
+	return true;
+}
@@ -0,0 +1,144 @@
+#ifndef DESIGN_SIMULATOR_H
+#define DESIGN_SIMULATOR_H
+
+#include "AluSimulator.h"
+#include "Module.h"
+#include "Stimulus.h"
+
+#include <stdio.h>
+#include <map>
+#include <string>
+#include <vector>
+using namespace std;
+
+
+// Compiled cycle-based simulator for a whole resolved design, used for system-level regressions
+// without Verilog simulation of the generated netlist.
+//
+// The design is flattened from the top module into one array of values:  every signal of every instance
+// is given a slot, with words as 17 bits including the v-bit.  Connections and bit-slices become copies
+// between slots, levelized once so that each cycle evaluates them in a single pass.  Delays are ring buffers,
+// TF registers are table lookups on their truth functions, ALUs run their programs with AluSimulator,
+// and RF_RAMs are 64 entries of 16-bit words with 4 tag bits.
+//
+// Each TF register is evaluated on its own, indexing its 16-bit truth table with its argument bits.  TFs are
+// not evaluated bit-parallel:  a slot holds one value of one run, and floating TFs are too few in a design for
+// packing them into machine words to pay for the gathering of their arguments.
+//
+// Outputs of silicon objects are registered:  a value computed in one cycle is seen by connected objects
+// in the next cycle.  Extern modules and other silicon objects are not simulated, and their outputs are 0,
+// with a warning.  These assumptions are checked by testDesignSimulator.
+class DesignSimulator
+{
+public:
+	DesignSimulator(const Module *top);
+	~DesignSimulator();
+
+	const Module *Top() const;
+
+	// Returns registers, memories and delays to their initial values, and restarts all ALU programs
+	void Reset();
+
+	// Computes every slot from the inputs and the registered state, then clocks all objects and delays
+	void Evaluate();
+	void Clock();
+
+	// Runs the design for a number of cycles, with top-level inputs from the stimulus columns,
+	// tracing the top-level ports once per cycle.
+	// Returns false, after reporting errors, if a stimulus column does not name an input of the top module,
+	// or if an ALU uses a function without a model in AluSimulator.
+	bool Run(const Stimulus &stimulus, int cycles, FILE *trace);
+
+private:
+	// One instance of a module within the flattened design
+	struct Context
+	{
+		const Module *Definition;
+		string Path;
+	};
+
+	// Slot computed from another slot within a cycle
+	struct Copy
+	{
+		int Dest;
+		int Source;
+		int BitSlice;               // -1 for a copy
+	};
+
+	struct DelayLine
+	{
+		int Dest;
+		int Source;
+		vector<unsigned> History;
+		int Position;
+	};
+
+	// TF register, clocked each cycle
+	struct Logic
+	{
+		int Dest;
+		int Args[4];
+		int Table;
+	};
+
+	// Connection between a slot of the design and a slot of an ALU
+	struct AluPort
+	{
+		int Alu;
+		int AluSlot;
+		int Slot;
+		bool Input;
+	};
+
+	// Registered RF_RAM memory
+	struct Ram
+	{
+		int Wr, WrAddr, Rd, RdAddr, Flush;
+		int WrData[2][5];           // Word, then tags 0 to 3
+		int ByteEnables[2][3];      // Slots of the bits15to8, bits7to0 and tags enables
+		int ByteEnableModes[2][3];  // 0 = active_always, 1 = active_never, 2 = active_high
+		int RdData[2][5];
+		int WrWidth, RdWidth;
+		bool WrActiveLow, RdActiveLow;
+		vector<unsigned> Init;
+		vector<unsigned> Memory;
+	};
+
+	int Elaborate(const Module *module, const string &path, vector<Copy> &unordered);
+	void ElaborateRam(int ctx, const Module *module);
+	int SlotFor(int ctx, const Signal *sig);
+	void Levelize(vector<Copy> &unordered);
+	void Warn(const Module *module, const char *what);
+	unsigned Lookup(const Logic &logic) const;
+	void ClockRam(Ram &ram);
+	void TraceHeader(FILE *f) const;
+	void TraceCycle(FILE *f, int cycle) const;
+
+	const Module *top;
+
+	vector<Context> contexts;
+	map<pair<int, const Instance*>, int> children;
+	map<pair<int, const Signal*>, int> slots;
+	vector<int> slotContexts;
+	vector<const Signal*> slotSignals;
+
+	vector<unsigned> values;
+	vector<pair<int, unsigned> > initialValues;
+	vector<bool> driven;            // Driven by a copy or by the stimulus
+
+	vector<Copy> copies;            // In evaluation order
+	vector<DelayLine> delays;
+	vector<Logic> tfs;
+	vector<unsigned> nextTFs;
+	vector<AluSimulator*> alus;
+	vector<int> aluContexts;
+	vector<AluPort> aluPorts;
+	vector<Ram> rams;
+
+	vector<const Signal*> ports;    // Top-level ports, traced each cycle
+	vector<int> portSlots;
+	vector<const Module*> warned;
+};
+
+
+#endif
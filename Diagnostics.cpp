@@ -0,0 +1,234 @@
+#include "Diagnostics.h"
+#include "Module.h"
+#include "parser.h"
+#include "FileIO.h"
+
+#include <stdlib.h>
+#include <algorithm>
+#include <vector>
+
+
+static const Module *scopeModule = NULL;
+
+DiagnosticScope::DiagnosticScope(const Module *module)
+{
+	outer = scopeModule;
+	scopeModule = module;
+}
+
+DiagnosticScope::~DiagnosticScope()
+{
+	scopeModule = outer;
+}
+
+string DiagnosticModuleName()
+{
+	if (scopeModule)
+		return scopeModule->MangledName();
+	if (module)
+		return module->MangledName();
+	return "";
+}
+
+
+static const char *SeverityName(DiagnosticSeverity severity)
+{
+	switch (severity)
+	{
+		case DIAGNOSTIC_WARNING:    return "WARNING";
+		case DIAGNOSTIC_ERROR:      return "ERROR";
+		case DIAGNOSTIC_FATAL:      return "FATAL";
+	}
+	return "?";
+}
+
+
+bool DiagnosticsEngine::Entry::operator<(const Entry &entry) const
+{
+	if (Filename != entry.Filename)
+		return Filename < entry.Filename;
+	if (Line != entry.Line)
+		return Line < entry.Line;
+	return Message < entry.Message;
+}
+
+bool DiagnosticsEngine::GroupKey::operator<(const GroupKey &key) const
+{
+	if (Severity != key.Severity)
+		return Severity < key.Severity;
+	if (Kind != key.Kind)
+		return Kind < key.Kind;
+	return Module < key.Module;
+}
+
+DiagnosticsEngine::Group::Group()
+{
+	First = 0;
+	Suppressed = 0;
+}
+
+
+DiagnosticsEngine *DiagnosticsEngine::installed = NULL;
+
+DiagnosticsEngine::DiagnosticsEngine()
+{
+	Limit = 100;
+	Json = false;
+	arrivals = 0;
+	previousHandler = NULL;
+}
+
+DiagnosticsEngine::~DiagnosticsEngine()
+{
+	Uninstall();
+}
+
+void DiagnosticsEngine::Install()
+{
+	if (installed == this)
+		return;
+
+	previousHandler = diagnosticHandler;
+	diagnosticHandler = Handle;
+	installed = this;
+}
+
+void DiagnosticsEngine::Uninstall()
+{
+	if (installed != this)
+		return;
+
+	diagnosticHandler = previousHandler;
+	installed = NULL;
+}
+
+void DiagnosticsEngine::Handle(DiagnosticSeverity severity, SourceCodeLocation loc, const char *kind, const char *message)
+{
+	installed->Add(severity, loc, kind, message);
+}
+
+
+void DiagnosticsEngine::Add(DiagnosticSeverity severity, SourceCodeLocation loc, const char *kind, const char *message)
+{
+	GroupKey key;
+	key.Severity = severity;
+	key.Kind = kind;
+	key.Module = DiagnosticModuleName();
+
+	Entry entry;
+	entry.Filename = loc.Filename ? loc.Filename : "";
+	entry.Line = loc.Line;
+	entry.Message = message;
+
+	pair<GroupMap::iterator, bool> inserted = groups.insert(make_pair(key, Group()));
+	Group &group = inserted.first->second;
+	if (inserted.second)
+		group.First = arrivals;
+	arrivals++;
+
+	// Repeats, and diagnostics past the limit, are only counted
+	bool full = (Limit > 0 && severity != DIAGNOSTIC_FATAL && (int) group.Shown.size() >= Limit);
+	if (full || !group.ShownSet.insert(entry).second)
+	{
+		group.Suppressed++;
+		return;
+	}
+
+	group.Shown.push_back(entry);
+}
+
+
+bool DiagnosticsEngine::CompareFirst(const Ordered &a, const Ordered &b)
+{
+	return a.first < b.first;
+}
+
+void DiagnosticsEngine::Flush(FILE *f)
+{
+	if (groups.empty())
+		return;
+
+	// Groups in the order of their first diagnostic
+	vector<Ordered> order;
+	for (GroupMap::const_iterator it = groups.begin(); it != groups.end(); ++it)
+		order.push_back(Ordered(it->second.First, it));
+	sort(order.begin(), order.end(), CompareFirst);
+
+	// Written as a whole, rather than a write per line on unbuffered stderr
+	char *buffer = NULL;
+	size_t length = 0;
+	FILE *memory = open_memstream(&buffer, &length);
+	FILE *out = memory ? memory : f;
+
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		const GroupKey &key = order[i].second->first;
+		const Group &group = order[i].second->second;
+
+		for (size_t j = 0; j < group.Shown.size(); j++)
+			WriteEntry(out, key, group.Shown[j]);
+		if (group.Suppressed)
+			WriteSummary(out, key, group);
+	}
+
+	if (memory)
+	{
+		fclose(memory);
+		fwrite(buffer, 1, length, f);
+		free(buffer);
+	}
+	fflush(f);
+
+	groups.clear();
+	arrivals = 0;
+}
+
+
+void DiagnosticsEngine::WriteEntry(FILE *f, const GroupKey &key, const Entry &entry) const
+{
+	DiagnosticSeverity severity = (DiagnosticSeverity) key.Severity;
+	if (Json)
+	{
+		fprintf(f, "{\"severity\":\"%s\",\"kind\":", SeverityName(severity));
+		WriteJsonString(f, key.Kind.c_str());
+		fprintf(f, ",\"module\":");
+		WriteJsonString(f, key.Module.c_str());
+		fprintf(f, ",\"file\":");
+		WriteJsonString(f, entry.Filename.c_str());
+		fprintf(f, ",\"line\":%d,\"message\":", entry.Line);
+		WriteJsonString(f, entry.Message.c_str());
+		fprintf(f, "}\n");
+	}
+	else
+	{
+		// Diagnostics about a whole file, or about nothing in the sources, have no line
+		if (entry.Line <= 0 && !entry.Filename.empty())
+			fprintf(f, "%s in %s: %s\n", SeverityName(severity), entry.Filename.c_str(), entry.Message.c_str());
+		else if (entry.Line <= 0)
+			fprintf(f, "%s - %s\n", SeverityName(severity), entry.Message.c_str());
+		else if (!entry.Filename.empty())
+			fprintf(f, "%s in %s on line %d: %s\n", SeverityName(severity), entry.Filename.c_str(), entry.Line, entry.Message.c_str());
+		else
+			fprintf(f, "%s on line %d: %s\n", SeverityName(severity), entry.Line, entry.Message.c_str());
+	}
+}
+
+void DiagnosticsEngine::WriteSummary(FILE *f, const GroupKey &key, const Group &group) const
+{
+	DiagnosticSeverity severity = (DiagnosticSeverity) key.Severity;
+	if (Json)
+	{
+		fprintf(f, "{\"severity\":\"%s\",\"kind\":", SeverityName(severity));
+		WriteJsonString(f, key.Kind.c_str());
+		fprintf(f, ",\"module\":");
+		WriteJsonString(f, key.Module.c_str());
+		fprintf(f, ",\"suppressed\":%d}\n", group.Suppressed);
+	}
+	else
+	{
+		if (key.Module.empty())
+			fprintf(f, "%s: %d more like \"%s\"\n", SeverityName(severity), group.Suppressed, key.Kind.c_str());
+		else
+			fprintf(f, "%s: %d more like \"%s\" in module %s\n", SeverityName(severity), group.Suppressed, key.Kind.c_str(), key.Module.c_str());
+	}
+}
@@ -0,0 +1,109 @@
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include "Common.h"
+
+#include <stdio.h>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+using namespace std;
+
+class Module;
+
+
+// Marks the module processed by a pass, for the diagnostics reported while the scope exists.  Scopes nest.
+class DiagnosticScope
+{
+public:
+	DiagnosticScope(const Module *module);
+	~DiagnosticScope();
+
+private:
+	const Module *outer;
+};
+
+// Mangled name of the module diagnostics are reported for, from the innermost DiagnosticScope,
+// or else the module being parsed.  Empty if there is none.
+extern string DiagnosticModuleName();
+
+
+// Buffers errors and warnings, and writes them grouped by kind and module, at most Limit of each group.
+//
+// The kind of a diagnostic is its severity and format string, such as "No connections made to wire '%s'", and
+// its module is the one from DiagnosticModuleName.  Groups are written in the order of their first diagnostic,
+// and the first Limit diagnostics of each group in the order they arrived, so the first error, which is usually
+// the cause of the rest, is always shown.  Repeats of a diagnostic shown, and diagnostics past the limit, are
+// counted, and summarized for their group.  Only the diagnostics shown are kept, so memory does not grow with
+// their number.
+//
+// Fatal errors are never held back by the limit.  Counts in errorCount and warnCount are unchanged, and -w
+// still turns warnings into errors before they arrive here.
+class DiagnosticsEngine
+{
+public:
+	DiagnosticsEngine();
+	virtual ~DiagnosticsEngine();
+
+	// Receive diagnostics through diagnosticHandler, until Uninstall.  Only one engine may be installed.
+	void Install();
+	void Uninstall();
+
+	// Writes and clears the diagnostics received so far
+	void Flush(FILE *f);
+
+	int Limit;                  // Diagnostics written of each group, 0 for no limit
+	bool Json;                  // Write one JSON object per line, rather than text
+
+private:
+	struct Entry
+	{
+		string Filename;
+		int Line;
+		string Message;
+
+		bool operator<(const Entry &entry) const;
+	};
+
+	// Severity, format string and module of the diagnostics in a group
+	struct GroupKey
+	{
+		int Severity;
+		string Kind;
+		string Module;
+
+		bool operator<(const GroupKey &key) const;
+	};
+
+	struct Group
+	{
+		Group();
+
+		int First;                  // Arrival of the first diagnostic of this group
+		vector<Entry> Shown;        // In arrival order
+		set<Entry> ShownSet;        // For finding repeats
+		int Suppressed;
+	};
+
+	typedef map<GroupKey, Group> GroupMap;
+
+	// Group with its first arrival, for ordering output
+	typedef pair<int, GroupMap::const_iterator> Ordered;
+	static bool CompareFirst(const Ordered &a, const Ordered &b);
+
+	void Add(DiagnosticSeverity severity, SourceCodeLocation loc, const char *kind, const char *message);
+	void WriteEntry(FILE *f, const GroupKey &key, const Entry &entry) const;
+	void WriteSummary(FILE *f, const GroupKey &key, const Group &group) const;
+
+	static void Handle(DiagnosticSeverity severity, SourceCodeLocation loc, const char *kind, const char *message);
+
+	GroupMap groups;
+	int arrivals;
+	DiagnosticHandler previousHandler;
+
+	static DiagnosticsEngine *installed;
+};
+
+
+#endif
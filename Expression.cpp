@@ -793,12 +793,14 @@ Expression Expression::Ternary(const Expression &op1, const Expression &op2) con
 ExpressionArray::ExpressionArray(int initial_size)
 	: values(initial_size), refCount(0), recursionGuard(false)
 {
+	TrackCapacity(0);
 	IncRef();
 }
 
 ExpressionArray::ExpressionArray(const ExpressionArray &expr)
 	: values(expr.values), refCount(0), recursionGuard(false)
 {
+	TrackCapacity(0);
 	IncRef();
 
 	// Increment the reference count of all contained expression values
@@ -809,6 +811,11 @@ ExpressionArray::ExpressionArray(const ExpressionArray &expr)
 	}
 }
 
+ExpressionArray::~ExpressionArray()
+{
+	AllocTrackBytes(ALLOC_EXPRESSION_ARRAY, -(long) (values.capacity() * sizeof(Expression)));
+}
+
 
 void ExpressionArray::Print(FILE *f) const
 {
@@ -839,11 +846,19 @@ void ExpressionArray::Print(FILE *f) const
 	recursionGuard = false;
 }
 
+void ExpressionArray::TrackCapacity(size_t oldCapacity) const
+{
+	if (values.capacity() != oldCapacity)
+		AllocTrackBytes(ALLOC_EXPRESSION_ARRAY, ((long) values.capacity() - (long) oldCapacity) * sizeof(Expression));
+}
+
 // Append a value to the array
 // Also increment the stored value reference count
 void ExpressionArray::AddValue(const Expression &value)
 {
+	size_t oldCapacity = values.capacity();
 	values.push_back(value);
+	TrackCapacity(oldCapacity);
 	value.IncRef();
 }
 
@@ -876,7 +891,9 @@ bool ExpressionArray::SetValue(int index, const Expression &value)
 	// and fill in with Unknown expression values
 	if (index >= Count())
 	{
+		size_t oldCapacity = values.capacity();
 		values.resize(index+1, Expression::Unknown());
+		TrackCapacity(oldCapacity);
 	}
 	else
 	{
@@ -4,6 +4,7 @@
 
 #include "TruthFunction.h"
 #include "AluFunctionCall.h"
+#include "AllocTracked.h"
 #include <stdio.h>
 
 #include <vector>
@@ -128,7 +129,7 @@ struct Expression
 };
 
 // Array of expressions, managed with a reference count
-struct ExpressionArray
+struct ExpressionArray : public AllocTracked<ALLOC_EXPRESSION_ARRAY>
 {
 	// Constructor creates an array with optional initial_size
 	ExpressionArray(int initial_size = 0);
@@ -136,6 +137,8 @@ struct ExpressionArray
 	// Copy constructor creates a shallow copy
 	ExpressionArray(const ExpressionArray &expr);
 
+	~ExpressionArray();
+
 	// Appends a value to the array.  Used during array construction while parsing.
 	// This also increments the RefCount of the value, because it is held in a new data structure.
 	// It is decremented when this array is deleted.
@@ -166,6 +169,9 @@ private:
 	// The values in the array
 	vector<Expression> values;
 
+	// Accounts for a change in the storage of values, from an old capacity
+	void TrackCapacity(size_t oldCapacity) const;
+
 	// Reference count maintained per ExpressionArray.  Used to self-delete when it reaches zero.
 	mutable int refCount;
 
@@ -59,31 +59,34 @@ const SiliconObjectDefinition *FPOA::Definition() const
 	return BuiltinDefinition();
 }
 
-const SiliconObjectDefinition *FPOA::BuiltinDefinition()
+// FPOA_CONTROL Signals
+static const PortTableEntry fpoaPorts[] =
 {
-	// Return singleton instance if already created
-	if (definition)
-		return definition;
-
-	// Create a new builtin singleton symbol table instance
-	SymbolTable *symbols = new SymbolTable(true);
-
+	{ "core_clock",     DATA_TYPE_BIT,  DIR_NONE },
+};
 
-	// FPOA_CONTROL Signals
-	symbols->Add(new Signal("core_clock",						BEHAVIOR_BUILTIN, DATA_TYPE_BIT,  DIR_NONE ));
+// FPOA_CONTROL Parameters
+static const char *const fpoaDevices[] =        {"moa3600mx", "moa3600vx"};
+static const long fpoaCoreClkFreqs[] =          {600, 800, 1000, 1200};
 
+static const ParameterTableEntry fpoaParameters[] =
+{
+	TABLE_PARAM_STRING(     "fpoa_base_dir",    "./"),
+	TABLE_PARAM_ENUM(       "device",           fpoaDevices, "moa3600mx"),
+	TABLE_PARAM_ENUM_INT(   "core_clk_freq",    fpoaCoreClkFreqs, 1000),
+};
 
-	// FPOA_CONTROL Parameters
-	const char *devices[] =				{"moa3600mx", "moa3600vx"};
-	long core_clk_freqs[] =				{600, 800, 1000, 1200};
+const BuiltinObjectTable FPOA::Table = { "FPOA", fpoaPorts, countof(fpoaPorts), fpoaParameters, countof(fpoaParameters) };
 
-	symbols->Add(new ParameterDefinition("fpoa_base_dir",	"./"));
-	symbols->Add(new ParameterDefinition("device",			devices, countof(devices), "moa3600mx"));
-	symbols->Add(new ParameterDefinition("core_clk_freq",	core_clk_freqs, countof(core_clk_freqs), 1000));
 
+const SiliconObjectDefinition *FPOA::BuiltinDefinition()
+{
+	// Return singleton instance if already created
+	if (definition)
+		return definition;
 
-	// Create a new singleton definition
-	definition = new SiliconObjectDefinition("FPOA", symbols, FPOA_Factory);
+	// Create a new singleton definition from the static table
+	definition = new SiliconObjectDefinition(Table, FPOA_Factory);
 
 	return definition;
 }
@@ -25,11 +25,12 @@ public:
 	virtual bool AssignResources();
 
 	// Defined in FPOA_GenerateVerilog
-	virtual void GenerateVerilog(FILE *f) const;
+	virtual void GenerateVerilog(FILE *f, bool neutralName = false) const;
 
 	// Provide definition on instances as well as via a static method
 	virtual const SiliconObjectDefinition *Definition() const;
 	static  const SiliconObjectDefinition *BuiltinDefinition();
+	static  const BuiltinObjectTable Table;
 
 protected:
 
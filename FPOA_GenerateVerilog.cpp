@@ -3,20 +3,20 @@
 #include "Common.h"
 
 
-void FPOA::GenerateVerilog(FILE *f) const
+void FPOA::GenerateVerilog(FILE *f, bool neutralName) const
 {
 	// Identical to Module::GenerateVerilog, except that it also generates an FPOA_CONTROL object
 
 	F0("\n");
 
 	F0("//\n");
-	F2("// ================ %s - %s ================\n", (ParentModule()) ? "InnerModule" : "Module", Name());
+	F2("// ================ %s - %s ================\n", (ParentModule()) ? "InnerModule" : "Module", VerilogLocalName(neutralName));
 	F0("//\n");
 
 	// module ModuleName (
 	// );
 	F0("module ");
-	GenerateVerilogModuleName(f);
+	GenerateVerilogModuleName(f, neutralName);
 	F0(" (\n");
 	F0(");\n");
 
@@ -65,19 +65,5 @@ void FPOA::GenerateVerilog(FILE *f) const
 	// endmodule
 	F0("\nendmodule\n");
 	F0("\n");
-
-
-	//
-	// Recursively generate inner modules
-	//
-	int nmodules = InnerModuleCount();
-	for (int i=0; i < nmodules; i++)
-	{
-		const Module *innerModule = GetInnerModule(i);
-		if (innerModule)
-		{
-			innerModule->GenerateVerilog(f);
-		}
-	}
 }
 
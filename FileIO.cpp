@@ -0,0 +1,560 @@
+#include "FileIO.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+using namespace std;
+
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+
+CompressionType FileCompressionType(const char *filename)
+{
+	int len = strlen(filename);
+
+	if (len > 3 && strcmp(filename + len - 3, ".gz") == 0)
+		return COMPRESSION_GZIP;
+
+	if (len > 4 && strcmp(filename + len - 4, ".zst") == 0)
+		return COMPRESSION_ZSTD;
+
+	return COMPRESSION_NONE;
+}
+
+
+#ifdef HAVE_ZLIB
+
+//
+// gzip through zlib, as a stdio stream.  Output has no name or timestamp in its header, like gzip -n.
+//
+static ssize_t GzipRead(void *cookie, char *buf, size_t size)
+{
+	int n = gzread((gzFile) cookie, buf, size);
+	return n < 0 ? -1 : n;
+}
+
+static ssize_t GzipWrite(void *cookie, const char *buf, size_t size)
+{
+	if (size == 0)
+		return 0;
+
+	// gzwrite returns 0 on error
+	int n = gzwrite((gzFile) cookie, buf, size);
+	return n <= 0 ? -1 : n;
+}
+
+static int GzipClose(void *cookie)
+{
+	return gzclose((gzFile) cookie) == Z_OK ? 0 : -1;
+}
+
+static FILE *OpenGzipFile(const char *filename, bool writing)
+{
+	gzFile gz = gzopen(filename, writing ? "wb" : "rb");
+	if (!gz)
+		return NULL;
+
+	cookie_io_functions_t functions = { GzipRead, GzipWrite, NULL, GzipClose };
+	FILE *file = fopencookie(gz, writing ? "w" : "r", functions);
+	if (!file)
+		gzclose(gz);
+
+	return file;
+}
+
+#endif
+
+
+#ifdef HAVE_ZSTD
+
+//
+// zstd through libzstd, as a stdio stream.  Compression is split into blocks across a worker per core,
+// and the output does not depend on the number of workers.
+//
+struct ZstdFile
+{
+	FILE *file;
+	ZSTD_CCtx *cctx;
+	ZSTD_DCtx *dctx;
+	vector<char> buffer;
+	ZSTD_inBuffer input;        // Compressed input read from file, when decompressing
+	bool ok;
+};
+
+// Write all of the compressed output of one step, returning false on any error
+static bool ZstdCompress(ZstdFile *z, ZSTD_inBuffer &in, ZSTD_EndDirective mode)
+{
+	for (;;)
+	{
+		ZSTD_outBuffer out = { &z->buffer[0], z->buffer.size(), 0 };
+		size_t remaining = ZSTD_compressStream2(z->cctx, &out, &in, mode);
+		if (ZSTD_isError(remaining))
+			return false;
+		if (fwrite(out.dst, 1, out.pos, z->file) != out.pos)
+			return false;
+
+		bool done = (mode == ZSTD_e_end) ? (remaining == 0) : (in.pos == in.size);
+		if (done)
+			return true;
+	}
+}
+
+static ssize_t ZstdWrite(void *cookie, const char *buf, size_t size)
+{
+	ZstdFile *z = (ZstdFile *) cookie;
+	ZSTD_inBuffer in = { buf, size, 0 };
+	if (!ZstdCompress(z, in, ZSTD_e_continue))
+	{
+		z->ok = false;
+		return -1;
+	}
+	return size;
+}
+
+static ssize_t ZstdRead(void *cookie, char *buf, size_t size)
+{
+	ZstdFile *z = (ZstdFile *) cookie;
+	ZSTD_outBuffer out = { buf, size, 0 };
+
+	// Decompress until some output is produced, or the input ends
+	while (out.pos == 0)
+	{
+		if (z->input.pos == z->input.size)
+		{
+			z->input.src = &z->buffer[0];
+			z->input.size = fread(&z->buffer[0], 1, z->buffer.size(), z->file);
+			z->input.pos = 0;
+			if (z->input.size == 0)
+				return ferror(z->file) ? -1 : 0;
+		}
+
+		size_t result = ZSTD_decompressStream(z->dctx, &out, &z->input);
+		if (ZSTD_isError(result))
+			return -1;
+	}
+	return out.pos;
+}
+
+static int ZstdClose(void *cookie)
+{
+	ZstdFile *z = (ZstdFile *) cookie;
+	bool ok = z->ok;
+
+	if (z->cctx)
+	{
+		ZSTD_inBuffer in = { NULL, 0, 0 };
+		if (ok && !ZstdCompress(z, in, ZSTD_e_end))
+			ok = false;
+		ZSTD_freeCCtx(z->cctx);
+	}
+	if (z->dctx)
+		ZSTD_freeDCtx(z->dctx);
+
+	if (fclose(z->file) != 0)
+		ok = false;
+
+	delete z;
+	return ok ? 0 : -1;
+}
+
+static FILE *OpenZstdFile(const char *filename, bool writing)
+{
+	FILE *f = fopen(filename, writing ? "wb" : "rb");
+	if (!f)
+		return NULL;
+
+	ZstdFile *z = new ZstdFile;
+	z->file = f;
+	z->cctx = NULL;
+	z->dctx = NULL;
+	z->input.src = NULL;
+	z->input.size = 0;
+	z->input.pos = 0;
+	z->ok = true;
+
+	if (writing)
+	{
+		z->cctx = ZSTD_createCCtx();
+		z->buffer.resize(ZSTD_CStreamOutSize());
+
+		// Workers are only available when libzstd is built multithreaded, and are otherwise ignored
+		long cores = sysconf(_SC_NPROCESSORS_ONLN);
+		ZSTD_CCtx_setParameter(z->cctx, ZSTD_c_checksumFlag, 1);
+		ZSTD_CCtx_setParameter(z->cctx, ZSTD_c_nbWorkers, cores > 1 ? (int) cores : 1);
+	}
+	else
+	{
+		z->dctx = ZSTD_createDCtx();
+		z->buffer.resize(ZSTD_DStreamInSize());
+	}
+
+	cookie_io_functions_t functions = { ZstdRead, ZstdWrite, NULL, ZstdClose };
+	FILE *file = NULL;
+	if (z->cctx || z->dctx)
+		file = fopencookie(z, writing ? "w" : "r", functions);
+
+	if (!file)
+	{
+		z->ok = false;
+		ZstdClose(z);
+	}
+	return file;
+}
+
+#endif
+
+
+//
+// Formats without a library at build time go through an external tool.
+// Output is written to a temporary file, which only replaces the file once the tool has succeeded,
+// so that a missing tool does not leave an empty file in place of the previous one.
+//
+struct PipedFile
+{
+	FILE *file;
+	string tempFilename;        // Empty when reading
+	string filename;
+};
+
+static vector<PipedFile> pipedFiles;
+
+
+// Quote a filename for use in a shell command
+static string ShellQuote(const char *filename)
+{
+	string quoted = "'";
+	for (const char *p = filename; *p; p++)
+	{
+		if (*p == '\'')
+			quoted += "'\\''";
+		else
+			quoted += *p;
+	}
+	quoted += "'";
+	return quoted;
+}
+
+static FILE *OpenPipedFile(const char *filename, CompressionType compression, bool writing)
+{
+	PipedFile piped;
+	piped.filename = filename;
+	if (writing)
+		piped.tempFilename = TemporaryFilename(filename);
+
+	// Make sure the file can be opened before handing it to the tool, so errors are reported the same way
+	const char *target = writing ? piped.tempFilename.c_str() : filename;
+	FILE *check = fopen(target, writing ? "w" : "r");
+	if (!check)
+		return NULL;
+	fclose(check);
+
+	// pigz is a parallel block compressor, which falls back to gzip for an identical format
+	string command;
+	if (compression == COMPRESSION_GZIP)
+	{
+		if (writing)
+			command = "(command -v pigz >/dev/null 2>&1 && exec pigz -c -n || exec gzip -c -n) > ";
+		else
+			command = "gzip -dc < ";
+	}
+	else
+	{
+		if (writing)
+			command = "zstd -q -c -T0 > ";
+		else
+			command = "zstd -q -dc < ";
+	}
+	command += ShellQuote(target);
+
+	piped.file = popen(command.c_str(), writing ? "w" : "r");
+	if (!piped.file)
+	{
+		if (writing)
+			remove(target);
+		return NULL;
+	}
+
+	pipedFiles.push_back(piped);
+	return piped.file;
+}
+
+
+// Returns true if pigz is found in PATH, looking only once
+static bool HavePigz()
+{
+	static int found = -1;
+	if (found >= 0)
+		return found;
+
+	found = 0;
+	const char *path = getenv("PATH");
+	while (path && *path && !found)
+	{
+		const char *end = strchr(path, ':');
+		if (!end)
+			end = path + strlen(path);
+
+		string program(path, end - path);
+		program += program.empty() ? "pigz" : "/pigz";
+		if (access(program.c_str(), X_OK) == 0)
+			found = 1;
+
+		path = *end ? end + 1 : end;
+	}
+	return found;
+}
+
+
+FILE *OpenFile(const char *filename, const char *mode)
+{
+	CompressionType compression = FileCompressionType(filename);
+	bool writing = (mode[0] == 'w');
+
+#ifdef HAVE_ZLIB
+	// zlib compresses on one core, so gzip output goes through pigz when it is installed
+	if (compression == COMPRESSION_GZIP && !(writing && HavePigz()))
+		return OpenGzipFile(filename, writing);
+#endif
+#ifdef HAVE_ZSTD
+	if (compression == COMPRESSION_ZSTD)
+		return OpenZstdFile(filename, writing);
+#endif
+
+	if (compression == COMPRESSION_NONE)
+		return fopen(filename, mode);
+
+	return OpenPipedFile(filename, compression, writing);
+}
+
+
+bool CloseFile(FILE *file)
+{
+	for (int i=0; i < (int) pipedFiles.size(); i++)
+	{
+		if (pipedFiles[i].file == file)
+		{
+			PipedFile piped = pipedFiles[i];
+			pipedFiles.erase(pipedFiles.begin() + i);
+
+			// pclose returns the exit status of the compression tool
+			bool ok = (pclose(file) == 0);
+			if (!piped.tempFilename.empty())
+			{
+				if (ok)
+					ok = ReplaceFile(piped.tempFilename.c_str(), piped.filename.c_str());
+				else
+					remove(piped.tempFilename.c_str());
+			}
+			return ok;
+		}
+	}
+
+	bool ok = (ferror(file) == 0);
+	if (fclose(file) != 0)
+		ok = false;
+
+	return ok;
+}
+
+
+const char *TemporaryFilename(const char *filename)
+{
+	// Insert a hidden, process-specific prefix before the base name, so that the
+	// temporary file is on the same file system and keeps any compression extension
+	static string tempFilename;
+
+	const char *base = strrchr(filename, '/');
+	base = base ? base + 1 : filename;
+
+	char prefix[32];
+	sprintf(prefix, ".%d.", (int) getpid());
+
+	tempFilename.assign(filename, base - filename);
+	tempFilename += prefix;
+	tempFilename += base;
+
+	return tempFilename.c_str();
+}
+
+
+bool ReplaceFile(const char *tempFilename, const char *filename)
+{
+	// Keep the permissions of the file being replaced
+	struct stat st;
+	if (stat(filename, &st) == 0)
+		chmod(tempFilename, st.st_mode & 07777);
+
+	if (rename(tempFilename, filename) != 0)
+	{
+		remove(tempFilename);
+		return false;
+	}
+
+	return true;
+}
+
+
+//
+// Files written only if changed go to a temporary file, through a stream which hashes the content as it is
+// written.  On closing, the content of the existing file is hashed and compared, without reading back the new one.
+//
+struct ChangeCheckedFile
+{
+	FILE *stream;               // Stream returned to the caller
+	FILE *file;                 // Temporary file, from OpenFile
+	string tempFilename;
+	string filename;
+	uint64_t hash;
+	uint64_t size;
+};
+
+static vector<ChangeCheckedFile*> changeCheckedFiles;
+
+// 64-bit FNV-1a, continued from hash
+static uint64_t HashBytes(uint64_t hash, const char *data, size_t size)
+{
+	for (size_t i=0; i < size; i++)
+	{
+		hash ^= (unsigned char) data[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+#define HASH_START (14695981039346656037ULL)
+
+static ssize_t ChangeCheckedWrite(void *cookie, const char *buf, size_t size)
+{
+	ChangeCheckedFile *checked = (ChangeCheckedFile *) cookie;
+	checked->hash = HashBytes(checked->hash, buf, size);
+	checked->size += size;
+
+	if (fwrite(buf, 1, size, checked->file) != size)
+		return -1;
+	return size;
+}
+
+static int ChangeCheckedClose(void *cookie)
+{
+	return 0;
+}
+
+// Hashes the content of an existing file, decompressing it like OpenFile.  Returns false if it cannot be read.
+static bool HashFile(const char *filename, uint64_t &hash, uint64_t &size)
+{
+	FILE *f = OpenFile(filename, "r");
+	if (!f)
+		return false;
+
+	hash = HASH_START;
+	size = 0;
+
+	char buf[65536];
+	size_t n;
+	while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+	{
+		hash = HashBytes(hash, buf, n);
+		size += n;
+	}
+
+	return CloseFile(f);
+}
+
+
+FILE *OpenFileIfChanged(const char *filename)
+{
+	ChangeCheckedFile *checked = new ChangeCheckedFile;
+	checked->tempFilename = TemporaryFilename(filename);
+	checked->filename = filename;
+	checked->hash = HASH_START;
+	checked->size = 0;
+
+	checked->file = OpenFile(checked->tempFilename.c_str(), "w");
+	if (!checked->file)
+	{
+		delete checked;
+		return NULL;
+	}
+
+	cookie_io_functions_t functions = { NULL, ChangeCheckedWrite, NULL, ChangeCheckedClose };
+	checked->stream = fopencookie(checked, "w", functions);
+	if (!checked->stream)
+	{
+		CloseFile(checked->file);
+		remove(checked->tempFilename.c_str());
+		delete checked;
+		return NULL;
+	}
+
+	changeCheckedFiles.push_back(checked);
+	return checked->stream;
+}
+
+
+bool CloseFileIfChanged(FILE *file, bool &changed)
+{
+	ChangeCheckedFile *checked = NULL;
+	for (int i=0; i < (int) changeCheckedFiles.size(); i++)
+	{
+		if (changeCheckedFiles[i]->stream == file)
+		{
+			checked = changeCheckedFiles[i];
+			changeCheckedFiles.erase(changeCheckedFiles.begin() + i);
+			break;
+		}
+	}
+	if (!checked)
+		return false;
+
+	// Closing the stream flushes its last writes into the temporary file, and so into the hash
+	bool ok = (ferror(file) == 0);
+	if (fclose(file) != 0)
+		ok = false;
+	if (!CloseFile(checked->file))
+		ok = false;
+
+	const char *tempFilename = checked->tempFilename.c_str();
+	const char *filename = checked->filename.c_str();
+
+	uint64_t hash, size;
+	changed = true;
+	if (!ok)
+		remove(tempFilename);
+	else if (HashFile(filename, hash, size) && hash == checked->hash && size == checked->size)
+	{
+		changed = false;
+		remove(tempFilename);
+	}
+	else
+		ok = ReplaceFile(tempFilename, filename);
+
+	delete checked;
+	return ok;
+}
+
+
+void WriteJsonString(FILE *f, const char *s)
+{
+	fputc('"', f);
+	for (; *s; s++)
+	{
+		unsigned char c = (unsigned char) *s;
+		if (c == '"' || c == '\\')
+			fprintf(f, "\\%c", c);
+		else if (c < 0x20)
+			fprintf(f, "\\u%04x", c);
+		else
+			fputc(c, f);
+	}
+	fputc('"', f);
+}
@@ -0,0 +1,46 @@
+#ifndef FILE_IO_H
+#define FILE_IO_H
+
+#include <stdio.h>
+
+// Compression formats selected by filename extension
+enum CompressionType
+{
+	COMPRESSION_NONE,
+	COMPRESSION_GZIP,       // .gz
+	COMPRESSION_ZSTD        // .zst
+};
+
+extern CompressionType FileCompressionType(const char *filename);
+
+// Opens a file for reading ("r") or writing ("w").
+// Compressed files are streamed through zlib or libzstd when found at build time (HAVE_ZLIB, HAVE_ZSTD),
+// with zstd compression spread across all cores.  gzip output still goes through pigz when it is installed,
+// since zlib compresses on one core.  Without the libraries, an external tool is used (pigz or gzip, zstd -T0).
+// Output through a tool is written to a temporary file which only replaces the file once the tool succeeds.
+// Files opened here must be closed with CloseFile.
+extern FILE *OpenFile(const char *filename, const char *mode);
+
+// Closes a file from OpenFile.  Returns false if writing or the compression tool failed.
+extern bool CloseFile(FILE *file);
+
+// Name of a temporary file in the same directory as filename, keeping its extension
+extern const char *TemporaryFilename(const char *filename);
+
+// Moves the temporary file over filename, keeping the permissions of the file it replaces.
+// Returns false if the file could not be replaced, and the temporary file is then removed.
+extern bool ReplaceFile(const char *tempFilename, const char *filename);
+
+// Opens a file for writing, through a temporary file which only replaces it if the content changed.
+// The content is hashed while it is written, and compared with the existing file (decompressed) on closing.
+// Files opened here must be closed with CloseFileIfChanged.
+extern FILE *OpenFileIfChanged(const char *filename);
+
+// Closes a file from OpenFileIfChanged, leaving filename untouched if its content is the same.
+// Returns false if the file could not be written or replaced.
+extern bool CloseFileIfChanged(FILE *file, bool &changed);
+
+// Writes s as a quoted JSON string, escaping quotes, backslashes and control characters
+extern void WriteJsonString(FILE *f, const char *s);
+
+#endif
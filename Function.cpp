@@ -7,7 +7,7 @@
 
 // Function
 
-Function::Function(const char *name, const char *args)
+Function::Function(const char *name, const char *args, StringBuffer *keyStrings)
 	: Symbol(name), args(args)
 {
 	// Initialize function key in SymbolTable to "name__nargs", e.g. "log2__1"
@@ -15,13 +15,30 @@ Function::Function(const char *name, const char *args)
 	if (args)
 		nargs = strlen(args);
 
-	key = (char *) malloc(strlen(name) + 8);
-	sprintf(key, "%s__%d", name, nargs);
+	key = MakeKey(name, nargs, keyStrings);
 }
 
 Function::~Function()
 {
-	free((void*) key);
+}
+
+// Builds a key of the form "name__nargs" in the given or global string buffer
+const char *Function::MakeKey(const char *name, int nargs, StringBuffer *buffer)
+{
+	if (buffer == NULL)
+		buffer = strings;
+
+	StartKey(name, nargs, buffer);
+	return buffer->FinishString();
+}
+
+// Starts a key as the string in progress, without finishing it
+void Function::StartKey(const char *name, int nargs, StringBuffer *buffer)
+{
+	buffer->StartString();
+	buffer->AppendString(name);
+	buffer->AppendString("__");
+	buffer->AppendInt(nargs);
 }
 
 int Function::NumArgs() const
@@ -89,14 +106,11 @@ Expression Function::Evaluate(const Expression &op1, const Expression &op2, cons
 // Static helper function to call a BuiltinFunction or create an AluFunctionCall by name, given the expression arguments, and using the local symbol table
 Expression Function::Call(SymbolTable *symbols, const char *fcn_name, int nargs, const Expression *op1, const Expression *op2, const Expression *op3, const Expression *op4)
 {
-	// Lookup function in SymbolTable, by using a temporary key constructed from the name and number of arguments
-	char *fcn_key = (char *) malloc(strlen(fcn_name) + 8);
-	sprintf(fcn_key, "%s__%d", fcn_name, nargs);
-
-	Symbol *symbol = symbols->Get(fcn_key);
-
-	// Free created key
-	free(fcn_key);
+	// Lookup function in SymbolTable, by using a key constructed from the name and number of arguments.
+	// The key is only needed for the lookup, so it is not kept in the string buffer.
+	StartKey(fcn_name, nargs, strings);
+	Symbol *symbol = symbols->Get(strings->CurrentString());
+	strings->DiscardString();
 
 	if (!symbol)
 	{
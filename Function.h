@@ -6,12 +6,14 @@
 #include "Expression.h"
 
 class SymbolTable;
+class StringBuffer;
 
 // Base class for BuiltinFunction (called at compile time) and AluInstructionCall
 class Function : public Symbol
 {
 public:
-	Function(const char *name, const char *args = NULL);
+	// The key is built in keyStrings, or in the global string buffer when NULL
+	Function(const char *name, const char *args = NULL, StringBuffer *keyStrings = NULL);
 	virtual ~Function();
 
 	// Override Key function to mangle name as "name__args" or "name__0" if no args
@@ -36,7 +38,10 @@ public:
 	static const char *TypeStringFromChar(char c);
 
 protected:
-	char *key;
+	static const char *MakeKey(const char *name, int nargs, StringBuffer *buffer = NULL);
+	static void StartKey(const char *name, int nargs, StringBuffer *buffer);
+
+	const char *key;
 	const char *args;
 };
 
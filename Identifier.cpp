@@ -76,18 +76,18 @@ bool DottedIdentifier::operator!=(const DottedIdentifier &id) const
 }
 
 
-// Creates a temporary string in buf, up to buflen characters
-const char *DottedIdentifier::ToString(char *buf, int buflen) const
+// Creates the dotted string in the global string buffer
+const char *DottedIdentifier::ToString() const
 {
-	*buf = 0;
-	int len = strcatbuf(buf, buflen, Name);
-	if (Next)
+	strings->StartString();
+	for (const DottedIdentifier *id = this; id; id = id->Next)
 	{
-		len = strcatbuf(buf, buflen, ".");
-		Next->ToString(&buf[len], buflen-len);
+		if (id != this)
+			strings->AppendChar('.');
+		strings->AppendString(id->Name);
 	}
 
-	return buf;
+	return strings->FinishString();
 }
 
 
@@ -24,8 +24,8 @@ struct DottedIdentifier
 	bool operator==(const DottedIdentifier &id) const;
 	bool operator!=(const DottedIdentifier &id) const;
 
-	// Creates a temporary string in buf, up to buflen characters
-	const char *ToString(char *buf, int buflen) const;
+	// Creates the dotted name, such as "inst.signal", in the global string buffer
+	const char *ToString() const;
 };
 
 
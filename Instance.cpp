@@ -37,6 +37,20 @@ int Instance::ConnectionCount() const
 	return connections.size();
 }
 
+bool Instance::RemoveConnection(Connection *connection)
+{
+	for (int i=0; i < (int) connections.size(); i++)
+	{
+		if (connections[i] == connection)
+		{
+			connections.erase(connections.begin() + i);
+			return true;
+		}
+	}
+
+	return false;
+}
+
 Connection *Instance::GetConnection(int i) const
 {
 	if (i >= 0 && i < (int) connections.size())
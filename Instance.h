@@ -4,6 +4,7 @@
 
 #include "Symbol.h"
 #include "Common.h"
+#include "AllocTracked.h"
 
 #include <vector>
 using namespace std;
@@ -11,7 +12,7 @@ using namespace std;
 class Module;
 class Connection;
 
-class Instance : public Symbol
+class Instance : public Symbol, public AllocTracked<ALLOC_INSTANCE>
 {
 public:
 	Instance(Module *module, const char *name, const char *definitionName = NULL);
@@ -37,6 +38,7 @@ public:
 	// is invalid, such as if more than one connection is made to an input port
 	int ConnectionCount() const;
 	bool AddConnection(Connection *connection);
+	bool RemoveConnection(Connection *connection);
 	Connection *GetConnection(int i) const;
 
 	// Checks whether all input and output ports of the instance are connected, and issues
@@ -0,0 +1,333 @@
+#include "Latency.h"
+#include "Alu.h"
+#include "SiliconObject.h"
+#include "Common.h"
+
+#include <limits.h>
+#include <algorithm>
+
+
+LatencyRange::LatencyRange()
+	: Min(INT_MAX), Max(-1), Unbounded(false)
+{
+}
+
+LatencyRange::LatencyRange(int min, int max)
+	: Min(min), Max(max), Unbounded(false)
+{
+}
+
+
+bool LatencyAnalyzer::Node::operator<(const Node &node) const
+{
+	if (Inst != node.Inst)
+		return Inst < node.Inst;
+
+	return Sig < node.Sig;
+}
+
+
+int LatencyAnalyzer::NodeIndex(map<Node, int> &nodes, const Instance *inst, const Signal *sig)
+{
+	Node node;
+	node.Inst = inst;
+	node.Sig = sig;
+
+	int index = nodes.size();
+	return nodes.insert(make_pair(node, index)).first->second;
+}
+
+
+void LatencyAnalyzer::AddEdge(map<Node, int> &nodes, vector<Edge> &edges, const Instance *fromInst, const Signal *fromSig,
+	const Instance *toInst, const Signal *toSig, const LatencyRange &latency)
+{
+	Edge edge;
+	edge.From = NodeIndex(nodes, fromInst, fromSig);
+	edge.To = NodeIndex(nodes, toInst, toSig);
+	edge.Latency = latency;
+	edges.push_back(edge);
+}
+
+
+const LatencySummary &LatencyAnalyzer::Summarize(const Module *module)
+{
+	map<const Module*, LatencySummary>::iterator found = summaries.find(module);
+	if (found != summaries.end())
+		return found->second;
+
+	// Instances cannot be recursive, so the summary can be filled in after it is inserted
+	LatencySummary &summary = summaries[module];
+
+	if (module->IsExtern())
+	{
+		// Contents unknown
+	}
+	else if (dynamic_cast<const SiliconObject*>(module) && !module->IsFPOA())
+	{
+		SummarizeSiliconObject(module, summary);
+	}
+	else
+	{
+		SummarizeModule(module, summary);
+	}
+
+	return summary;
+}
+
+
+// Latency through an ALU, from its program analysis.  Once the program is in a steady-state loop, an input
+// affects an output within one iteration of the loop.  A program without loops takes at most one pass through
+// its instructions.  Stalls on v_in, and loops whose exit depends on data, have no bound.
+LatencyRange LatencyAnalyzer::AluLatency(const Alu *alu)
+{
+	AluProgramAnalysis analysis;
+	alu->AnalyzeProgram(analysis);
+
+	LatencyRange latency(1, 1);
+	for (int i=0; i < analysis.NumInstructions; i++)
+	{
+		if (analysis.Reachable[i] && analysis.WaitsForV[i])
+			latency.Unbounded = true;
+	}
+
+	for (size_t l=0; l < analysis.Loops.size(); l++)
+	{
+		const AluLoop &loop = analysis.Loops[l];
+		for (int i=0; i < analysis.NumInstructions; i++)
+		{
+			if ((loop.Members & (1u << i)) && analysis.Reachable[i] && !loop.Steady)
+				latency.Unbounded = true;
+		}
+	}
+
+	if (analysis.HasInterval)
+		latency.Max = max(analysis.MaxInterval, 1);
+	else
+		latency.Max = analysis.NumInstructions;
+
+	return latency;
+}
+
+
+void LatencyAnalyzer::SummarizeSiliconObject(const Module *module, LatencySummary &summary)
+{
+	// Outputs of silicon objects are registered
+	LatencyRange latency(1, 1);
+
+	const Alu *alu = dynamic_cast<const Alu*>(module);
+	if (alu && alu->InstructionCount() > 1)
+		latency = AluLatency(alu);
+
+	int n = module->SignalCount();
+	for (int i=0; i < n; i++)
+	{
+		const Signal *in = module->GetSignal(i);
+		if (in->Direction != DIR_IN)
+			continue;
+
+		for (int j=0; j < n; j++)
+		{
+			const Signal *out = module->GetSignal(j);
+			if (out->Direction == DIR_OUT)
+				summary[in][out] = latency;
+		}
+	}
+}
+
+
+void LatencyAnalyzer::SummarizeModule(const Module *module, LatencySummary &summary)
+{
+	// Build the latency graph of the module
+	map<Node, int> nodes;
+	vector<Edge> edges;
+
+	int ncon = module->ConnectionCount();
+	for (int i=0; i < ncon; i++)
+	{
+		const Connection *c = module->GetConnection(i);
+		AddEdge(nodes, edges, c->Source.ResolvedInstance, c->Source.ResolvedSignal,
+			c->Destination.ResolvedInstance, c->Destination.ResolvedSignal, LatencyRange(0, 0));
+	}
+
+	int nsignals = module->SignalCount();
+	for (int i=0; i < nsignals; i++)
+	{
+		const Signal *sig = module->GetSignal(i);
+		if (sig->Behavior == BEHAVIOR_DELAY && sig->BaseSignal)
+		{
+			// Each tap of a delay chain follows the previous tap
+			const Signal *source = sig->DelaySource ? sig->DelaySource : sig->BaseSignal;
+			int delay = sig->DelayCount - (source->Behavior == BEHAVIOR_DELAY ? source->DelayCount : 0);
+			AddEdge(nodes, edges, NULL, source, NULL, sig, LatencyRange(delay, delay));
+		}
+		else if (sig->Behavior == BEHAVIOR_BIT_SLICE && sig->BaseSignal)
+		{
+			AddEdge(nodes, edges, NULL, sig->BaseSignal, NULL, sig, LatencyRange(0, 0));
+		}
+	}
+
+	int ninst = module->InstanceCount();
+	for (int i=0; i < ninst; i++)
+	{
+		const Instance *inst = module->GetInstance(i);
+		if (!inst->Definition)
+			continue;
+
+		const LatencySummary &inner = Summarize(inst->Definition);
+		LatencySummary::const_iterator in;
+		for (in = inner.begin(); in != inner.end(); ++in)
+		{
+			map<const Signal*, LatencyRange>::const_iterator out;
+			for (out = in->second.begin(); out != in->second.end(); ++out)
+				AddEdge(nodes, edges, inst, in->first, inst, out->first, out->second);
+		}
+	}
+
+	int nnodes = nodes.size();
+	int nedges = edges.size();
+
+	// From each input port, relax minimum and maximum latencies to every reachable node.
+	// Maximum latencies still growing after as many rounds as there are nodes lie on or after a feedback loop,
+	// and are marked unbounded instead, so relaxation always settles.
+	for (int i=0; i < nsignals; i++)
+	{
+		const Signal *in = module->GetSignal(i);
+		if (in->Direction != DIR_IN)
+			continue;
+
+		Node start;
+		start.Inst = NULL;
+		start.Sig = in;
+		map<Node, int>::const_iterator found = nodes.find(start);
+		if (found == nodes.end())
+			continue;
+
+		vector<LatencyRange> latency(nnodes);
+		latency[found->second] = LatencyRange(0, 0);
+
+		bool changed = true;
+		for (int round = 0; changed; round++)
+		{
+			changed = false;
+			for (int e=0; e < nedges; e++)
+			{
+				const Edge &edge = edges[e];
+				const LatencyRange &from = latency[edge.From];
+				LatencyRange &to = latency[edge.To];
+				if (from.Max < 0)
+					continue;
+
+				if (from.Min + edge.Latency.Min < to.Min)
+				{
+					to.Min = from.Min + edge.Latency.Min;
+					changed = true;
+				}
+
+				if ((from.Unbounded || edge.Latency.Unbounded) && !to.Unbounded)
+				{
+					to.Unbounded = true;
+					changed = true;
+				}
+
+				if (!to.Unbounded && from.Max + edge.Latency.Max > to.Max)
+				{
+					to.Max = from.Max + edge.Latency.Max;
+
+					// Still growing after every simple path has been considered
+					if (round >= nnodes)
+						to.Unbounded = true;
+
+					changed = true;
+				}
+			}
+		}
+
+		for (int j=0; j < nsignals; j++)
+		{
+			const Signal *out = module->GetSignal(j);
+			if (out->Direction != DIR_OUT)
+				continue;
+
+			Node end;
+			end.Inst = NULL;
+			end.Sig = out;
+			map<Node, int>::const_iterator reached = nodes.find(end);
+			if (reached != nodes.end() && latency[reached->second].Max >= 0)
+				summary[in][out] = latency[reached->second];
+		}
+	}
+}
+
+
+void LatencyAnalyzer::ReportModule(FILE *f, const Module *module, bool always)
+{
+	const LatencySummary &summary = Summarize(module);
+
+	// Only report inner definitions with imbalance or feedback
+	bool report = always;
+	LatencySummary::const_iterator in;
+	map<const Signal*, LatencyRange>::const_iterator out;
+	for (in = summary.begin(); !report && in != summary.end(); ++in)
+	{
+		for (out = in->second.begin(); out != in->second.end(); ++out)
+		{
+			if (!out->second.Balanced())
+				report = true;
+		}
+	}
+
+	if (report)
+	{
+		fprintf(f, "== Latency: %s ==\n", module->MangledName().c_str());
+		if (summary.empty())
+			fprintf(f, "  (no paths between ports)\n");
+
+		// Ports are reported in the order of the module's signals, not of the summary's keys, so the report is repeatable
+		int n = module->SignalCount();
+		for (int i=0; i < n; i++)
+		{
+			const Signal *inSig = module->GetSignal(i);
+			in = summary.find(inSig);
+			if (in == summary.end())
+				continue;
+
+			for (int j=0; j < n; j++)
+			{
+				const Signal *outSig = module->GetSignal(j);
+				out = in->second.find(outSig);
+				if (out == in->second.end())
+					continue;
+
+				const LatencyRange &latency = out->second;
+				fprintf(f, "  %s -> %s: ", inSig->Name(), outSig->Name());
+
+				if (latency.Unbounded)
+					fprintf(f, "min %d, unbounded (feedback, or an ALU program that stalls or loops)\n", latency.Min);
+				else if (latency.Min != latency.Max)
+					fprintf(f, "min %d, max %d (imbalanced)\n", latency.Min, latency.Max);
+				else
+					fprintf(f, "%d\n", latency.Min);
+			}
+		}
+	}
+
+	// Inner definitions are reported when they are structural, and have a problem
+	int nmodules = module->InnerModuleCount();
+	for (int i=0; i < nmodules; i++)
+	{
+		const Module *innerModule = module->GetInnerModule(i);
+		if (innerModule && !dynamic_cast<const SiliconObject*>(innerModule) && !innerModule->IsExtern())
+			ReportModule(f, innerModule, false);
+	}
+}
+
+
+void LatencyAnalyzer::Report(FILE *f, StringMap &modules)
+{
+	for (int i=0; i < modules.Count(); i++)
+	{
+		const Module *module = (const Module *) modules.Get(i);
+		if (!module->IsExtern())
+			ReportModule(f, module, true);
+	}
+}
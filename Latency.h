@@ -0,0 +1,79 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include "Module.h"
+
+#include <stdio.h>
+#include <map>
+#include <vector>
+using namespace std;
+
+class Alu;
+
+// Range of clock cycles taken by the paths between two signals
+struct LatencyRange
+{
+	LatencyRange();
+	LatencyRange(int min, int max);
+
+	int Min;
+	int Max;
+	bool Unbounded;         // Set when a feedback loop lies on some path, so Max is not bounded
+
+	bool Balanced() const { return !Unbounded && Min == Max; }
+};
+
+// Port-to-port latencies of a module definition, keyed by input port, then output port
+typedef map<const Signal*, map<const Signal*, LatencyRange> > LatencySummary;
+
+
+// Static analysis of cycle latency between the input and output ports of modules, after ResolveConnections.
+//
+// Each module is summarized once, from the bottom up, as the latency from each of its input ports
+// to each output port it reaches.  Within a module, connections and bit-slices take no cycles,
+// delayed signals take their DelayCount, and instances take the latencies of their definition's summary.
+// Silicon objects are register boundaries: an ALU takes from one cycle up to one iteration of the steady-state
+// loop of its program (or one pass through a program without loops), and is unbounded when it waits for v_in
+// or may loop for a data-dependent number of iterations.  All other objects take one cycle.
+// Paths through extern modules are not known, and are not followed.
+class LatencyAnalyzer
+{
+public:
+	// Latencies of a module definition, computed on first use
+	const LatencySummary &Summarize(const Module *module);
+
+	// Reports port-to-port latencies of every non-extern top-level module, and of each module definition
+	// with imbalanced reconvergent paths or feedback between its ports
+	void Report(FILE *f, StringMap &modules);
+
+private:
+	// Graph node: a local signal, or a port of a local instance
+	struct Node
+	{
+		const Instance *Inst;
+		const Signal *Sig;
+
+		bool operator<(const Node &node) const;
+	};
+
+	struct Edge
+	{
+		int From;
+		int To;
+		LatencyRange Latency;
+	};
+
+	static int NodeIndex(map<Node, int> &nodes, const Instance *inst, const Signal *sig);
+	static void AddEdge(map<Node, int> &nodes, vector<Edge> &edges, const Instance *fromInst, const Signal *fromSig,
+		const Instance *toInst, const Signal *toSig, const LatencyRange &latency);
+
+	static LatencyRange AluLatency(const Alu *alu);
+	void SummarizeSiliconObject(const Module *module, LatencySummary &summary);
+	void SummarizeModule(const Module *module, LatencySummary &summary);
+	void ReportModule(FILE *f, const Module *module, bool always);
+
+	map<const Module*, LatencySummary> summaries;
+};
+
+
+#endif
@@ -1,9 +1,13 @@
 
 #include "Module.h"
 #include "parser.h"
+#include "Trace.h"
+#include "Diagnostics.h"
+
+#include <algorithm>
 
 Module::Module(const char *name, Module *parent, bool isExtern)
-	: Symbol(name), parent(parent), isExtern(isExtern), numInstances(0)
+	: Symbol(name), parent(parent), isExtern(isExtern), numInstances(0), sharedDefinition(NULL)
 {
 	if (parent)
 		parent->AddInnerModule(this);
@@ -94,6 +98,11 @@ bool Module::IsExtern() const
 	return isExtern;
 }
 
+const Module *Module::SharedDefinition() const
+{
+	return sharedDefinition ? sharedDefinition : this;
+}
+
 // Return whether a top-level FPOA.  FPOA object overrides this to return true.
 bool Module::IsFPOA() const
 {
@@ -155,6 +164,25 @@ Signal *Module::GetSignal(int i) const
 	return (Signal*) signals.Get(i);
 }
 
+// Removes a signal, along with any memoized outer port route to it, and deletes it.
+// Connections to the signal must already have been removed.
+void Module::RemoveSignal(Signal *signal)
+{
+	if (signals.Remove(signal->Name()) == NULL)
+		return;
+
+	map<OuterPortKey, Signal*>::iterator it = outerPorts.begin();
+	while (it != outerPorts.end())
+	{
+		if (it->second == signal)
+			outerPorts.erase(it++);
+		else
+			++it;
+	}
+
+	delete signal;
+}
+
 
 // Parameter List
 int Module::ParameterCount() const
@@ -342,6 +370,13 @@ bool Module::RemoveConnection(Connection *connection)
 	return true;
 }
 
+void Module::RemoveConnectionAt(int i)
+{
+	int n = connections.size();
+	if (i >= 0 && i < n)
+		connections.erase(connections.begin() + i);
+}
+
 Connection *Module::GetConnection(int i) const
 {
 	int n = connections.size();
@@ -374,6 +409,21 @@ bool Module::AddOuterConnection(OuterConnection *outerConnection)
 	return true;
 }
 
+bool Module::RemoveOuterConnection(OuterConnection *outerConnection)
+{
+	int n = outerConnections.size();
+	for (int i=0; i < n; i++)
+	{
+		if (outerConnections[i] == outerConnection)
+		{
+			outerConnections.erase(outerConnections.begin() + i);
+			return true;
+		}
+	}
+
+	return false;
+}
+
 OuterConnection *Module::GetOuterConnection(int i) const
 {
 	int n = outerConnections.size();
@@ -383,6 +433,20 @@ OuterConnection *Module::GetOuterConnection(int i) const
 	return NULL;
 }
 
+Signal *Module::GetOuterPort(const Signal *signal, const Instance *instance, SignalDirection direction) const
+{
+	map<OuterPortKey, Signal*>::const_iterator it = outerPorts.find(OuterPortKey(signal, instance, direction));
+	if (it != outerPorts.end())
+		return it->second;
+
+	return NULL;
+}
+
+void Module::AddOuterPort(const Signal *signal, const Instance *instance, SignalDirection direction, Signal *port)
+{
+	outerPorts[OuterPortKey(signal, instance, direction)] = port;
+}
+
 
 
 // Perform first analysis pass on module, after parsing the module
@@ -393,6 +457,9 @@ OuterConnection *Module::GetOuterConnection(int i) const
 // - Returns true if successful
 bool Module::AnalyzeAfterParse()
 {
+	TraceSpan span("AnalyzeAfterParse", this);
+	DiagnosticScope scope(this);
+
 	// Apply default values to uninitialized registers
 	if (!ApplyDefaultValues())
 		return false;
@@ -450,6 +517,9 @@ Module *Module::LookupModule(const char *moduleName) const
 // Perform second pass on module, after parsing all modules
 bool Module::ResolveInstances()
 {
+	TraceSpan span("ResolveInstances", this);
+	DiagnosticScope scope(this);
+
 	bool ok = true;
 
 	// Associate module instances with their module definitions
@@ -530,6 +600,9 @@ bool Module::ResolveInstances()
 // Perform third pass on module, after resolving all instances
 bool Module::ResolveConnections()
 {
+	TraceSpan span("ResolveConnections", this);
+	DiagnosticScope scope(this);
+
 	bool ok = true;
 
 	// Wire up signals and ports by name, and check that each referenced signal exists
@@ -578,6 +651,73 @@ bool Module::ResolveConnections()
 }
 
 
+// Order delayed signals by their total delay
+static bool CompareDelayCount(const Signal *a, const Signal *b)
+{
+	return a->DelayCount < b->DelayCount;
+}
+
+
+// Organizes all delayed versions of each signal into a single chain of taps, so that each DELAY object
+// only adds the difference from the previous tap.  For example, x$3, x$5 and x$12 are generated as
+// x -> (3) -> x$3 -> (2) -> x$5 -> (7) -> x$12.
+// Stages longer than MAX_SIGNAL_DELAY are split by inserting intermediate taps.
+void Module::BuildDelayChains()
+{
+	DiagnosticScope scope(this);
+
+	// Group delayed signals by their undelayed base signal
+	map<Signal*, vector<Signal*> > taps;
+
+	int n = SignalCount();
+	for (int i=0; i < n; i++)
+	{
+		Signal *sig = GetSignal(i);
+		if (sig->Behavior == BEHAVIOR_DELAY)
+			taps[sig->BaseSignal].push_back(sig);
+	}
+
+	map<Signal*, vector<Signal*> >::iterator it;
+	for (it = taps.begin(); it != taps.end(); ++it)
+	{
+		Signal *base = it->first;
+		vector<Signal*> &chain = it->second;
+		sort(chain.begin(), chain.end(), CompareDelayCount);
+
+		Signal *previous = base;
+		int previousDelay = 0;
+		for (int i=0; i < (int) chain.size(); i++)
+		{
+			Signal *tap = chain[i];
+
+			// Intermediate taps, such as x$30 for x$45, are created in the same module as the base signal
+			while (tap->DelayCount - previousDelay > MAX_SIGNAL_DELAY)
+			{
+				Signal *stage = base->Delay(previousDelay + MAX_SIGNAL_DELAY);
+				if (!stage)
+					break;
+
+				stage->DelaySource = previous;
+				previous = stage;
+				previousDelay = stage->DelayCount;
+			}
+
+			tap->DelaySource = previous;
+			previous = tap;
+			previousDelay = tap->DelayCount;
+		}
+	}
+
+	int nmodules = InnerModuleCount();
+	for (int i=0; i < nmodules; i++)
+	{
+		Module *innerModule = GetInnerModule(i);
+		if (innerModule)
+			innerModule->BuildDelayChains();
+	}
+}
+
+
 // At each level of hierarchy, outer connections in any inner module definitions
 // may need to be resolved to outer level signals or ports.  These need to be stitched up for each instance,
 // from bottom up through the module definition hierarchy.
@@ -586,6 +726,9 @@ bool Module::ResolveConnections()
 // Finally, it connects signals to instances and performs a final check
 bool Module::ResolveConnectionsPass2()
 {
+	TraceSpan span("ResolveConnectionsPass2", this);
+	DiagnosticScope scope(this);
+
 	bool ok = true;
 
 	// ResolveConnectionsPass2 is recursive, and works from bottom up
@@ -602,6 +745,10 @@ bool Module::ResolveConnectionsPass2()
 
 
 	// Resolve outer connections on each local instance
+	// An input outer connection flattens to the same local source for every instance of a definition,
+	// so the route is computed for the first instance and reused for the rest
+	map<const OuterConnection*, Signal*> routedSources;
+
 	int ninst = InstanceCount();
 	for (int i=0; i < ninst; i++)
 	{
@@ -621,6 +768,16 @@ bool Module::ResolveConnectionsPass2()
 
 				if (oc->Direction == DIR_IN)
 				{
+					map<const OuterConnection*, Signal*>::const_iterator routed = routedSources.find(oc);
+					if (routed != routedSources.end())
+					{
+						// Route already flattened for a previous instance, connect directly from the local source
+						c = new Connection(this, routed->second, NULL, oc->DestinationSignal, inst, inst->Location);
+						if (!AddConnection(c))
+							delete c;
+						continue;
+					}
+
 					// If the outer connection is an input, it should go to this instance
 					c = new Connection(this,
 						oc->SourceSignal, oc->SourceInstance,
@@ -646,6 +803,10 @@ bool Module::ResolveConnectionsPass2()
 				// and add yet higher-level outer connections.
 				c->Flatten();
 
+				// Remember a flattened input route which no longer depends on the instance
+				if (oc->Direction == DIR_IN && c->Source.ResolvedInstance == NULL)
+					routedSources[oc] = c->Source.ResolvedSignal;
+
 				// Add the new connection locally, and connect it to or from the instance
 				bool added = AddConnection(c);
 
@@ -701,6 +862,9 @@ bool Module::ExtraResolveConnections()
 // Also check for local wires that have no source or destination (TBD)
 bool Module::CheckConnections() const
 {
+	TraceSpan span("CheckConnections", this);
+	DiagnosticScope scope(this);
+
 	// Extern modules have no connections, so skip this check
 	if (IsExtern())
 		return true;
@@ -9,12 +9,16 @@
 #include "Connection.h"
 #include "StringMap.h"
 #include "Common.h"
+#include "AllocTracked.h"
 
+#include <stdint.h>
 #include <vector>
+#include <map>
+#include <string>
 using namespace::std;
 
 
-class Module : public Symbol
+class Module : public Symbol, public AllocTracked<ALLOC_MODULE>
 {
 public:
 	Module(const char *name, Module *parent = NULL, bool isExtern = false);
@@ -39,11 +43,16 @@ public:
 	// Whether a top-level FPOA
 	virtual bool IsFPOA() const;
 
+	// Definition whose Verilog module is generated for this one.
+	// This is the module itself, unless it was found to be structurally equivalent to another definition.
+	const Module *SharedDefinition() const;
+
 	// Signals by name and index
 	int SignalCount() const;
 	Signal *AddSignal(Signal *signal);
 	Signal *GetSignal(const char *name) const;
 	Signal *GetSignal(int i) const;
+	void RemoveSignal(Signal *signal);      // Removes and deletes the signal
 
 	// Parameters by name and index
 	int ParameterCount() const;
@@ -57,6 +66,9 @@ public:
 	Instance *GetInstance(const char *name) const;
 	Instance *GetInstance(int i) const;
 
+	// Look up module in local scope first, and work upwards to global scope
+	Module *LookupModule(const char *moduleName) const;
+
 	// Inner module definitions by name and index
 	int InnerModuleCount() const;
 	Module *AddInnerModule(Module *innerModule);
@@ -69,18 +81,25 @@ public:
 	bool HasConnection(const Connection *connection) const;
 	bool AddConnection(Connection *connection);
 	bool RemoveConnection(Connection *connection);
+	void RemoveConnectionAt(int i);         // Removes by index, rather than by equal connection
 	Connection *GetConnection(int i) const;
 
 	// Outer connections, used during ResolveConnections phase
 	int OuterConnectionCount() const;
 	bool AddOuterConnection(OuterConnection *outerConnection);
+	bool RemoveOuterConnection(OuterConnection *outerConnection);
 	OuterConnection *GetOuterConnection(int i) const;
 
+	// Automatic ports routing outer signals into or out of this module, memoized per outer signal
+	Signal *GetOuterPort(const Signal *signal, const Instance *instance, SignalDirection direction) const;
+	void AddOuterPort(const Signal *signal, const Instance *instance, SignalDirection direction, Signal *port);
+
 	// After parsing, perform analysis passes to apply default values,
 	// assign resources, and check for errors
 	bool AnalyzeAfterParse();       // Performed after parsing this module   (phase 1)
 	bool ResolveInstances();		// Performed after parsing all modules   (phase 2)
 	bool ResolveConnections();		// Performed after resolving instances on all modules   (phase 3)
+	void BuildDelayChains();		// Performed after resolving connections, before generating Verilog
 
 	// Public field to store the source code location of the module definition
 	SourceCodeLocation Location;
@@ -88,15 +107,31 @@ public:
 
 	// Defined in Module_GenerateVerilog
 
-	// Primary Verilog generation method, overridden by various module types
-	virtual void GenerateVerilog(FILE *f) const;
+	// Primary Verilog generation method, overridden by various module types.
+	// With neutralName, this module's own name is generated as "$", so that its text is a structural signature.
+	virtual void GenerateVerilog(FILE *f, bool neutralName = false) const;
+
+	// Generates this module and all of its inner modules, skipping definitions shared with an equivalent one
+	void GenerateVerilogHierarchy(FILE *f) const;
+
+	// Name-mangled module name, "Parent$Child" for inner modules, as used for the generated Verilog module
+	string MangledName() const;
+
+	// Detects structurally equivalent inner module and object definitions, working from the bottom up,
+	// so that all of their instances reference a single shared Verilog module.
+	// Signatures maps a hash of generated Verilog text to the definitions which produced it, and texts with
+	// the same hash are compared in full.  Returns the number of definitions which were shared.
+	typedef map<uint64_t, vector<const Module*> > SignatureMap;
+	int ShareEquivalentDefinitions(SignatureMap &signatures);
 
 	// Generates an embedded comment containing an extern interface declaration
 	// for the module or object
 	virtual void GenerateVerilogEmbeddedExtern(FILE *f, bool suppressEmbeddedOasmDeclarations = false) const;
 
 	// Used to generate a header at the top of each Verilog output file
-	static  void GenerateVerilogHeader(FILE *f);
+	// When timestamp is false, the header is identical from run to run.
+	// SOURCE_DATE_EPOCH, when set, replaces the current time.
+	static  void GenerateVerilogHeader(FILE *f, bool timestamp = true);
 
 
 protected:
@@ -104,9 +139,6 @@ protected:
 	virtual bool ApplyDefaultValues();
 	virtual bool AssignResources();
 
-	// Look up module in local scope first, and work upwards to global scope
-	Module *LookupModule(const char *moduleName) const;
-
 	// Called from within ResolveConnections
 	bool ResolveConnectionsPass2();
 	bool CheckConnections() const;
@@ -116,7 +148,9 @@ protected:
 	virtual bool ExtraResolveConnections();
 
 	// Defined in Module_GenerateVerilog
-	virtual void GenerateVerilogModuleName(FILE *f) const;
+	virtual void GenerateVerilogModuleName(FILE *f, bool neutralName = false) const;
+	void GenerateVerilogMangledName(FILE *f) const;
+	const char *VerilogLocalName(bool neutralName) const;
 	virtual void GenerateVerilogWires(FILE *f) const;
 	virtual void GenerateVerilogConnections(FILE *f) const;
 	virtual void GenerateVerilogInstances(FILE *f) const;
@@ -136,6 +170,14 @@ private:
 
 	vector<Connection*> connections;
 	vector<OuterConnection*> outerConnections;
+	map<OuterPortKey, Signal*> outerPorts;
+
+	// Set when this definition is generated using an equivalent definition's Verilog module
+	const Module *sharedDefinition;
+
+	// Verilog of this module alone, with a neutral module name, and its hash
+	bool GenerateVerilogSignature(string &signature) const;
+	static uint64_t SignatureHash(const string &signature);
 };
 
 #endif
@@ -1,14 +1,17 @@
 
 #include "Module.h"
 #include "Common.h"
+#include "Trace.h"
 
 #include <time.h>
+#include <stdlib.h>
 
 //
 // Header prepended to every generated file.
 // This contains a timestamp and the version of oasm2verilog used to generate the output.
+// The timestamp is omitted for reproducible output, and follows SOURCE_DATE_EPOCH when it is set.
 //
-void Module::GenerateVerilogHeader(FILE *f)
+void Module::GenerateVerilogHeader(FILE *f, bool timestamp)
 {
 	F0("\n");
 	F0("// *** *************************************** ***\n");
@@ -16,9 +19,22 @@ void Module::GenerateVerilogHeader(FILE *f)
 	F0("// *** *************************************** ***\n");
 	F0("\n");
 
-	time_t now;
-	time (&now);
-	F1("// Generated at: %s", ctime(&now));
+	if (timestamp)
+	{
+		const char *epoch = getenv("SOURCE_DATE_EPOCH");
+		if (epoch && *epoch)
+		{
+			// Fixed build time, always reported in UTC
+			time_t fixed = (time_t) strtol(epoch, NULL, 10);
+			F1("// Generated at: %s", asctime(gmtime(&fixed)));
+		}
+		else
+		{
+			time_t now;
+			time (&now);
+			F1("// Generated at: %s", ctime(&now));
+		}
+	}
 
 	extern const char *oasm2verilog_version;
 	F1("// By: oasm2verilog version %s\n", oasm2verilog_version);
@@ -50,23 +66,52 @@ void Module::GenerateVerilogDelay(FILE *f, const Signal *delayedSignal)
 			break;
 	}
 
+	// Each delay is one stage of a chain of taps from the base signal, and only adds the difference
+	// from the previous tap
+	const Signal *source = delayedSignal->DelaySource ? delayedSignal->DelaySource : delayedSignal->BaseSignal;
+	int stageDelay = delayedSignal->DelayCount;
+	if (source->Behavior == BEHAVIOR_DELAY)
+		stageDelay -= source->DelayCount;
+
 	// Generate a single line of Verilog that instantiates a delay module, parameterizes its delay,
 	// and connects up the input and output ports
 	F5("\t%s #(\"%d\") %sD (.i(%s), .o(%s));\n",
-		delayModuleType, delayedSignal->DelayCount,
+		delayModuleType, stageDelay,
 		delayedSignal->Name(),
-		delayedSignal->BaseSignal->Name(), delayedSignal->Name());
+		source->Name(), delayedSignal->Name());
+}
+
+
+//
+// Generates the name of the Verilog module used for this definition
+//
+void Module::GenerateVerilogModuleName(FILE *f, bool neutralName) const
+{
+	if (SharedDefinition() != this)
+	{
+		// Structurally equivalent definitions all use the shared definition's module
+		SharedDefinition()->GenerateVerilogModuleName(f);
+	}
+	else if (neutralName)
+	{
+		// Use a neutral name while computing a structural signature
+		F0("$");
+	}
+	else
+	{
+		GenerateVerilogMangledName(f);
+	}
 }
 
 
 //
 // Generates a name-mangled version of the module name
 //
-void Module::GenerateVerilogModuleName(FILE *f) const
+void Module::GenerateVerilogMangledName(FILE *f) const
 {
 	if (ParentModule())
 	{
-		ParentModule()->GenerateVerilogModuleName(f);
+		ParentModule()->GenerateVerilogMangledName(f);
 		fprintf(f, "$%s", Name());
 	}
 	else
@@ -76,6 +121,27 @@ void Module::GenerateVerilogModuleName(FILE *f) const
 }
 
 
+string Module::MangledName() const
+{
+	if (ParentModule())
+		return ParentModule()->MangledName() + "$" + Name();
+
+	return Name();
+}
+
+
+//
+// Name of the module as it appears inside its own Verilog, in comments and in wrapped object instances
+//
+const char *Module::VerilogLocalName(bool neutralName) const
+{
+	if (neutralName)
+		return "$";
+
+	return Name();
+}
+
+
 //
 // Generates wire declarations for all local non-port signals
 //
@@ -211,7 +277,7 @@ void Module::GenerateVerilogInstances(FILE *f) const
 	}
 }
 
-void Module::GenerateVerilog(FILE *f) const
+void Module::GenerateVerilog(FILE *f, bool neutralName) const
 {
 	// Generates structural Verilog code to instantiate submodule instances and wire up connections.
 	// SiliconObject overrides this method to create a wrapper module around a silicon object instance
@@ -222,7 +288,7 @@ void Module::GenerateVerilog(FILE *f) const
 	F0("\n");
 
 	F0("//\n");
-	F2("// ================ %s - %s ================\n", (ParentModule()) ? "InnerModule" : "Module", Name());
+	F2("// ================ %s - %s ================\n", (ParentModule()) ? "InnerModule" : "Module", VerilogLocalName(neutralName));
 	F0("//\n");
 
 	int n = SignalCount();
@@ -233,7 +299,7 @@ void Module::GenerateVerilog(FILE *f) const
 	//     output [16:0] OutWord3
 	// );
 	F0("module ");
-	GenerateVerilogModuleName(f);
+	GenerateVerilogModuleName(f, neutralName);
 	F0(" (");
 
 	bool first = true;
@@ -264,20 +330,6 @@ void Module::GenerateVerilog(FILE *f) const
 	// endmodule
 	F0("\nendmodule\n");
 	F0("\n");
-
-
-	//
-	// Recursively generate inner modules
-	//
-	int nmodules = InnerModuleCount();
-	for (int i=0; i < nmodules; i++)
-	{
-		const Module *innerModule = GetInnerModule(i);
-		if (innerModule)
-		{
-			innerModule->GenerateVerilog(f);
-		}
-	}
 }
 
 
@@ -313,3 +365,104 @@ void Module::GenerateVerilogEmbeddedExtern(FILE *f, bool suppressEmbeddedOasmDec
 	if (!suppressEmbeddedOasmDeclarations)
 		F0("//+++END_EMBEDDED_OASM+++\n");
 }
+
+
+//
+// Generates this module, followed recursively by its inner modules.
+// Definitions which share an equivalent definition's Verilog module are skipped,
+// but their inner modules are still visited, as they may be referenced elsewhere.
+//
+void Module::GenerateVerilogHierarchy(FILE *f) const
+{
+	if (SharedDefinition() == this)
+	{
+		TraceSpan span("GenerateVerilog", this);
+		GenerateVerilog(f);
+	}
+
+	int nmodules = InnerModuleCount();
+	for (int i=0; i < nmodules; i++)
+	{
+		const Module *innerModule = GetInnerModule(i);
+		if (innerModule)
+		{
+			innerModule->GenerateVerilogHierarchy(f);
+		}
+	}
+}
+
+
+//
+// Generates the Verilog for this module alone, using a neutral module name, as its structural signature.
+// Two definitions with identical ports, parameters, programs and connections produce the same text.
+// Returns false if no signature could be produced.
+//
+bool Module::GenerateVerilogSignature(string &signature) const
+{
+	char *data = NULL;
+	size_t length = 0;
+	FILE *f = open_memstream(&data, &length);
+	if (!f)
+		return false;
+
+	GenerateVerilog(f, true);
+	fclose(f);
+
+	signature.assign(data, length);
+	free(data);
+
+	return length > 0;
+}
+
+
+// 64-bit FNV-1a hash of a signature
+uint64_t Module::SignatureHash(const string &signature)
+{
+	uint64_t hash = 14695981039346656037ULL;
+	for (size_t i=0; i < signature.size(); i++)
+	{
+		hash ^= (unsigned char) signature[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+
+int Module::ShareEquivalentDefinitions(SignatureMap &signatures)
+{
+	int nshared = 0;
+
+	// Work from the bottom up, so that instances in this module already refer to shared definitions
+	int nmodules = InnerModuleCount();
+	for (int i=0; i < nmodules; i++)
+	{
+		Module *innerModule = GetInnerModule(i);
+		if (innerModule)
+			nshared += innerModule->ShareEquivalentDefinitions(signatures);
+	}
+
+	// Only inner definitions are shared.  Top-level module names are part of the design's interface.
+	// Modules which generate no Verilog of their own, such as floating TFs, have no signature.
+	if (ParentModule() == NULL || IsExtern())
+		return nshared;
+
+	string signature;
+	if (!GenerateVerilogSignature(signature))
+		return nshared;
+
+	// Only the hash is kept.  Definitions with the same hash are generated again to compare their text,
+	// which only costs a second generation for a definition that is then shared.
+	vector<const Module*> &candidates = signatures[SignatureHash(signature)];
+	for (size_t i=0; i < candidates.size(); i++)
+	{
+		string candidateSignature;
+		if (candidates[i]->GenerateVerilogSignature(candidateSignature) && candidateSignature == signature)
+		{
+			sharedDefinition = candidates[i];
+			return nshared + 1;
+		}
+	}
+
+	candidates.push_back(this);
+	return nshared;
+}
@@ -0,0 +1,244 @@
+#ifndef NETLIST_FORMAT_H
+#define NETLIST_FORMAT_H
+
+/*
+ * Binary netlist written by oasm2verilog --netlist, describing the resolved design.
+ *
+ * The file is meant to be memory-mapped and read in place.  It starts with a NetlistHeader, whose sections
+ * each hold an array of one record type, aligned to 8 bytes.  Records refer to each other by index within
+ * their section, and to strings by byte offset within the string section, where each is null-terminated.
+ * NETLIST_NONE marks a missing reference.  All values are in the byte order of the writer, which readers
+ * can check with ByteOrder.
+ *
+ * Modules are listed parent first, each followed by its inner modules, in order of name.  The signals of
+ * each module are contiguous, with its ports first, and its instances, connections, parameters and ALU
+ * instructions are also contiguous.  Signals which belong to no module, such as the built-in signals of
+ * silicon objects, follow the signals of all modules, with their Module set to NETLIST_NONE.
+ *
+ * This header only uses C types, so that tools need nothing else from the compiler.
+ */
+
+#include <stdint.h>
+
+#define NETLIST_MAGIC           "OANL"
+#define NETLIST_VERSION         (1)
+#define NETLIST_BYTE_ORDER      (0x01020304)
+#define NETLIST_NONE            (0xFFFFFFFFu)
+
+// Sizes of the fixed arrays of NetlistAluInstruction
+#define NETLIST_MAX_ALU_DESTS       (9)
+#define NETLIST_MAX_ALU_ARGS        (4)
+#define NETLIST_MAX_ALU_LATCHES     (13)
+#define NETLIST_MAX_ALU_TFS         (4)
+
+enum NetlistSectionId
+{
+	NETLIST_STRINGS,            // Count is in bytes
+	NETLIST_MODULES,
+	NETLIST_SIGNALS,
+	NETLIST_INSTANCES,
+	NETLIST_CONNECTIONS,
+	NETLIST_PARAMETERS,
+	NETLIST_PARAMETER_VALUES,
+	NETLIST_ALU_INSTRUCTIONS,
+	NETLIST_NUM_SECTIONS
+};
+
+struct NetlistSection
+{
+	uint32_t Offset;            // From the start of the file
+	uint32_t Count;
+	uint32_t RecordSize;        // Size of each record, so that readers can skip fields added by later versions
+	uint32_t Reserved;
+};
+
+struct NetlistHeader
+{
+	char Magic[4];
+	uint32_t Version;
+	uint32_t ByteOrder;
+	uint32_t FileSize;
+	NetlistSection Sections[NETLIST_NUM_SECTIONS];
+};
+
+
+// Flags of a module
+#define NETLIST_MODULE_EXTERN       (0x1)
+#define NETLIST_MODULE_FPOA         (0x2)
+
+struct NetlistModule
+{
+	uint32_t Name;              // Mangled name of the generated Verilog module, such as "Parent$Child"
+	uint32_t LocalName;
+	uint32_t TypeName;          // "MODULE", or the silicon object type, such as "ALU"
+	uint32_t Parent;            // Module index, NETLIST_NONE for top-level modules
+	uint32_t SharedDefinition;  // Module whose Verilog module is used for this one, which is usually itself
+	uint32_t Flags;
+	uint32_t SourceFile;
+	uint32_t SourceLine;
+
+	uint32_t FirstSignal;
+	uint32_t NumPorts;          // Ports are the first signals of the module
+	uint32_t NumSignals;        // Including ports
+	uint32_t FirstInstance;
+	uint32_t NumInstances;
+	uint32_t FirstConnection;
+	uint32_t NumConnections;
+	uint32_t FirstParameter;
+	uint32_t NumParameters;
+	uint32_t FirstAluInstruction;
+	uint32_t NumAluInstructions;
+};
+
+
+// Values of Behavior, DataType and Direction of a signal
+enum NetlistSignalBehavior
+{
+	NETLIST_BEHAVIOR_UNKNOWN,
+	NETLIST_BEHAVIOR_WIRE,
+	NETLIST_BEHAVIOR_REG,
+	NETLIST_BEHAVIOR_CONST,
+	NETLIST_BEHAVIOR_BUILTIN,
+	NETLIST_BEHAVIOR_BRANCH,
+	NETLIST_BEHAVIOR_COND_UPDATE,
+	NETLIST_BEHAVIOR_COND_BYPASS,
+	NETLIST_BEHAVIOR_BIT_SLICE,
+	NETLIST_BEHAVIOR_DELAY,
+};
+
+enum NetlistSignalDataType
+{
+	NETLIST_DATA_TYPE_UNKNOWN,
+	NETLIST_DATA_TYPE_BIT,
+	NETLIST_DATA_TYPE_WORD,
+};
+
+enum NetlistSignalDirection
+{
+	NETLIST_DIR_NONE,
+	NETLIST_DIR_IN,
+	NETLIST_DIR_OUT,
+};
+
+// Flags of a signal
+#define NETLIST_SIGNAL_ANONYMOUS    (0x1)
+#define NETLIST_SIGNAL_AUTOMATIC    (0x2)
+#define NETLIST_SIGNAL_WARM_RESET   (0x4)
+
+struct NetlistSignal
+{
+	uint32_t Name;
+	uint32_t Module;
+	uint8_t Behavior;
+	uint8_t DataType;
+	uint8_t Direction;
+	uint8_t Flags;
+	int32_t InitialValue;       // -1 if uninitialized
+	int32_t RegisterNumber;     // -1 if not assigned to a register
+	int32_t BitSliceIndex;      // -1 if not a bit-slice, 16 for the v-bit
+	int32_t DelayCount;
+	uint32_t BaseSignal;        // Source of a bit-slice or delay
+	uint32_t DelaySource;       // Previous tap in the delay chain of a delay
+};
+
+
+struct NetlistInstance
+{
+	uint32_t Name;
+	uint32_t Module;            // Module containing the instance
+	uint32_t Definition;        // Module instanced
+	uint32_t SourceFile;
+	uint32_t SourceLine;
+};
+
+
+// Connection from a signal to a signal.  The instance of each end is NETLIST_NONE for a signal of the
+// connection's own module, and otherwise the signal is a port of the instance's definition.
+struct NetlistConnection
+{
+	uint32_t Module;
+	uint32_t SourceSignal;
+	uint32_t SourceInstance;
+	uint32_t DestinationSignal;
+	uint32_t DestinationInstance;
+};
+
+
+// Values of the Type of a parameter
+enum NetlistParameterType
+{
+	NETLIST_PARAM_ANY,
+	NETLIST_PARAM_INT,
+	NETLIST_PARAM_STRING,
+	NETLIST_PARAM_ENUM,
+	NETLIST_PARAM_ENUM_INT,
+	NETLIST_PARAM_ENUM_OR_INT,
+	NETLIST_PARAM_ARRAY_INT,
+	NETLIST_PARAM_ARRAY_STRING,
+};
+
+// Flags of a parameter
+#define NETLIST_PARAMETER_ASSIGNED  (0x1)       // Set in the source, rather than by default
+
+// Parameter of a silicon object, whose values are one element for scalars, or the elements of an array
+struct NetlistParameter
+{
+	uint32_t Name;
+	uint32_t Module;
+	uint32_t Type;
+	uint32_t Flags;
+	uint32_t FirstValue;
+	uint32_t NumValues;
+};
+
+// Values of the Kind of a parameter value.  Values which are not constants, such as signals or truth functions,
+// are written as NETLIST_VALUE_OTHER, with neither an Int nor a String.
+enum NetlistValueKind
+{
+	NETLIST_VALUE_INT,
+	NETLIST_VALUE_STRING,
+	NETLIST_VALUE_ENUM,
+	NETLIST_VALUE_OTHER,
+};
+
+struct NetlistParameterValue
+{
+	uint32_t Kind;
+	int32_t Int;                // 0 unless an int
+	uint32_t String;            // NETLIST_NONE unless a string or enumerated value
+};
+
+
+// Instruction of an ALU program, with its operands as signal indexes
+struct NetlistAluInstruction
+{
+	uint32_t Module;
+	uint32_t Label;             // NETLIST_NONE if unlabelled
+	uint32_t Function;          // Name of the ALU function, NETLIST_NONE for nop
+
+	uint32_t NumDests;
+	uint32_t Dests[NETLIST_MAX_ALU_DESTS];
+
+	uint32_t NumArgs;
+	uint32_t ConstantArgs;      // Bit mask of arguments which are integer constants rather than signal indexes
+	uint32_t Args[NETLIST_MAX_ALU_ARGS];
+
+	uint32_t BranchConditions[2];
+	int32_t BranchTargets[4];   // Instruction index within the program, -1 if invalid
+
+	uint32_t NumLatches;
+	uint32_t Latches[NETLIST_MAX_ALU_LATCHES];
+
+	uint32_t NumTFOverrides;
+	uint32_t TFOverrides[NETLIST_MAX_ALU_TFS];
+	int32_t TFOverrideValues[NETLIST_MAX_ALU_TFS];
+
+	uint8_t CondBypass;
+	uint8_t CondUpdateVR;
+	uint8_t CondUpdateTF;
+	uint8_t WaitForV;
+	int32_t VOut;               // 0, 1, 2 for v_in, or 3 for hold
+};
+
+
+#endif
@@ -0,0 +1,420 @@
+#include "NetlistWriter.h"
+#include "Alu.h"
+#include "AluInstruction.h"
+#include "AluFunction.h"
+#include "Trace.h"
+#include <string.h>
+
+
+// The netlist enumerations are written as the values of the compiler's own, so they must match
+typedef char CheckBehavior[(int) BEHAVIOR_DELAY == (int) NETLIST_BEHAVIOR_DELAY ? 1 : -1];
+typedef char CheckDataType[(int) DATA_TYPE_WORD == (int) NETLIST_DATA_TYPE_WORD ? 1 : -1];
+typedef char CheckDirection[(int) DIR_OUT == (int) NETLIST_DIR_OUT ? 1 : -1];
+typedef char CheckParameterType[(int) PARAM_ARRAY_STRING == (int) NETLIST_PARAM_ARRAY_STRING ? 1 : -1];
+typedef char CheckAluDests[MAX_ALU_WORD_REGS <= NETLIST_MAX_ALU_DESTS ? 1 : -1];
+typedef char CheckAluLatches[MAX_ALU_WORD_INS <= NETLIST_MAX_ALU_LATCHES ? 1 : -1];
+typedef char CheckAluTFs[MAX_TFS <= NETLIST_MAX_ALU_TFS ? 1 : -1];
+
+
+NetlistWriter::NetlistWriter()
+{
+	// Offset 0 is the empty string
+	strings.push_back('\0');
+	stringOffsets[""] = 0;
+}
+
+
+// Returns the offset of a string in the string section, adding it once
+uint32_t NetlistWriter::String(const char *s)
+{
+	if (s == NULL)
+		return NETLIST_NONE;
+
+	map<string, uint32_t>::iterator iter = stringOffsets.find(s);
+	if (iter != stringOffsets.end())
+		return iter->second;
+
+	uint32_t offset = strings.size();
+	strings.append(s, strlen(s) + 1);
+	stringOffsets[s] = offset;
+	return offset;
+}
+
+uint32_t NetlistWriter::ModuleIndex(const Module *module) const
+{
+	map<const Module*, uint32_t>::const_iterator iter = moduleIndexes.find(module);
+	return (iter != moduleIndexes.end()) ? iter->second : NETLIST_NONE;
+}
+
+// Returns the index of a signal, numbering a signal which is not in any module after those of all modules
+uint32_t NetlistWriter::SignalIndex(const Signal *signal)
+{
+	if (signal == NULL)
+		return NETLIST_NONE;
+
+	map<const Signal*, uint32_t>::const_iterator iter = signalIndexes.find(signal);
+	if (iter != signalIndexes.end())
+		return iter->second;
+
+	uint32_t index = signalIndexes.size();
+	signalIndexes[signal] = index;
+	sharedSignals.push_back(signal);
+	return index;
+}
+
+uint32_t NetlistWriter::InstanceIndex(const Instance *instance) const
+{
+	map<const Instance*, uint32_t>::const_iterator iter = instanceIndexes.find(instance);
+	return (iter != instanceIndexes.end()) ? iter->second : NETLIST_NONE;
+}
+
+
+// Numbers a module, its signals with ports first, and its instances, and then its inner modules
+void NetlistWriter::IndexModule(const Module *module)
+{
+	moduleIndexes[module] = moduleOrder.size();
+	moduleOrder.push_back(module);
+
+	int nsignals = module->SignalCount();
+	for (int port=1; port >= 0; port--)
+	{
+		for (int i=0; i < nsignals; i++)
+		{
+			const Signal *sig = module->GetSignal(i);
+			bool isPort = (sig->Direction == DIR_IN || sig->Direction == DIR_OUT);
+			if (isPort == (port == 1))
+			{
+				uint32_t index = signalIndexes.size();
+				signalIndexes[sig] = index;
+			}
+		}
+	}
+
+	int ninstances = module->InstanceCount();
+	for (int i=0; i < ninstances; i++)
+	{
+		uint32_t index = instanceIndexes.size();
+		instanceIndexes[module->GetInstance(i)] = index;
+	}
+
+	int nmodules = module->InnerModuleCount();
+	for (int i=0; i < nmodules; i++)
+	{
+		const Module *innerModule = module->GetInnerModule(i);
+		if (innerModule)
+			IndexModule(innerModule);
+	}
+}
+
+
+void NetlistWriter::AddSignals(const Module *module, NetlistModule &record)
+{
+	uint32_t moduleIndex = ModuleIndex(module);
+	int nsignals = module->SignalCount();
+
+	record.FirstSignal = signals.size();
+	record.NumPorts = 0;
+
+	for (int port=1; port >= 0; port--)
+	{
+		for (int i=0; i < nsignals; i++)
+		{
+			const Signal *sig = module->GetSignal(i);
+			bool isPort = (sig->Direction == DIR_IN || sig->Direction == DIR_OUT);
+			if (isPort != (port == 1))
+				continue;
+
+			AddSignal(sig, moduleIndex);
+
+			if (isPort)
+				record.NumPorts++;
+		}
+	}
+
+	record.NumSignals = signals.size() - record.FirstSignal;
+}
+
+
+void NetlistWriter::AddSignal(const Signal *sig, uint32_t moduleIndex)
+{
+	NetlistSignal s;
+	memset(&s, 0, sizeof(s));
+	s.Name = String(sig->Name());
+	s.Module = moduleIndex;
+	s.Behavior = sig->Behavior;
+	s.DataType = sig->DataType;
+	s.Direction = sig->Direction;
+	s.Flags = (sig->Anonymous ? NETLIST_SIGNAL_ANONYMOUS : 0) |
+	          (sig->Automatic ? NETLIST_SIGNAL_AUTOMATIC : 0) |
+	          (sig->UsesWarmReset ? NETLIST_SIGNAL_WARM_RESET : 0);
+	s.InitialValue = sig->InitialValue;
+	s.RegisterNumber = sig->RegisterNumber;
+	s.BitSliceIndex = sig->BitSliceIndex;
+	s.DelayCount = sig->DelayCount;
+	s.BaseSignal = SignalIndex(sig->BaseSignal);
+	s.DelaySource = SignalIndex(sig->DelaySource);
+	signals.push_back(s);
+}
+
+
+void NetlistWriter::AddAluInstructions(const Alu *alu)
+{
+	uint32_t moduleIndex = ModuleIndex(alu);
+
+	for (int i=0; i < alu->num_instructions; i++)
+	{
+		const AluInstruction *inst = alu->instructions[i];
+
+		NetlistAluInstruction r;
+		memset(&r, 0, sizeof(r));
+		r.Module = moduleIndex;
+		r.Label = String(inst->Label());
+		r.Function = inst->fcn.Fcn ? String(inst->fcn.Fcn->Name()) : NETLIST_NONE;
+
+		r.NumDests = inst->num_dests;
+		for (int j=0; j < NETLIST_MAX_ALU_DESTS; j++)
+			r.Dests[j] = (j < inst->num_dests) ? SignalIndex(inst->dests[j]) : NETLIST_NONE;
+
+		r.NumArgs = inst->fcn.Fcn ? inst->fcn.Fcn->NumArgs() : 0;
+		for (int j=0; j < NETLIST_MAX_ALU_ARGS; j++)
+		{
+			if (j >= (int) r.NumArgs)
+			{
+				r.Args[j] = NETLIST_NONE;
+			}
+			else if (inst->fcn.Fcn->ArgType(j) == 'k')
+			{
+				r.ConstantArgs |= 1 << j;
+				r.Args[j] = inst->fcn.Args[j].i;
+			}
+			else
+			{
+				r.Args[j] = SignalIndex(inst->fcn.Args[j].sig);
+			}
+		}
+
+		for (int j=0; j < 2; j++)
+			r.BranchConditions[j] = SignalIndex(inst->branch_conds[j]);
+		for (int j=0; j < 4; j++)
+			r.BranchTargets[j] = inst->branch_indexes[j];
+
+		r.NumLatches = inst->num_latches;
+		for (int j=0; j < NETLIST_MAX_ALU_LATCHES; j++)
+			r.Latches[j] = (j < inst->num_latches) ? SignalIndex(inst->latches[j]) : NETLIST_NONE;
+
+		r.NumTFOverrides = inst->num_tf_overrides;
+		for (int j=0; j < NETLIST_MAX_ALU_TFS; j++)
+		{
+			bool used = (j < inst->num_tf_overrides);
+			r.TFOverrides[j] = used ? SignalIndex(inst->tf_overrides[j]) : NETLIST_NONE;
+			r.TFOverrideValues[j] = used ? inst->tf_override_values[j] : 0;
+		}
+
+		r.CondBypass = inst->cond_bypass;
+		r.CondUpdateVR = inst->cond_update_vr;
+		r.CondUpdateTF = inst->cond_update_tf;
+		r.WaitForV = inst->wait_for_v;
+		r.VOut = inst->v_out;
+
+		aluInstructions.push_back(r);
+	}
+}
+
+
+// Adds the records of one module, after all modules are indexed
+void NetlistWriter::AddModule(const Module *module)
+{
+	uint32_t moduleIndex = ModuleIndex(module);
+
+	NetlistModule record;
+	memset(&record, 0, sizeof(record));
+	record.Name = String(module->MangledName().c_str());
+	record.LocalName = String(module->Name());
+	record.TypeName = String(module->ModuleTypeName());
+	record.Parent = ModuleIndex(module->ParentModule());
+	record.SharedDefinition = ModuleIndex(module->SharedDefinition());
+	record.Flags = (module->IsExtern() ? NETLIST_MODULE_EXTERN : 0) | (module->IsFPOA() ? NETLIST_MODULE_FPOA : 0);
+	record.SourceFile = String(module->Location.Filename);
+	record.SourceLine = module->Location.Line;
+
+	AddSignals(module, record);
+
+	// Instances
+	record.FirstInstance = instances.size();
+	int ninstances = module->InstanceCount();
+	for (int i=0; i < ninstances; i++)
+	{
+		const Instance *instance = module->GetInstance(i);
+
+		NetlistInstance r;
+		r.Name = String(instance->Name());
+		r.Module = moduleIndex;
+		r.Definition = ModuleIndex(instance->Definition);
+		r.SourceFile = String(instance->Location.Filename);
+		r.SourceLine = instance->Location.Line;
+		instances.push_back(r);
+	}
+	record.NumInstances = ninstances;
+
+	// Connections, which are all resolved
+	record.FirstConnection = connections.size();
+	int nconnections = module->ConnectionCount();
+	for (int i=0; i < nconnections; i++)
+	{
+		const Connection *connection = module->GetConnection(i);
+
+		NetlistConnection r;
+		r.Module = moduleIndex;
+		r.SourceSignal = SignalIndex(connection->Source.ResolvedSignal);
+		r.SourceInstance = InstanceIndex(connection->Source.ResolvedInstance);
+		r.DestinationSignal = SignalIndex(connection->Destination.ResolvedSignal);
+		r.DestinationInstance = InstanceIndex(connection->Destination.ResolvedInstance);
+		connections.push_back(r);
+	}
+	record.NumConnections = nconnections;
+
+	// Parameters, with array elements as separate values
+	record.FirstParameter = parameters.size();
+	int nparams = module->ParameterCount();
+	for (int i=0; i < nparams; i++)
+	{
+		const Parameter *param = module->GetParameter(i);
+
+		NetlistParameter r;
+		r.Name = String(param->Name());
+		r.Module = moduleIndex;
+		r.Type = param->Definition ? param->Definition->DataType : PARAM_ANY;
+		r.Flags = param->Assigned ? NETLIST_PARAMETER_ASSIGNED : 0;
+		r.FirstValue = parameterValues.size();
+
+		vector<Expression> values;
+		if (param->Value.type == EXPRESSION_ARRAY)
+		{
+			int n = param->Value.val.array->Count();
+			for (int j=0; j < n; j++)
+				values.push_back(param->Value.val.array->GetValue(j));
+		}
+		else if (param->Value.type != EXPRESSION_UNKNOWN)
+		{
+			values.push_back(param->Value);
+		}
+
+		for (int j=0; j < (int) values.size(); j++)
+		{
+			NetlistParameterValue v;
+			v.Int = 0;
+			v.String = NETLIST_NONE;
+			switch (values[j].type)
+			{
+				case CONST_INT:
+					v.Kind = NETLIST_VALUE_INT;
+					v.Int = values[j].val.i;
+					break;
+				case CONST_STRING:
+					v.Kind = NETLIST_VALUE_STRING;
+					v.String = String(values[j].val.s);
+					break;
+				case CONST_ENUM:
+					v.Kind = NETLIST_VALUE_ENUM;
+					v.String = String(values[j].val.s);
+					break;
+				default:
+					v.Kind = NETLIST_VALUE_OTHER;
+					break;
+			}
+			parameterValues.push_back(v);
+		}
+
+		r.NumValues = values.size();
+		parameters.push_back(r);
+	}
+	record.NumParameters = nparams;
+
+	// ALU program
+	record.FirstAluInstruction = aluInstructions.size();
+	const Alu *alu = dynamic_cast<const Alu*>(module);
+	if (alu)
+		AddAluInstructions(alu);
+	record.NumAluInstructions = aluInstructions.size() - record.FirstAluInstruction;
+
+	modules.push_back(record);
+}
+
+
+// Sections are aligned to 8 bytes
+static uint32_t Align(uint32_t offset)
+{
+	return (offset + 7) & ~7u;
+}
+
+// Writes zeros up to the given offset
+static bool Pad(FILE *f, uint32_t from, uint32_t to)
+{
+	static const char padding[8] = { 0 };
+	return fwrite(padding, 1, to - from, f) == to - from;
+}
+
+
+bool NetlistWriter::Write(FILE *f, const StringMap &designModules)
+{
+	TraceSpan span("WriteNetlist pass");
+
+	for (int i=0; i < designModules.Count(); i++)
+		IndexModule((const Module *) designModules.Get(i));
+
+	for (int i=0; i < (int) moduleOrder.size(); i++)
+		AddModule(moduleOrder[i]);
+
+	// Referencing a shared signal can number another, so the list may grow while it is written
+	for (int i=0; i < (int) sharedSignals.size(); i++)
+		AddSignal(sharedSignals[i], NETLIST_NONE);
+
+	// Contents of each section, in order of NetlistSectionId
+	struct SectionData
+	{
+		const void *Data;
+		uint32_t Count;
+		uint32_t RecordSize;
+	};
+	SectionData sections[NETLIST_NUM_SECTIONS] =
+	{
+		{ strings.data(),                                       (uint32_t) strings.size(),          1 },
+		{ modules.empty() ? NULL : &modules[0],                 (uint32_t) modules.size(),          sizeof(NetlistModule) },
+		{ signals.empty() ? NULL : &signals[0],                 (uint32_t) signals.size(),          sizeof(NetlistSignal) },
+		{ instances.empty() ? NULL : &instances[0],             (uint32_t) instances.size(),        sizeof(NetlistInstance) },
+		{ connections.empty() ? NULL : &connections[0],         (uint32_t) connections.size(),      sizeof(NetlistConnection) },
+		{ parameters.empty() ? NULL : &parameters[0],           (uint32_t) parameters.size(),       sizeof(NetlistParameter) },
+		{ parameterValues.empty() ? NULL : &parameterValues[0], (uint32_t) parameterValues.size(),  sizeof(NetlistParameterValue) },
+		{ aluInstructions.empty() ? NULL : &aluInstructions[0], (uint32_t) aluInstructions.size(),  sizeof(NetlistAluInstruction) },
+	};
+
+	// Lay out the sections after the header
+	NetlistHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.Magic, NETLIST_MAGIC, 4);
+	header.Version = NETLIST_VERSION;
+	header.ByteOrder = NETLIST_BYTE_ORDER;
+
+	uint32_t offset = Align(sizeof(header));
+	for (int i=0; i < NETLIST_NUM_SECTIONS; i++)
+	{
+		header.Sections[i].Offset = offset;
+		header.Sections[i].Count = sections[i].Count;
+		header.Sections[i].RecordSize = sections[i].RecordSize;
+		offset = Align(offset + sections[i].Count * sections[i].RecordSize);
+	}
+	header.FileSize = offset;
+
+	// Write the header and sections, with padding between them
+	bool ok = (fwrite(&header, 1, sizeof(header), f) == sizeof(header));
+	offset = sizeof(header);
+
+	for (int i=0; i < NETLIST_NUM_SECTIONS && ok; i++)
+	{
+		uint32_t size = sections[i].Count * sections[i].RecordSize;
+		ok = Pad(f, offset, header.Sections[i].Offset) && (size == 0 || fwrite(sections[i].Data, 1, size, f) == size);
+		offset = header.Sections[i].Offset + size;
+	}
+
+	return ok && Pad(f, offset, header.FileSize);
+}
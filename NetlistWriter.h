@@ -0,0 +1,63 @@
+#ifndef NETLIST_WRITER_H
+#define NETLIST_WRITER_H
+
+#include "Module.h"
+#include "NetlistFormat.h"
+
+#include <stdio.h>
+#include <map>
+#include <string>
+#include <vector>
+using namespace std;
+
+class Alu;
+
+
+// Writes the resolved design as a binary netlist, described in NetlistFormat.h, after ResolveConnections.
+//
+// All top-level modules and their inner modules are numbered first, so that records can refer to each other
+// by index, and the sections are then written in order.  Output depends only on the design, not on addresses.
+class NetlistWriter
+{
+public:
+	NetlistWriter();
+
+	// Writes all top-level modules and their inner modules.  Returns false if the file cannot be written.
+	bool Write(FILE *f, const StringMap &modules);
+
+private:
+	void IndexModule(const Module *module);
+	void AddModule(const Module *module);
+	void AddSignals(const Module *module, NetlistModule &record);
+	void AddSignal(const Signal *sig, uint32_t moduleIndex);
+	void AddAluInstructions(const Alu *alu);
+
+	uint32_t String(const char *s);
+	uint32_t ModuleIndex(const Module *module) const;
+	uint32_t SignalIndex(const Signal *signal);
+	uint32_t InstanceIndex(const Instance *instance) const;
+
+	// Modules in output order, and the index of every module, signal and instance
+	vector<const Module*> moduleOrder;
+	map<const Module*, uint32_t> moduleIndexes;
+	map<const Signal*, uint32_t> signalIndexes;
+	map<const Instance*, uint32_t> instanceIndexes;
+
+	// Signals referenced but not in any module, such as the built-in signals of silicon objects
+	vector<const Signal*> sharedSignals;
+
+	// Strings by value, and the string section
+	map<string, uint32_t> stringOffsets;
+	string strings;
+
+	vector<NetlistModule> modules;
+	vector<NetlistSignal> signals;
+	vector<NetlistInstance> instances;
+	vector<NetlistConnection> connections;
+	vector<NetlistParameter> parameters;
+	vector<NetlistParameterValue> parameterValues;
+	vector<NetlistAluInstruction> aluInstructions;
+};
+
+
+#endif
@@ -3,6 +3,41 @@
 #include "Common.h"
 
 #include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+
+
+// Reports a value not accepted by a parameter as one error, with what the parameter expects
+static void ReportIllegalValue(const char *name, const Expression &expr, const string &expects)
+{
+	char *value = NULL;
+	size_t length = 0;
+	FILE *f = open_memstream(&value, &length);
+	if (f)
+	{
+		expr.Print(f);
+		fclose(f);
+	}
+
+	yyerrorf("Illegal value: %s.  Parameter '%s' expects %s", value ? value : "", name, expects.c_str());
+	free(value);
+}
+
+// Describes the expected size of an array parameter, such as "an array of 2 to 4 integers"
+static string ArrayExpectation(const ParameterDefinition *definition, const char *elements)
+{
+	char buffer[128];
+	if (definition->MinArraySize <= 0 && definition->MaxArraySize < 0)
+		snprintf(buffer, sizeof(buffer), "an array of %s", elements);
+	else if (definition->MaxArraySize < 0)
+		snprintf(buffer, sizeof(buffer), "an array of at least %d %s", definition->MinArraySize, elements);
+	else if (definition->MinArraySize == definition->MaxArraySize)
+		snprintf(buffer, sizeof(buffer), "an array of %d %s", definition->MinArraySize, elements);
+	else
+		snprintf(buffer, sizeof(buffer), "an array of %d to %d %s", definition->MinArraySize, definition->MaxArraySize, elements);
+	return buffer;
+}
 
 //
 // Parameter definition containing metadata across all instances of the parameter
@@ -10,53 +45,68 @@
 
 // default
 ParameterDefinition::ParameterDefinition(const char *name, ParameterType dataType, const Expression &defaultValue, long intMask)
-	: Symbol(name), DataType(dataType), MinIntegerValue(NO_MINIMUM_VALUE), MaxIntegerValue(NO_MAXIMUM_VALUE), EnumValues(NULL), IntValues(NULL), NumEnumValues(0), MinArraySize(0), MaxArraySize(-1), IntegerMask(intMask), DefaultValue(defaultValue)
+	: Symbol(name), DataType(dataType), MinIntegerValue(NO_MINIMUM_VALUE), MaxIntegerValue(NO_MAXIMUM_VALUE), EnumValues(NULL), IntValues(NULL), NumEnumValues(0), MinArraySize(0), MaxArraySize(-1), IntegerMask(intMask), DefaultValue(defaultValue), ownsValues(true)
 {
 }
 
 // int
 ParameterDefinition::ParameterDefinition(const char *name, long minValue, long maxValue, long defaultIntValue, long intMask)
-	: Symbol(name), DataType(PARAM_INT), MinIntegerValue(minValue), MaxIntegerValue(maxValue), EnumValues(NULL), IntValues(NULL), NumEnumValues(0), MinArraySize(0), MaxArraySize(-1), IntegerMask(intMask), DefaultValue(Expression::FromInt(defaultIntValue))
+	: Symbol(name), DataType(PARAM_INT), MinIntegerValue(minValue), MaxIntegerValue(maxValue), EnumValues(NULL), IntValues(NULL), NumEnumValues(0), MinArraySize(0), MaxArraySize(-1), IntegerMask(intMask), DefaultValue(Expression::FromInt(defaultIntValue)), ownsValues(true)
 {
 }
 
 // string
 ParameterDefinition::ParameterDefinition(const char *name, const char *defaultString)
-	: Symbol(name), DataType(PARAM_STRING), MinIntegerValue(NO_MINIMUM_VALUE), MaxIntegerValue(NO_MAXIMUM_VALUE), EnumValues(NULL), IntValues(NULL), NumEnumValues(0), MinArraySize(0), MaxArraySize(-1), IntegerMask(-1), DefaultValue(Expression::FromString(defaultString))
+	: Symbol(name), DataType(PARAM_STRING), MinIntegerValue(NO_MINIMUM_VALUE), MaxIntegerValue(NO_MAXIMUM_VALUE), EnumValues(NULL), IntValues(NULL), NumEnumValues(0), MinArraySize(0), MaxArraySize(-1), IntegerMask(-1), DefaultValue(Expression::FromString(defaultString)), ownsValues(true)
 {
 }
 
 // enum
 ParameterDefinition::ParameterDefinition(const char *name, const char *enumValues[], int numEnumValues, const char *defaultEnumValueString)
-	: Symbol(name), DataType(PARAM_ENUM), MinIntegerValue(NO_MINIMUM_VALUE), MaxIntegerValue(NO_MAXIMUM_VALUE), EnumValues(NULL), IntValues(NULL), NumEnumValues(0), MinArraySize(0), MaxArraySize(-1), IntegerMask(-1), DefaultValue(Expression::FromEnum(defaultEnumValueString))
+	: Symbol(name), DataType(PARAM_ENUM), MinIntegerValue(NO_MINIMUM_VALUE), MaxIntegerValue(NO_MAXIMUM_VALUE), EnumValues(NULL), IntValues(NULL), NumEnumValues(0), MinArraySize(0), MaxArraySize(-1), IntegerMask(-1), DefaultValue(Expression::FromEnum(defaultEnumValueString)), ownsValues(true)
 {
 	InitEnumValues(numEnumValues, enumValues);
 }
 
 // enum int
 ParameterDefinition::ParameterDefinition(const char *name, long intValues[], int numIntValues, long defaultIntValue)
-	: Symbol(name), DataType(PARAM_ENUM_INT), MinIntegerValue(NO_MINIMUM_VALUE), MaxIntegerValue(NO_MAXIMUM_VALUE), EnumValues(NULL), IntValues(NULL), NumEnumValues(0), MinArraySize(0), MaxArraySize(-1), IntegerMask(-1), DefaultValue(Expression::FromInt(defaultIntValue))
+	: Symbol(name), DataType(PARAM_ENUM_INT), MinIntegerValue(NO_MINIMUM_VALUE), MaxIntegerValue(NO_MAXIMUM_VALUE), EnumValues(NULL), IntValues(NULL), NumEnumValues(0), MinArraySize(0), MaxArraySize(-1), IntegerMask(-1), DefaultValue(Expression::FromInt(defaultIntValue)), ownsValues(true)
 {
 	InitIntValues(numIntValues, intValues);
 }
 
 // enum or int
 ParameterDefinition::ParameterDefinition(const char *name, const char *enumValues[], int numEnumValues, long minValue, long maxValue, const Expression &defaultValue, long intMask)
-	: Symbol(name), DataType(PARAM_ENUM_OR_INT), MinIntegerValue(minValue), MaxIntegerValue(maxValue), EnumValues(NULL), IntValues(NULL), NumEnumValues(0), MinArraySize(0), MaxArraySize(-1), IntegerMask(intMask), DefaultValue(defaultValue)
+	: Symbol(name), DataType(PARAM_ENUM_OR_INT), MinIntegerValue(minValue), MaxIntegerValue(maxValue), EnumValues(NULL), IntValues(NULL), NumEnumValues(0), MinArraySize(0), MaxArraySize(-1), IntegerMask(intMask), DefaultValue(defaultValue), ownsValues(true)
 {
 	InitEnumValues(numEnumValues, enumValues);
 }
 
 // int array
 ParameterDefinition::ParameterDefinition(const char *name, long minValue, long maxValue, int minSize, int maxSize, long intMask)
-	: Symbol(name), DataType(PARAM_ARRAY_INT), MinIntegerValue(minValue), MaxIntegerValue(maxValue), EnumValues(NULL), IntValues(NULL), NumEnumValues(0), MinArraySize(minSize), MaxArraySize(maxSize), IntegerMask(intMask), DefaultValue(Expression::Array())
+	: Symbol(name), DataType(PARAM_ARRAY_INT), MinIntegerValue(minValue), MaxIntegerValue(maxValue), EnumValues(NULL), IntValues(NULL), NumEnumValues(0), MinArraySize(minSize), MaxArraySize(maxSize), IntegerMask(intMask), DefaultValue(Expression::Array()), ownsValues(true)
 {
 }
 
 // string array
 ParameterDefinition::ParameterDefinition(const char *name, int minSize, int maxSize)
-	: Symbol(name), DataType(PARAM_ARRAY_STRING), MinIntegerValue(NO_MINIMUM_VALUE), MaxIntegerValue(NO_MAXIMUM_VALUE), EnumValues(NULL), IntValues(NULL), NumEnumValues(0), MinArraySize(0), MaxArraySize(minSize), IntegerMask(maxSize), DefaultValue(Expression::Array())
+	: Symbol(name), DataType(PARAM_ARRAY_STRING), MinIntegerValue(NO_MINIMUM_VALUE), MaxIntegerValue(NO_MAXIMUM_VALUE), EnumValues(NULL), IntValues(NULL), NumEnumValues(0), MinArraySize(0), MaxArraySize(minSize), IntegerMask(maxSize), DefaultValue(Expression::Array()), ownsValues(true)
+{
+}
+
+
+
+
+// built-in
+ParameterDefinition::ParameterDefinition(const ParameterTableEntry &entry)
+	: Symbol(entry.Name), DataType(entry.DataType), MinIntegerValue(entry.MinIntegerValue), MaxIntegerValue(entry.MaxIntegerValue), EnumValues(entry.EnumValues), IntValues(entry.IntValues), NumEnumValues(entry.NumEnumValues), MinArraySize(entry.MinArraySize), MaxArraySize(entry.MaxArraySize), IntegerMask(entry.IntegerMask), DefaultValue(Expression::FromInt(entry.DefaultInt)), ownsValues(false)
 {
+	if (DataType == PARAM_STRING)
+		DefaultValue = Expression::FromString(entry.DefaultString);
+	else if (DataType == PARAM_ENUM)
+		DefaultValue = Expression::FromEnum(entry.DefaultString);
+	else if (DataType == PARAM_ARRAY_INT || DataType == PARAM_ARRAY_STRING)
+		DefaultValue = Expression::Array();
 }
 
 
@@ -64,8 +114,13 @@ ParameterDefinition::ParameterDefinition(const char *name, int minSize, int maxS
 
 ParameterDefinition::~ParameterDefinition()
 {
-	delete [] EnumValues;  EnumValues = NULL;
-	delete [] IntValues;   IntValues = NULL;
+	if (ownsValues)
+	{
+		delete [] EnumValues;
+		delete [] IntValues;
+	}
+	EnumValues = NULL;
+	IntValues = NULL;
 	NumEnumValues = 0;
 	DefaultValue.Delete();
 }
@@ -171,13 +226,14 @@ void ParameterDefinition::InitEnumValues(int count, const char *values[])
 		return;
 	}
 	
-	EnumValues = new const char*[count];
+	const char **copy = new const char*[count];
 	NumEnumValues = count;
 
 	for (int i=0; i < count; i++)
 	{
-		EnumValues[i] = values[i];
+		copy[i] = values[i];
 	}
+	EnumValues = copy;
 }
 
 void ParameterDefinition::InitIntValues(int count, long values[])
@@ -189,13 +245,14 @@ void ParameterDefinition::InitIntValues(int count, long values[])
 		return;
 	}
 	
-	IntValues = new long[count];
+	long *copy = new long[count];
 	NumEnumValues = count;
 
 	for (int i=0; i < count; i++)
 	{
-		IntValues[i] = values[i];
+		copy[i] = values[i];
 	}
+	IntValues = copy;
 }
 
 
@@ -260,9 +317,7 @@ bool Parameter::SetValue(const Expression &expr)
 	{
 		if (expr.type != CONST_INT)
 		{
-			yyerrorf("Illegal value: ");
-			expr.Print(stderr);
-			fprintf(stderr, "\nParameter '%s' expects an integer value", Name());
+			ReportIllegalValue(Name(), expr, "an integer value");
 			return false;
 		}
 		else if (expr.val.i < Definition->MinIntegerValue || expr.val.i > Definition->MaxIntegerValue)
@@ -290,15 +345,14 @@ bool Parameter::SetValue(const Expression &expr)
 
 		if (!ok)
 		{
-			yyerrorf("Illegal value: ");
-			expr.Print(stderr);
-			fprintf(stderr, "\nParameter '%s' expects one of: ", Name());
+			string expects = "one of: ";
 			for (int i=0; i < Definition->NumEnumValues; i++)
 			{
-				fprintf(stderr, "%s", Definition->EnumValues[i]);
+				expects += Definition->EnumValues[i];
 				if (i < Definition->NumEnumValues-1)
-					fprintf(stderr, ", ");
+					expects += ", ";
 			}
+			ReportIllegalValue(Name(), expr, expects);
 			return false;
 		}
 	}
@@ -320,15 +374,16 @@ bool Parameter::SetValue(const Expression &expr)
 
 		if (!ok)
 		{
-			yyerrorf("Illegal value: ");
-			expr.Print(stderr);
-			fprintf(stderr, "\nParameter '%s' expects one of: ", Name());
+			string expects = "one of: ";
 			for (int i=0; i < Definition->NumEnumValues; i++)
 			{
-				fprintf(stderr, "%ld", Definition->IntValues[i]);
+				char value[32];
+				snprintf(value, sizeof(value), "%ld", Definition->IntValues[i]);
+				expects += value;
 				if (i < Definition->NumEnumValues-1)
-					fprintf(stderr, ", ");
+					expects += ", ";
 			}
+			ReportIllegalValue(Name(), expr, expects);
 			return false;
 		}
 	}
@@ -357,16 +412,19 @@ bool Parameter::SetValue(const Expression &expr)
 
 		if (!ok)
 		{
-			yyerrorf("Illegal value: ");
-			expr.Print(stderr);
-			fprintf(stderr, "\nParameter '%s' expects one of: ", Name());
+			string expects = "one of: ";
 			for (int i=0; i < Definition->NumEnumValues; i++)
 			{
-				fprintf(stderr, "%s", Definition->EnumValues[i]);
+				expects += Definition->EnumValues[i];
 				if (i < Definition->NumEnumValues-1)
-					fprintf(stderr, ", ");
+					expects += ", ";
 			}
-			fprintf(stderr, " or a value from %ld to %ld", Definition->MinIntegerValue, Definition->MaxIntegerValue);
+
+			char range[64];
+			snprintf(range, sizeof(range), " or a value from %ld to %ld", Definition->MinIntegerValue, Definition->MaxIntegerValue);
+			expects += range;
+
+			ReportIllegalValue(Name(), expr, expects);
 			return false;
 		}
 	}
@@ -376,9 +434,7 @@ bool Parameter::SetValue(const Expression &expr)
 	{
 		if (expr.type != CONST_STRING)
 		{
-			yyerrorf("Illegal value: ");
-			expr.Print(stderr);
-			fprintf(stderr, "\nParameter '%s' expects a string", Name());
+			ReportIllegalValue(Name(), expr, "a string");
 			return false;
 		}
 		ok = true;
@@ -412,18 +468,7 @@ bool Parameter::SetValue(const Expression &expr)
 
 		if (!ok)
 		{
-			yyerrorf("Illegal value: ");
-			expr.Print(stderr);
-
-			if (Definition->MinArraySize <= 0 && Definition->MaxArraySize < 0)
-				fprintf(stderr, "\nParameter '%s' expects an array of integers", Name());
-			else if (Definition->MaxArraySize < 0)
-				fprintf(stderr, "\nParameter '%s' expects an array of at least %d integers", Name(), Definition->MinArraySize);
-			else if (Definition->MinArraySize == Definition->MaxArraySize)
-				fprintf(stderr, "\nParameter '%s' expects an array of %d integers", Name(), Definition->MinArraySize);
-			else
-				fprintf(stderr, "\nParameter '%s' expects an array of %d to %d integers", Name(), Definition->MinArraySize, Definition->MaxArraySize);
-
+			ReportIllegalValue(Name(), expr, ArrayExpectation(Definition, "integers"));
 			return false;
 		}
 	}
@@ -456,18 +501,7 @@ bool Parameter::SetValue(const Expression &expr)
 
 		if (!ok)
 		{
-			yyerrorf("Illegal value: ");
-			expr.Print(stderr);
-
-			if (Definition->MinArraySize <= 0 && Definition->MaxArraySize < 0)
-				fprintf(stderr, "\nParameter '%s' expects an array of strings", Name());
-			else if (Definition->MaxArraySize < 0)
-				fprintf(stderr, "\nParameter '%s' expects an array of at least %d strings", Name(), Definition->MinArraySize);
-			else if (Definition->MinArraySize == Definition->MaxArraySize)
-				fprintf(stderr, "\nParameter '%s' expects an array of %d strings", Name(), Definition->MinArraySize);
-			else
-				fprintf(stderr, "\nParameter '%s' expects an array of %d to %d strings", Name(), Definition->MinArraySize, Definition->MaxArraySize);
-
+			ReportIllegalValue(Name(), expr, ArrayExpectation(Definition, "strings"));
 			return false;
 		}
 	}
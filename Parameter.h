@@ -5,6 +5,7 @@
 #include "Symbol.h"
 #include "Expression.h"
 #include "Common.h"
+#include "AllocTracked.h"
 
 #define NO_MINIMUM_VALUE    (-2147483647)
 #define NO_MAXIMUM_VALUE     (2147483647)
@@ -22,7 +23,37 @@ enum ParameterType
 	PARAM_ARRAY_STRING,
 };
 
-class ParameterDefinition : public Symbol
+// Static description of a parameter of a built-in silicon object, initialized at compile time
+struct ParameterTableEntry
+{
+	const char *Name;
+	ParameterType DataType;
+	long MinIntegerValue;
+	long MaxIntegerValue;
+	const char *const *EnumValues;
+	const long *IntValues;
+	int NumEnumValues;
+	int MinArraySize;
+	int MaxArraySize;
+	long IntegerMask;
+	long DefaultInt;
+	const char *DefaultString;              // Default of string and enum parameters
+};
+
+// Rows of a ParameterTableEntry table, matching the ParameterDefinition constructors
+#define TABLE_PARAM_INT(name, minValue, maxValue, defaultValue) \
+	{ name, PARAM_INT, minValue, maxValue, NULL, NULL, 0, 0, -1, 0xFFFF, defaultValue, NULL }
+#define TABLE_PARAM_STRING(name, defaultString) \
+	{ name, PARAM_STRING, NO_MINIMUM_VALUE, NO_MAXIMUM_VALUE, NULL, NULL, 0, 0, -1, -1, 0, defaultString }
+#define TABLE_PARAM_ENUM(name, values, defaultEnum) \
+	{ name, PARAM_ENUM, NO_MINIMUM_VALUE, NO_MAXIMUM_VALUE, values, NULL, countof(values), 0, -1, -1, 0, defaultEnum }
+#define TABLE_PARAM_ENUM_INT(name, values, defaultValue) \
+	{ name, PARAM_ENUM_INT, NO_MINIMUM_VALUE, NO_MAXIMUM_VALUE, NULL, values, countof(values), 0, -1, -1, defaultValue, NULL }
+#define TABLE_PARAM_ARRAY_INT(name, minValue, maxValue, minSize, maxSize, intMask) \
+	{ name, PARAM_ARRAY_INT, minValue, maxValue, NULL, NULL, 0, minSize, maxSize, intMask, 0, NULL }
+
+
+class ParameterDefinition : public Symbol, public AllocTracked<ALLOC_PARAMETER>
 {
 public:
 
@@ -50,6 +81,9 @@ public:
 	// string array
 	ParameterDefinition(const char *name, int minSize, int maxSize);
 
+	// built-in, referring to the enumerated values of a static table rather than copying them
+	ParameterDefinition(const ParameterTableEntry &entry);
+
 	virtual ~ParameterDefinition();
 
 	virtual SymbolTypeId SymbolType() const { return SYMBOL_PARAMETER; }
@@ -60,8 +94,8 @@ public:
 	long MinIntegerValue;
 	long MaxIntegerValue;
 
-	const char **EnumValues;
-	long *IntValues;
+	const char *const *EnumValues;
+	const long *IntValues;
 	int NumEnumValues;
 
 	int MinArraySize;
@@ -74,10 +108,12 @@ public:
 private:
 	void InitEnumValues(int count, const char *values[]);
 	void InitIntValues(int count, long values[]);
+
+	bool ownsValues;
 };
 
 
-class Parameter
+class Parameter : public AllocTracked<ALLOC_PARAMETER>
 {
 public:
 	Parameter(const ParameterDefinition *definition);
@@ -52,83 +52,86 @@ const SiliconObjectDefinition *RF_RAM::Definition() const
 	return BuiltinDefinition();
 }
 
-const SiliconObjectDefinition *RF_RAM::BuiltinDefinition()
+// RF_RAM Signals
+static const PortTableEntry rfRamPorts[] =
 {
-	// Return singleton instance if already created
-	if (definition)
-		return definition;
+	{ "wr",                             DATA_TYPE_BIT,  DIR_IN },
+	{ "wr_addr",                        DATA_TYPE_WORD, DIR_IN },
 
-	// Create a new builtin singleton symbol table instance
-	SymbolTable *symbols = new SymbolTable(true);
+	{ "wr_data0_word",                  DATA_TYPE_WORD, DIR_IN },
+	{ "wr_data0_tag0",                  DATA_TYPE_BIT,  DIR_IN },
+	{ "wr_data0_tag1",                  DATA_TYPE_BIT,  DIR_IN },
+	{ "wr_data0_tag2",                  DATA_TYPE_BIT,  DIR_IN },
+	{ "wr_data0_tag3",                  DATA_TYPE_BIT,  DIR_IN },
 
+	{ "be_wr_data0_word_bits15to8",     DATA_TYPE_BIT,  DIR_IN },
+	{ "be_wr_data0_word_bits7to0",      DATA_TYPE_BIT,  DIR_IN },
+	{ "be_wr_data0_tags",               DATA_TYPE_BIT,  DIR_IN },
 
-	// RF_RAM Signals
-	symbols->Add(new Signal("wr",								BEHAVIOR_BUILTIN, DATA_TYPE_BIT,  DIR_IN ));
-	symbols->Add(new Signal("wr_addr",							BEHAVIOR_BUILTIN, DATA_TYPE_WORD, DIR_IN ));
+	{ "wr_data1_word",                  DATA_TYPE_WORD, DIR_IN },
+	{ "wr_data1_tag0",                  DATA_TYPE_BIT,  DIR_IN },
+	{ "wr_data1_tag1",                  DATA_TYPE_BIT,  DIR_IN },
+	{ "wr_data1_tag2",                  DATA_TYPE_BIT,  DIR_IN },
+	{ "wr_data1_tag3",                  DATA_TYPE_BIT,  DIR_IN },
 
-	symbols->Add(new Signal("wr_data0_word",					BEHAVIOR_BUILTIN, DATA_TYPE_WORD, DIR_IN ));
-	symbols->Add(new Signal("wr_data0_tag0",					BEHAVIOR_BUILTIN, DATA_TYPE_BIT,  DIR_IN ));
-	symbols->Add(new Signal("wr_data0_tag1",					BEHAVIOR_BUILTIN, DATA_TYPE_BIT,  DIR_IN ));
-	symbols->Add(new Signal("wr_data0_tag2",					BEHAVIOR_BUILTIN, DATA_TYPE_BIT,  DIR_IN ));
-	symbols->Add(new Signal("wr_data0_tag3",					BEHAVIOR_BUILTIN, DATA_TYPE_BIT,  DIR_IN ));
+	{ "be_wr_data1_word_bits15to8",     DATA_TYPE_BIT,  DIR_IN },
+	{ "be_wr_data1_word_bits7to0",      DATA_TYPE_BIT,  DIR_IN },
+	{ "be_wr_data1_tags",               DATA_TYPE_BIT,  DIR_IN },
 
-	symbols->Add(new Signal("be_wr_data0_word_bits15to8",       BEHAVIOR_BUILTIN, DATA_TYPE_BIT,  DIR_IN ));
-	symbols->Add(new Signal("be_wr_data0_word_bits7to0",        BEHAVIOR_BUILTIN, DATA_TYPE_BIT,  DIR_IN ));
-	symbols->Add(new Signal("be_wr_data0_tags",                 BEHAVIOR_BUILTIN, DATA_TYPE_BIT,  DIR_IN ));
 
-	symbols->Add(new Signal("wr_data1_word",					BEHAVIOR_BUILTIN, DATA_TYPE_WORD, DIR_IN ));
-	symbols->Add(new Signal("wr_data1_tag0",					BEHAVIOR_BUILTIN, DATA_TYPE_BIT,  DIR_IN ));
-	symbols->Add(new Signal("wr_data1_tag1",					BEHAVIOR_BUILTIN, DATA_TYPE_BIT,  DIR_IN ));
-	symbols->Add(new Signal("wr_data1_tag2",					BEHAVIOR_BUILTIN, DATA_TYPE_BIT,  DIR_IN ));
-	symbols->Add(new Signal("wr_data1_tag3",					BEHAVIOR_BUILTIN, DATA_TYPE_BIT,  DIR_IN ));
+	{ "rd",                             DATA_TYPE_BIT,  DIR_IN },
+	{ "rd_addr",                        DATA_TYPE_WORD, DIR_IN },
 
-	symbols->Add(new Signal("be_wr_data1_word_bits15to8",       BEHAVIOR_BUILTIN, DATA_TYPE_BIT,  DIR_IN ));
-	symbols->Add(new Signal("be_wr_data1_word_bits7to0",        BEHAVIOR_BUILTIN, DATA_TYPE_BIT,  DIR_IN ));
-	symbols->Add(new Signal("be_wr_data1_tags",                 BEHAVIOR_BUILTIN, DATA_TYPE_BIT,  DIR_IN ));
+	{ "rd_data0_word",                  DATA_TYPE_WORD, DIR_OUT },
+	{ "rd_data0_tag0",                  DATA_TYPE_BIT,  DIR_OUT },
+	{ "rd_data0_tag1",                  DATA_TYPE_BIT,  DIR_OUT },
+	{ "rd_data0_tag2",                  DATA_TYPE_BIT,  DIR_OUT },
+	{ "rd_data0_tag3",                  DATA_TYPE_BIT,  DIR_OUT },
 
+	{ "rd_data1_word",                  DATA_TYPE_WORD, DIR_OUT },
+	{ "rd_data1_tag0",                  DATA_TYPE_BIT,  DIR_OUT },
+	{ "rd_data1_tag1",                  DATA_TYPE_BIT,  DIR_OUT },
+	{ "rd_data1_tag2",                  DATA_TYPE_BIT,  DIR_OUT },
+	{ "rd_data1_tag3",                  DATA_TYPE_BIT,  DIR_OUT },
 
-	symbols->Add(new Signal("rd",								BEHAVIOR_BUILTIN, DATA_TYPE_BIT,  DIR_IN ));
-	symbols->Add(new Signal("rd_addr",							BEHAVIOR_BUILTIN, DATA_TYPE_WORD, DIR_IN ));
 
-	symbols->Add(new Signal("rd_data0_word",					BEHAVIOR_BUILTIN, DATA_TYPE_WORD, DIR_OUT ));
-	symbols->Add(new Signal("rd_data0_tag0",					BEHAVIOR_BUILTIN, DATA_TYPE_BIT,  DIR_OUT ));
-	symbols->Add(new Signal("rd_data0_tag1",					BEHAVIOR_BUILTIN, DATA_TYPE_BIT,  DIR_OUT ));
-	symbols->Add(new Signal("rd_data0_tag2",					BEHAVIOR_BUILTIN, DATA_TYPE_BIT,  DIR_OUT ));
-	symbols->Add(new Signal("rd_data0_tag3",				    BEHAVIOR_BUILTIN, DATA_TYPE_BIT,  DIR_OUT ));
+	{ "flush",                          DATA_TYPE_BIT,  DIR_IN },
+	{ "warm_reset",                     DATA_TYPE_BIT,  DIR_IN },
+};
 
-	symbols->Add(new Signal("rd_data1_word",					BEHAVIOR_BUILTIN, DATA_TYPE_WORD, DIR_OUT ));
-	symbols->Add(new Signal("rd_data1_tag0",				    BEHAVIOR_BUILTIN, DATA_TYPE_BIT,  DIR_OUT ));
-	symbols->Add(new Signal("rd_data1_tag1",				    BEHAVIOR_BUILTIN, DATA_TYPE_BIT,  DIR_OUT ));
-	symbols->Add(new Signal("rd_data1_tag2",				    BEHAVIOR_BUILTIN, DATA_TYPE_BIT,  DIR_OUT ));
-	symbols->Add(new Signal("rd_data1_tag3",				    BEHAVIOR_BUILTIN, DATA_TYPE_BIT,  DIR_OUT ));
+// RF_RAM Parameters
+static const char *const rfRamHighLow[] =           {"active_high", "active_low"};
+static const char *const rfRamAlwaysNeverHigh[] =   {"active_always", "active_never", "active_high"};
 
+static const ParameterTableEntry rfRamParameters[] =
+{
+	TABLE_PARAM_INT(    "wr_width",     1, 2, 1),
+	TABLE_PARAM_ENUM(   "wr_mode",      rfRamHighLow, "active_high"),
+	TABLE_PARAM_INT(    "rd_width",     1, 2, 1),
+	TABLE_PARAM_ENUM(   "rd_mode",      rfRamHighLow, "active_high"),
+
+	TABLE_PARAM_ENUM(   "be_wr_data0_word_bits15to8_mode",  rfRamAlwaysNeverHigh, "active_always"),
+	TABLE_PARAM_ENUM(   "be_wr_data0_word_bits7to0_mode",   rfRamAlwaysNeverHigh, "active_always"),
+	TABLE_PARAM_ENUM(   "be_wr_data0_tags_mode",            rfRamAlwaysNeverHigh, "active_always"),
+	TABLE_PARAM_ENUM(   "be_wr_data1_word_bits15to8_mode",  rfRamAlwaysNeverHigh, "active_always"),
+	TABLE_PARAM_ENUM(   "be_wr_data1_word_bits7to0_mode",   rfRamAlwaysNeverHigh, "active_always"),
+	TABLE_PARAM_ENUM(   "be_wr_data1_tags_mode",            rfRamAlwaysNeverHigh, "active_always"),
 
-	symbols->Add(new Signal("flush",							BEHAVIOR_BUILTIN, DATA_TYPE_BIT,  DIR_IN ));
-	symbols->Add(new Signal("warm_reset",						BEHAVIOR_BUILTIN, DATA_TYPE_BIT,  DIR_IN ));
-
-
-	// RF_RAM_Parameters
-	const char *high_low[] =            {"active_high", "active_low"};
-	const char *always_never_high[] =   {"active_always", "active_never", "active_high"};
-
-	symbols->Add(new ParameterDefinition("wr_width",    1, 2, 1));
-	symbols->Add(new ParameterDefinition("wr_mode",     high_low, countof(high_low), "active_high"));
-	symbols->Add(new ParameterDefinition("rd_width",    1, 2, 1));
-	symbols->Add(new ParameterDefinition("rd_mode",     high_low, countof(high_low), "active_high"));
+	// array of 0-64 20-bit values
+	TABLE_PARAM_ARRAY_INT("init_data",  -(1<<(20-1)), (1<<20)-1,  0, 64,  0xFFFFF),
+};
 
-	symbols->Add(new ParameterDefinition("be_wr_data0_word_bits15to8_mode",     always_never_high, countof(always_never_high), "active_always"));
-	symbols->Add(new ParameterDefinition("be_wr_data0_word_bits7to0_mode",      always_never_high, countof(always_never_high), "active_always"));
-	symbols->Add(new ParameterDefinition("be_wr_data0_tags_mode",               always_never_high, countof(always_never_high), "active_always"));
-	symbols->Add(new ParameterDefinition("be_wr_data1_word_bits15to8_mode",     always_never_high, countof(always_never_high), "active_always"));
-	symbols->Add(new ParameterDefinition("be_wr_data1_word_bits7to0_mode",      always_never_high, countof(always_never_high), "active_always"));
-	symbols->Add(new ParameterDefinition("be_wr_data1_tags_mode",               always_never_high, countof(always_never_high), "active_always"));
+const BuiltinObjectTable RF_RAM::Table = { "RF_RAM", rfRamPorts, countof(rfRamPorts), rfRamParameters, countof(rfRamParameters) };
 
-	// array of 0-64 20-bit values
-	symbols->Add(new ParameterDefinition("init_data",   -(1<<(20-1)), (1<<20)-1,  0, 64,  0xFFFFF));
 
+const SiliconObjectDefinition *RF_RAM::BuiltinDefinition()
+{
+	// Return singleton instance if already created
+	if (definition)
+		return definition;
 
-	// Create a new singleton definition
-	definition = new SiliconObjectDefinition("RF_RAM", symbols, RF_RAM_Factory);
+	// Create a new singleton definition from the static table
+	definition = new SiliconObjectDefinition(Table, RF_RAM_Factory);
 
 	return definition;
 }
@@ -13,6 +13,7 @@ public:
 	// Provide definition on instances as well as via a static method
 	virtual const SiliconObjectDefinition *Definition() const;
 	static  const SiliconObjectDefinition *BuiltinDefinition();
+	static  const BuiltinObjectTable Table;
 
 	// Uses GenerateVerilog from SiliconObject
 
@@ -4,7 +4,7 @@
 #include "Common.h"
 
 Signal::Signal(const char *name, SignalBehavior behavior, SignalDataType dataType, SignalDirection direction, int initialValue, bool anonymous, bool automatic)
-	: Symbol(name), Behavior(behavior), DataType(dataType), Direction(direction), InitialValue(initialValue), RegisterNumber(-1), UsesWarmReset(0), Anonymous(anonymous), Automatic(automatic), BitSliceIndex(-1), DelayCount(0), BaseSignal(NULL), module(NULL)
+	: Symbol(name), Behavior(behavior), DataType(dataType), Direction(direction), InitialValue(initialValue), RegisterNumber(-1), UsesWarmReset(0), Anonymous(anonymous), Automatic(automatic), BitSliceIndex(-1), DelayCount(0), BaseSignal(NULL), DelaySource(NULL), module(NULL)
 {
 }
 
@@ -92,9 +92,10 @@ void Signal::Print(FILE *f) const
 // Return a signal delayed by the given number of clocks
 Signal *Signal::Delay(int delay) const
 {
-	if (delay < 1 || delay > MAX_SIGNAL_DELAY)
+	// Delays beyond MAX_SIGNAL_DELAY are allowed here, and are split into stages by Module::BuildDelayChains
+	if (delay < 1)
 	{
-		yyerrorf("Delay must be a value from 1 to %d", MAX_SIGNAL_DELAY);
+		yyerrorf("Delay must be a value of 1 or more");
 		return NULL;
 	}
 
@@ -124,23 +125,26 @@ Signal *Signal::Delay(int delay) const
 	}
 
 	// Synthesize a name for the delayed signal as in:  original$2
-	char *tmpName = (char *) malloc(strlen(Name()) + 32);
-	sprintf(tmpName, "%s$%d", Name(), delay);
-
-	// Check if the delayed signal already exists in the same module as the original signal
-	Signal *exists = module->GetSignal(tmpName);
+	strings->StartString();
+	strings->AppendString(Name());
+	strings->AppendChar('$');
+	strings->AppendInt(delay);
+
+	// Check if the delayed signal already exists in the same module as the original signal.
+	// The name is only kept when a new signal is created.
+	Signal *exists = module->GetSignal(strings->CurrentString());
 	if (exists)
 	{
-		free((void *) tmpName);
+		strings->DiscardString();
 		return exists;
 	}
+	const char *newName = strings->FinishString();
 
 	// Create a new signal with the same DataType and no Direction, which points to this signal with the specified delay
-	const char *newName = strings->AddString(tmpName);
-	free((void *) tmpName);
 
 	Signal *result = new Signal(newName, BEHAVIOR_DELAY, DataType, DIR_NONE);
 	result->BaseSignal = (Signal *) this;
+	result->DelaySource = (Signal *) this;
 	result->DelayCount = delay;
 	result->Automatic = true;
 	result->Location = CurrentLocation();
@@ -158,6 +162,22 @@ Signal *Signal::Delay(int delay) const
 	return result;
 }
 
+// Returns the existing bit-slice of this signal with the name as in:  original[3]
+// If there is none, its name is left in progress in the global string buffer, for the caller to finish.
+Signal *Signal::FindBitSlice(int index) const
+{
+	strings->StartString();
+	strings->AppendString(Name());
+	strings->AppendChar('[');
+	strings->AppendInt(index);
+	strings->AppendChar(']');
+
+	Signal *exists = module->GetSignal(strings->CurrentString());
+	if (exists)
+		strings->DiscardString();
+	return exists;
+}
+
 // Return a bit-sliced signal that refers to the v-bit of a base word
 Signal *Signal::VBit() const
 {
@@ -181,20 +201,13 @@ Signal *Signal::VBit() const
 	}
 
 	// Synthesize an anonymous name for the bit-sliced signal as in:  .original[16]
-	char *tmpName = (char *) malloc(strlen(Name()) + 32);
-	sprintf(tmpName, "%s[%d]", Name(), V_BIT_SLICE_INDEX);
-
 	// Check if the bit-sliced signal already exists in the same module as the original signal
-	Signal *exists = module->GetSignal(tmpName);
+	Signal *exists = FindBitSlice(V_BIT_SLICE_INDEX);
 	if (exists)
-	{
-		free((void *) tmpName);
 		return exists;
-	}
+	const char *newName = strings->FinishString();
 
 	// Create a new anonymous bit signal with no Direction, which points to this signal and refers to the v-bit slice index
-	const char *newName = strings->AddString(tmpName);
-	free((void *) tmpName);
 
 	Signal *result = new Signal(newName, BEHAVIOR_BIT_SLICE, DATA_TYPE_BIT, DIR_NONE);
 	result->BaseSignal = (Signal *) this;
@@ -228,20 +241,13 @@ Signal *Signal::BitSlice(int index) const
 	}
 
 	// Synthesize an anonymous name for the bit-sliced signal as in:  .original[3]
-	char *tmpName = (char *) malloc(strlen(Name()) + 32);
-	sprintf(tmpName, "%s[%d]", Name(), index);
-
 	// Check if the bit-sliced signal already exists in the same module as the original signal
-	Signal *exists = module->GetSignal(tmpName);
+	Signal *exists = FindBitSlice(index);
 	if (exists)
-	{
-		free((void *) tmpName);
 		return exists;
-	}
+	const char *newName = strings->FinishString();
 
 	// Create a new anonymous bit signal with no Direction, which points to this signal and refers to the v-bit slice index
-	const char *newName = strings->AddString(tmpName);
-	free((void *) tmpName);
 
 	Signal *result = new Signal(newName, BEHAVIOR_BIT_SLICE, DATA_TYPE_BIT, DIR_NONE);
 	result->BaseSignal = (Signal *) this;
@@ -7,8 +7,10 @@
 #include "Identifier.h"
 #include "Instance.h"
 #include "Common.h"
+#include "AllocTracked.h"
 
-// COAST has a built-in limit for the delay on a party-line
+// COAST has a built-in limit for the delay on a party-line.
+// Longer delays are split into a chain of stages, each within the limit.
 #define MAX_SIGNAL_DELAY		(30)
 
 // Bit 16 of a word is always the v-bit
@@ -48,7 +50,7 @@ enum SignalDirection
 	DIR_OUT,
 };
 
-class Signal : public Symbol
+class Signal : public Symbol, public AllocTracked<ALLOC_SIGNAL>
 {
 public:
 	Signal(const char *name, SignalBehavior behavior = BEHAVIOR_WIRE, SignalDataType dataType = DATA_TYPE_WORD, SignalDirection direction = DIR_NONE, int initialValue = -1, bool anonymous = false, bool generated = false);
@@ -80,11 +82,15 @@ public:
 	int BitSliceIndex;                  // -1 if no bit-slicing.  BitSliceIndex of 16 indicates use of the v-bit
 	int DelayCount;                     // When BEHAVIOR_DELAY, this delay indicates the number of clock delays.  Otherwise it is 0.
 	Signal *BaseSignal;                 // Bit-sliced and delayed signals reference another signal as their source
+	Signal *DelaySource;                // When BEHAVIOR_DELAY, the previous tap in the delay chain of BaseSignal, or BaseSignal itself
 
 	SourceCodeLocation Location;
 
 	// Points to the containing module
 	Module *module;
+
+private:
+	Signal *FindBitSlice(int index) const;
 };
 
 
@@ -54,6 +54,21 @@ SiliconObjectDefinition::SiliconObjectDefinition(const char *name, SymbolTable *
 {
 }
 
+SiliconObjectDefinition::SiliconObjectDefinition(const BuiltinObjectTable &table, SiliconObjectFactory factory)
+	: Symbol(table.Name), symbols(new SymbolTable(true)), factory(factory)
+{
+	for (int i=0; i < table.NumPorts; i++)
+	{
+		const PortTableEntry &port = table.Ports[i];
+		symbols->Add(new Signal(port.Name, BEHAVIOR_BUILTIN, port.DataType, port.Direction));
+	}
+
+	for (int i=0; i < table.NumParameters; i++)
+	{
+		symbols->Add(new ParameterDefinition(table.Parameters[i]));
+	}
+}
+
 SiliconObjectDefinition::~SiliconObjectDefinition()
 {
 	// Delete built-in symbol table when definition is destroyed
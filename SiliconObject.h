@@ -4,12 +4,33 @@
 
 #include "Module.h"
 #include "SymbolTable.h"
+#include "Parameter.h"
 
 class SiliconObject;
 class SimpleSiliconObject;
 class SiliconObjectDefinition;
 
 
+// Static tables describing the ports and parameters of built-in silicon objects.
+// They are plain aggregates, initialized at compile time and never modified, so they are shared freely.
+// Parameter rows are ParameterTableEntry, in Parameter.h.
+struct PortTableEntry
+{
+	const char *Name;
+	SignalDataType DataType;
+	SignalDirection Direction;
+};
+
+struct BuiltinObjectTable
+{
+	const char *Name;
+	const PortTableEntry *Ports;
+	int NumPorts;
+	const ParameterTableEntry *Parameters;
+	int NumParameters;
+};
+
+
 // Factory method prototype to create silicon objects
 typedef SiliconObject *(*SiliconObjectFactory)   (const SiliconObjectDefinition *definition, const char *name, Module *parent);
 
@@ -38,7 +59,7 @@ public:
 	virtual const SiliconObjectDefinition *Definition() const = 0;
 
 	// Defined in SiliconObject_GenerateVerilog
-	virtual void GenerateVerilog(FILE *f) const;
+	virtual void GenerateVerilog(FILE *f, bool neutralName = false) const;
 };
 
 
@@ -66,6 +87,10 @@ class SiliconObjectDefinition : public Symbol
 {
 public:
 	SiliconObjectDefinition(const char *name, SymbolTable *symbols, SiliconObjectFactory factory = NULL);
+
+	// Built-in definition, with a symbol table created from the static table of ports and parameters
+	SiliconObjectDefinition(const BuiltinObjectTable &table, SiliconObjectFactory factory);
+
 	virtual ~SiliconObjectDefinition();
 
 	// Returns a built-in symbol table containing port and parameter definitions
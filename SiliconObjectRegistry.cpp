@@ -1,4 +1,5 @@
 
+
 #include "SiliconObjectRegistry.h"
 #include "SymbolTable.h"
 #include "Parameter.h"
@@ -11,20 +12,72 @@
 #include "TF.h"
 #include "RF.h"
 
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <vector>
+
 
 /*
  *  Silicon object registry
  */
 
+typedef const SiliconObjectDefinition *(*BuiltinDefinitionFunction)();
+
+// Device description file, mapped for as long as the registry exists
+struct DeviceFile
+{
+	const char *Filename;
+	const char *Data;
+	size_t Size;
+};
+
+// Registered silicon object type, whose definition is created on first lookup
+struct ObjectEntry
+{
+	const char *Name;
+	SiliconObjectDefinition *Definition;
+	bool Failed;                            // Set when the definition could not be created, so it is reported once
+
+	BuiltinDefinitionFunction Builtin;      // Objects defined in C++, described by a static table
+	const BuiltinObjectTable *Table;
+	const DeviceFile *File;                 // Objects from a device description, starting after the object line
+	const char *Text;
+	int Line;
+};
+
 
-// Global registry of silicon objects
+// Global registry of silicon objects, by name and in order of registration
 StringMap *siliconObjects;
+static vector<ObjectEntry*> objectEntries;
+static vector<DeviceFile*> deviceFiles;
 
 
-// Lookup in silicon object registry
-SiliconObjectDefinition *LookupObjectDefinition(const char *object)
+static ObjectEntry *NewObjectEntry(const char *name)
 {
-	return (SiliconObjectDefinition *) siliconObjects->Get(object);
+	ObjectEntry *entry = new ObjectEntry();
+	entry->Name = name;
+	entry->Definition = NULL;
+	entry->Failed = false;
+	entry->Builtin = NULL;
+	entry->Table = NULL;
+	entry->File = NULL;
+	entry->Text = NULL;
+	entry->Line = 0;
+
+	siliconObjects->Add(name, entry);
+	objectEntries.push_back(entry);
+	return entry;
+}
+
+static void RegisterBuiltinObject(const char *name, BuiltinDefinitionFunction builtin, const BuiltinObjectTable *table = NULL)
+{
+	ObjectEntry *entry = NewObjectEntry(name);
+	entry->Builtin = builtin;
+	entry->Table = table;
 }
 
 
@@ -48,8 +101,10 @@ static void AddEnumValuesForObject(const SiliconObjectDefinition *definition)
 			{
 				for (int j=0; j < param->NumEnumValues; j++)
 				{
-					const char *enumValue = param->EnumValues[j];
-					globalSymbols->Add(new EnumValue(enumValue));
+					// Values shared by several parameters are added once
+					EnumValue *enumValue = new EnumValue(param->EnumValues[j]);
+					if (!globalSymbols->Add(enumValue))
+						delete enumValue;
 				}
 			}
 		}
@@ -57,15 +112,438 @@ static void AddEnumValuesForObject(const SiliconObjectDefinition *definition)
 }
 
 
-// Initialize enumerations for all silicon object types
-static void InitializeSiliconObjectEnumValues()
+/*
+ * Device description files
+ */
+
+// Finds the next whitespace-separated token of a line in place, and advances p past it.
+// A token in double quotes may contain spaces, and # starts a comment.  Returns false at the end of the line.
+static bool FindToken(const char *&p, const char *lineEnd, const char *&token, size_t &length)
 {
-	int n = siliconObjects->Count();
-	for (int i=0; i < n; i++)
+	while (p < lineEnd && (*p == ' ' || *p == '\t' || *p == '\r'))
+		p++;
+
+	if (p >= lineEnd || *p == '#')
+		return false;
+
+	if (*p == '"')
 	{
-		SiliconObjectDefinition *definition = (SiliconObjectDefinition *) siliconObjects->Get(i);
-		AddEnumValuesForObject(definition);
+		token = ++p;
+		while (p < lineEnd && *p != '"')
+			p++;
+		length = p - token;
+		if (p < lineEnd)
+			p++;
 	}
+	else
+	{
+		token = p;
+		while (p < lineEnd && *p != ' ' && *p != '\t' && *p != '\r' && *p != '#')
+			p++;
+		length = p - token;
+	}
+	return true;
+}
+
+static bool TokenIs(const char *token, size_t length, const char *s)
+{
+	return strlen(s) == length && strncmp(token, s, length) == 0;
+}
+
+// Reads the next token of a line, copied to the string buffer.  Returns NULL at the end of the line.
+static const char *NextToken(const char *&p, const char *lineEnd)
+{
+	const char *token;
+	size_t length;
+	if (!FindToken(p, lineEnd, token, length))
+		return NULL;
+
+	strings->StartString();
+	for (size_t i=0; i < length; i++)
+		strings->AppendChar(token[i]);
+	return strings->FinishString();
+}
+
+// Splits the line at p into tokens, and advances p to the next line
+static void ReadLine(const char *&p, const char *end, vector<const char*> &tokens)
+{
+	const char *lineEnd = (const char *) memchr(p, '\n', end - p);
+	if (!lineEnd)
+		lineEnd = end;
+
+	tokens.clear();
+	const char *token;
+	while ((token = NextToken(p, lineEnd)) != NULL)
+		tokens.push_back(token);
+
+	p = (lineEnd < end) ? lineEnd + 1 : end;
+}
+
+static bool ParseLong(const char *s, long &value)
+{
+	char *rest;
+	value = strtol(s, &rest, 0);
+	return *s && !*rest;
+}
+
+// Adds a port or parameter from one line of an object.  Returns false, after reporting an error, if the line is not valid.
+static bool AddDeviceSymbol(SymbolTable *table, const vector<const char*> &tokens, SourceCodeLocation loc)
+{
+	Symbol *symbol = NULL;
+	int n = tokens.size();
+
+	if (strcmp(tokens[0], "port") == 0)
+	{
+		if (n != 4)
+		{
+			yyerrorfl(loc, "Expected:  port <name> bit|word in|out");
+			return false;
+		}
+
+		SignalDataType dataType = DATA_TYPE_UNKNOWN;
+		if (strcmp(tokens[2], "bit") == 0)
+			dataType = DATA_TYPE_BIT;
+		else if (strcmp(tokens[2], "word") == 0)
+			dataType = DATA_TYPE_WORD;
+
+		SignalDirection direction = DIR_NONE;
+		if (strcmp(tokens[3], "in") == 0)
+			direction = DIR_IN;
+		else if (strcmp(tokens[3], "out") == 0)
+			direction = DIR_OUT;
+
+		if (dataType == DATA_TYPE_UNKNOWN || direction == DIR_NONE)
+		{
+			yyerrorfl(loc, "Port '%s' must be a bit or word, and in or out", tokens[1]);
+			return false;
+		}
+
+		symbol = new Signal(tokens[1], BEHAVIOR_BUILTIN, dataType, direction);
+	}
+
+	else if (strcmp(tokens[0], "param") == 0)
+	{
+		// Values of the type run up to the '=' before the default
+		int equals = 3;
+		while (equals < n && strcmp(tokens[equals], "=") != 0)
+			equals++;
+
+		if (n < 3 || equals != n - 2)
+		{
+			yyerrorfl(loc, "Expected:  param <name> <type> [values] = <default>");
+			return false;
+		}
+
+		const char *name = tokens[1];
+		const char *type = tokens[2];
+		const char *defaultValue = tokens[n-1];
+		int nvalues = equals - 3;
+
+		if (strcmp(type, "int") == 0)
+		{
+			long minValue, maxValue, defaultInt;
+			if (nvalues != 2 || !ParseLong(tokens[3], minValue) || !ParseLong(tokens[4], maxValue) || !ParseLong(defaultValue, defaultInt))
+			{
+				yyerrorfl(loc, "Int parameter '%s' needs a minimum, a maximum and a default integer", name);
+				return false;
+			}
+			symbol = new ParameterDefinition(name, minValue, maxValue, defaultInt);
+		}
+		else if (strcmp(type, "enum") == 0)
+		{
+			bool found = false;
+			for (int i=0; i < nvalues && !found; i++)
+				found = (strcmp(tokens[3+i], defaultValue) == 0);
+
+			if (!found)
+			{
+				yyerrorfl(loc, "Default of enum parameter '%s' must be one of its values", name);
+				return false;
+			}
+			symbol = new ParameterDefinition(name, (const char **) &tokens[3], nvalues, defaultValue);
+		}
+		else if (strcmp(type, "string") == 0 && nvalues == 0)
+		{
+			symbol = new ParameterDefinition(name, defaultValue);
+		}
+		else
+		{
+			yyerrorfl(loc, "Parameter '%s' must be of type int, enum or string", name);
+			return false;
+		}
+	}
+
+	else
+	{
+		yyerrorfl(loc, "Expected port, param or end, instead of '%s'", tokens[0]);
+		return false;
+	}
+
+	if (!table->Add(symbol))
+	{
+		yyerrorfl(loc, "'%s' is already defined", symbol->Name());
+		delete symbol;
+		return false;
+	}
+	return true;
+}
+
+// Creates the definition of an object from a device description, from the lines following its object line
+static SiliconObjectDefinition *ParseDeviceObject(const ObjectEntry *entry)
+{
+	const DeviceFile *file = entry->File;
+	const char *p = entry->Text;
+	const char *end = file->Data + file->Size;
+
+	SymbolTable *table = new SymbolTable(true);
+	SourceCodeLocation loc;
+	loc.Filename = file->Filename;
+	loc.Line = entry->Line;
+
+	bool ok = true;
+	bool ended = false;
+	vector<const char*> tokens;
+	while (p < end && !ended)
+	{
+		loc.Line++;
+		ReadLine(p, end, tokens);
+
+		if (tokens.empty())
+			continue;
+		else if (strcmp(tokens[0], "end") == 0)
+			ended = true;
+		else if (!AddDeviceSymbol(table, tokens, loc))
+			ok = false;
+	}
+
+	if (!ended)
+	{
+		loc.Line = entry->Line;
+		yyerrorfl(loc, "Object '%s' has no end", entry->Name);
+		ok = false;
+	}
+
+	if (!ok)
+	{
+		delete table;
+		return NULL;
+	}
+
+	return new SiliconObjectDefinition(entry->Name, table);
+}
+
+
+bool LoadDeviceDescription(const char *filename)
+{
+	int fd = open(filename, O_RDONLY);
+	struct stat st;
+	if (fd < 0 || fstat(fd, &st) != 0)
+	{
+		if (fd >= 0)
+			close(fd);
+		yyerrorfl(FileLocation(filename), "Cannot read device description file");
+		return false;
+	}
+
+	DeviceFile *file = new DeviceFile();
+	file->Filename = strings->AddString(filename);
+	file->Data = NULL;
+	file->Size = st.st_size;
+
+	if (file->Size > 0)
+	{
+		void *data = mmap(NULL, file->Size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data == MAP_FAILED)
+		{
+			close(fd);
+			delete file;
+			yyerrorfl(FileLocation(filename), "Cannot read device description file");
+			return false;
+		}
+		file->Data = (const char *) data;
+	}
+	close(fd);
+	deviceFiles.push_back(file);
+
+	// Objects of the design may come from this file, so it is a prerequisite in dependency output
+	parsedFilenames.push_back(file->Filename);
+
+	// Index the object lines only.  Their contents are parsed on first lookup.
+	bool ok = true;
+	const char *p = file->Data;
+	const char *end = file->Data + file->Size;
+	for (int line=1; p < end; line++)
+	{
+		const char *lineEnd = (const char *) memchr(p, '\n', end - p);
+		if (!lineEnd)
+			lineEnd = end;
+
+		const char *q = p;
+		while (q < lineEnd && (*q == ' ' || *q == '\t'))
+			q++;
+
+		p = (lineEnd < end) ? lineEnd + 1 : end;
+
+		if (lineEnd - q > 7 && strncmp(q, "object", 6) == 0 && (q[6] == ' ' || q[6] == '\t'))
+		{
+			q += 6;
+			const char *name = NextToken(q, lineEnd);
+
+			SourceCodeLocation loc;
+			loc.Filename = file->Filename;
+			loc.Line = line;
+
+			ObjectEntry *existing = name ? (ObjectEntry *) siliconObjects->Get(name) : NULL;
+			if (!name)
+			{
+				yyerrorfl(loc, "Expected an object name");
+				ok = false;
+			}
+			else if (existing)
+			{
+				if (existing->File)
+					yyerrorfl(loc, "Object '%s' already described in %s on line %d", name, existing->File->Filename, existing->Line);
+				else
+					yyerrorfl(loc, "Object '%s' is a built-in silicon object", name);
+				ok = false;
+			}
+			else
+			{
+				ObjectEntry *entry = NewObjectEntry(name);
+				entry->File = file;
+				entry->Text = p;
+				entry->Line = line;
+			}
+		}
+	}
+
+	return ok;
+}
+
+
+// Creates the definition of an object on first use, and adds the enumerated values of its parameters
+static SiliconObjectDefinition *MaterializeObject(ObjectEntry *entry)
+{
+	if (!entry->Definition && !entry->Failed)
+	{
+		if (entry->Builtin)
+			entry->Definition = (SiliconObjectDefinition *) entry->Builtin();
+		else
+			entry->Definition = ParseDeviceObject(entry);
+
+		if (entry->Definition)
+			AddEnumValuesForObject(entry->Definition);
+		else
+			entry->Failed = true;
+	}
+
+	return entry->Definition;
+}
+
+
+// Lookup in silicon object registry
+SiliconObjectDefinition *LookupObjectDefinition(const char *object)
+{
+	ObjectEntry *entry = (ObjectEntry *) siliconObjects->Get(object);
+	if (!entry)
+		return NULL;
+
+	return MaterializeObject(entry);
+}
+
+
+// Create every registered definition, returning false if any cannot be created
+bool CreateAllObjectDefinitions()
+{
+	bool ok = true;
+	for (int i=0; i < (int) objectEntries.size(); i++)
+	{
+		if (!MaterializeObject(objectEntries[i]))
+			ok = false;
+	}
+	return ok;
+}
+
+
+// Returns true if an enumerated parameter of an object from a device description accepts the value.
+// The param lines are scanned without parsing the object, so that looking up a name does not report errors
+// in objects which do not declare it.
+static bool DeviceObjectAcceptsEnumValue(const ObjectEntry *entry, const char *name)
+{
+	const char *p = entry->Text;
+	const char *end = entry->File->Data + entry->File->Size;
+
+	while (p < end)
+	{
+		const char *lineEnd = (const char *) memchr(p, '\n', end - p);
+		if (!lineEnd)
+			lineEnd = end;
+
+		// Values of an enum param are the tokens between its type and the '='
+		const char *token;
+		size_t length;
+		for (int i=0; FindToken(p, lineEnd, token, length); i++)
+		{
+			if (i == 0 && TokenIs(token, length, "end"))
+				return false;
+			if ((i == 0 && !TokenIs(token, length, "param")) || (i == 2 && !TokenIs(token, length, "enum")) || TokenIs(token, length, "="))
+				break;
+			if (i >= 3 && TokenIs(token, length, name))
+				return true;
+		}
+
+		p = (lineEnd < end) ? lineEnd + 1 : end;
+	}
+
+	return false;
+}
+
+// Returns true if an enumerated parameter in the static table of a built-in object accepts the value
+static bool TableAcceptsEnumValue(const BuiltinObjectTable *table, const char *name)
+{
+	for (int i=0; i < table->NumParameters; i++)
+	{
+		const ParameterTableEntry &param = table->Parameters[i];
+		if (param.DataType != PARAM_ENUM && param.DataType != PARAM_ENUM_OR_INT)
+			continue;
+
+		for (int j=0; j < param.NumEnumValues; j++)
+		{
+			if (strcmp(param.EnumValues[j], name) == 0)
+				return true;
+		}
+	}
+
+	return false;
+}
+
+Symbol *LookupEnumValue(const char *name)
+{
+	Symbol *s = globalSymbols->Get(name);
+	if (s)
+		return (s->SymbolType() == SYMBOL_ENUM_VALUE) ? s : NULL;
+
+	for (int i=0; i < (int) objectEntries.size(); i++)
+	{
+		ObjectEntry *entry = objectEntries[i];
+		if (entry->Definition || entry->Failed)
+			continue;
+
+		// Objects are searched in their static tables or device description text, so only the one accepting
+		// the value is created
+		if (entry->Builtin && (!entry->Table || !TableAcceptsEnumValue(entry->Table, name)))
+			continue;
+		if (entry->File && !DeviceObjectAcceptsEnumValue(entry, name))
+			continue;
+
+		MaterializeObject(entry);
+
+		Symbol *s = globalSymbols->Get(name);
+		if (s)
+			return (s->SymbolType() == SYMBOL_ENUM_VALUE) ? s : NULL;
+	}
+
+	return NULL;
 }
 
 
@@ -75,13 +553,23 @@ static void InitializeSiliconObjectEnumValues()
  */
 void CleanupSiliconObjects()
 {
-	// Delete SiliconObject definitions
-	int n = siliconObjects->Count();
-	for (int i=0; i < n; i++)
+	// Delete SiliconObject definitions which were created from device descriptions, and the registry entries.
+	// Built-in definitions are singletons made from static tables, and are kept for the life of the process.
+	for (int i=0; i < (int) objectEntries.size(); i++)
 	{
-		SiliconObjectDefinition *definition = (SiliconObjectDefinition *) siliconObjects->Get(i);
-		delete definition;
+		if (!objectEntries[i]->Builtin)
+			delete objectEntries[i]->Definition;
+		delete objectEntries[i];
 	}
+	objectEntries.clear();
+
+	for (int i=0; i < (int) deviceFiles.size(); i++)
+	{
+		if (deviceFiles[i]->Data)
+			munmap((void *) deviceFiles[i]->Data, deviceFiles[i]->Size);
+		delete deviceFiles[i];
+	}
+	deviceFiles.clear();
 
 	// Delete registry
 	delete siliconObjects;
@@ -94,25 +582,20 @@ void CleanupSiliconObjects()
  * Create silicon object registry
  */
 
-// Initialize the silicon object registry, and add all silicon objects
+// Initialize the silicon object registry.  Definitions are created when first looked up.
 void InitializeSiliconObjects()
 {
 	siliconObjects = new StringMap();
 
 	// Objects with special syntax
-	siliconObjects->Add("FPOA",		(void*) FPOA::BuiltinDefinition());
-	siliconObjects->Add("ALU",		(void*) Alu::BuiltinDefinition());
-	siliconObjects->Add("TF",		(void*) FloatingTF::BuiltinDefinition());
+	RegisterBuiltinObject("FPOA",		FPOA::BuiltinDefinition,		&FPOA::Table);
+	RegisterBuiltinObject("ALU",		Alu::BuiltinDefinition,			&Alu::Table);
+	RegisterBuiltinObject("TF",			FloatingTF::BuiltinDefinition);
 
 	// Objects with special factories, but no special syntax
-	siliconObjects->Add("RF_RAM",	(void*) RF_RAM::BuiltinDefinition());
-
-	// Objects with no special support, just definitions
-
+	RegisterBuiltinObject("RF_RAM",		RF_RAM::BuiltinDefinition,		&RF_RAM::Table);
 
-	// Go through each object in the registry, and add each enumerated value
-	// ever accepted by a parameter as an EnumValue in the global symbol table
-	InitializeSiliconObjectEnumValues();
+	// Objects with no special support, just definitions, come from device description files
 }
 
 
@@ -1,16 +1,43 @@
-
 #ifndef SILICON_OBJECT_REGISTRY_H
 #define SILICON_OBJECT_REGISTRY_H
 
+class Symbol;
 class SiliconObjectDefinition;
 
 // Initialize and cleanup registry
 extern void InitializeSiliconObjects();
 extern void CleanupSiliconObjects();
 
-// Lookup silicon object by name
+// Lookup silicon object by name.
+// Definitions are created on their first lookup, and the enumerated values of their parameters
+// are then added to the global symbol table.
 extern SiliconObjectDefinition *LookupObjectDefinition(const char *object);
 
+// Lookup an enumerated value accepted by a parameter of any silicon object, including objects not used yet.
+// Only the definition of an object accepting the value is created.  Returns NULL if none does.
+extern Symbol *LookupEnumValue(const char *name);
+
+// Create the definitions of all registered objects now, rather than on first lookup.
+// Used before strings are released between compilations, since definitions keep strings from the buffer.
+// Returns false, after reporting errors, if any definition cannot be created.
+extern bool CreateAllObjectDefinitions();
 
-#endif
 
+// Adds the simple silicon objects of a device description file to the registry.
+// The file is memory-mapped, and only the object names are read here.  Each definition is parsed on its first lookup.
+// Returns false, after reporting errors, if the file cannot be read or repeats an object name.
+//
+// Each object is a block of lines, with # starting a comment:
+//
+//     object MAC
+//         port  a         word in
+//         port  y         bit  out
+//         param mode      enum add sub = add
+//         param width     int  1 16 = 16
+//         param label     string = "none"
+//     end
+//
+extern bool LoadDeviceDescription(const char *filename);
+
+
+#endif
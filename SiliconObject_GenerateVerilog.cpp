@@ -1,7 +1,7 @@
 
 #include "SiliconObject.h"
 
-void SiliconObject::GenerateVerilog(FILE *f) const
+void SiliconObject::GenerateVerilog(FILE *f, bool neutralName) const
 {
 	// This version of GenerateVerilog is common across all silicon object types.
 	// Many module types will override this, such as the ALU or MAC, because they have
@@ -13,7 +13,7 @@ void SiliconObject::GenerateVerilog(FILE *f) const
 	F0("\n");
 
 	F0("//\n");
-	F2("// ================ %s - %s ================\n", ModuleTypeName(), Name());
+	F2("// ================ %s - %s ================\n", ModuleTypeName(), VerilogLocalName(neutralName));
 	F0("//\n");
 
 	int n = SignalCount();
@@ -24,7 +24,7 @@ void SiliconObject::GenerateVerilog(FILE *f) const
 	//     output [16:0] OutWord3
 	// );
 	F0("module ");
-	GenerateVerilogModuleName(f);
+	GenerateVerilogModuleName(f, neutralName);
 	F0(" (");
 
 	bool first = true;
@@ -79,7 +79,7 @@ void SiliconObject::GenerateVerilog(FILE *f) const
 	
 	// ModuleName
 	// (
-	F1("%s", Name());
+	F1("%s", VerilogLocalName(neutralName));
 
 	// signals
 	first = true;
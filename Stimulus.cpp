@@ -0,0 +1,145 @@
+#include "Stimulus.h"
+#include "Common.h"
+#include "FileIO.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+// Splits a line into words separated by spaces, tabs or commas, dropping any comment
+static void SplitLine(char *line, vector<char *> &words)
+{
+	words.clear();
+
+	char *comment = strchr(line, '#');
+	if (comment)
+		*comment = '\0';
+
+	char *word = strtok(line, " \t\r\n,");
+	while (word)
+	{
+		words.push_back(word);
+		word = strtok(NULL, " \t\r\n,");
+	}
+}
+
+
+bool Stimulus::Read(const char *filename)
+{
+	this->filename = filename;
+	names.clear();
+	values.clear();
+
+	FILE *f = OpenFile(filename, "r");
+	if (!f)
+	{
+		yyerrorfl(FileLocation(filename), "Cannot open stimulus file");
+		return false;
+	}
+
+	bool ok = true;
+	int lineNumber = 0;
+	vector<char *> words;
+	string line;
+	char buf[1024];
+	while (ok && fgets(buf, sizeof(buf), f))
+	{
+		// Collect lines longer than the buffer
+		line += buf;
+		if (line[line.size()-1] != '\n' && !feof(f))
+			continue;
+
+		lineNumber++;
+		vector<char> text(line.begin(), line.end());
+		text.push_back('\0');
+		line.clear();
+
+		SplitLine(&text[0], words);
+		if (words.empty())
+			continue;
+
+		if (names.empty())
+		{
+			for (size_t i=0; i < words.size(); i++)
+				names.push_back(words[i]);
+			continue;
+		}
+
+		SourceCodeLocation loc;
+		loc.Filename = filename;
+		loc.Line = lineNumber;
+
+		if (words.size() != names.size())
+		{
+			yyerrorfl(loc, "Expected %d values, found %d", (int) names.size(), (int) words.size());
+			ok = false;
+			break;
+		}
+
+		for (size_t i=0; i < words.size(); i++)
+		{
+			char *end;
+			long value = strtol(words[i], &end, 0);
+			if (*end != '\0')
+			{
+				yyerrorfl(loc, "Invalid value '%s'", words[i]);
+				ok = false;
+				break;
+			}
+			values.push_back((int) value);
+		}
+	}
+
+	if (!CloseFile(f) && ok)
+	{
+		yyerrorfl(FileLocation(filename), "Cannot read stimulus file");
+		ok = false;
+	}
+
+	return ok;
+}
+
+
+int Stimulus::Columns() const
+{
+	return names.size();
+}
+
+const char *Stimulus::Filename() const
+{
+	return filename.c_str();
+}
+
+const char *Stimulus::ColumnName(int col) const
+{
+	return names[col].c_str();
+}
+
+int Stimulus::FindColumn(const char *name) const
+{
+	for (size_t i=0; i < names.size(); i++)
+	{
+		if (names[i] == name)
+			return i;
+	}
+	return -1;
+}
+
+
+int Stimulus::Rows() const
+{
+	return names.empty() ? 0 : values.size() / names.size();
+}
+
+int Stimulus::Value(int row, int col) const
+{
+	int rows = Rows();
+	if (rows == 0)
+		return 0;
+
+	// Hold the last values after the end
+	if (row >= rows)
+		row = rows - 1;
+
+	return values[row * names.size() + col];
+}
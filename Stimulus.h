@@ -0,0 +1,36 @@
+#ifndef STIMULUS_H
+#define STIMULUS_H
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+using namespace std;
+
+
+// Input values for simulation, read from a text file with one column per input and one row per cycle.
+//
+// The first line names the columns, and each following line gives the value of every column for one cycle.
+// Values are decimal, or hexadecimal with a 0x prefix, and may be negative.
+// Blank lines and text after # are ignored.  After the last row, the last values are held.
+class Stimulus
+{
+public:
+	// Reads a stimulus file, which may be compressed.  Returns false, after reporting errors, if it cannot be read.
+	bool Read(const char *filename);
+	const char *Filename() const;
+
+	int Columns() const;
+	const char *ColumnName(int col) const;
+	int FindColumn(const char *name) const;   // Returns -1 if not found
+
+	int Rows() const;
+	int Value(int row, int col) const;
+
+private:
+	string filename;
+	vector<string> names;
+	vector<int> values;     // Rows stored one after the other
+};
+
+
+#endif
@@ -1,68 +1,180 @@
-
 #include "StringBuffer.h"
+#include "AllocTracked.h"
+#include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <stddef.h>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
 
-StringBuffer::StringBuffer(int initial_size)
+StringBuffer::StringBuffer(int chunk_size)
+	: first(NULL), current(NULL), chunk_size(chunk_size), large_pages(false),
+	  num_strings(0), num_chunks(0), bytes_used(0), bytes_allocated(0)
 {
-	buffer_size = initial_size;
-	buffers[0] = (char *) malloc(buffer_size);
+	first = current = NewChunk(chunk_size);
 
-	buffer = 0;
-	buffers[0][0] = 0;
-	num_strings = 0;
-	next = buffers[0];
-	start = buffers[0];
+	next = start = first->data;
+	end = first->data + first->size;
+	*next = 0;
 }
 
 StringBuffer::~StringBuffer()
 {
-	for (int i=0; i <= buffer; i++)
-		free(buffers[i]);
+	Chunk *chunk = first;
+	while (chunk)
+	{
+		Chunk *following = chunk->next;
+		FreeChunk(chunk);
+		chunk = following;
+	}
 }
 
 void StringBuffer::Reset()
 {
-	if (buffer > 0)
+	Chunk *chunk = first->next;
+	while (chunk)
 	{
-		for (int i=0; i <= buffer; i++)
-			free(buffers[i]);
-
-		buffers[0] = (char *) malloc(buffer_size);
+		Chunk *following = chunk->next;
+		FreeChunk(chunk);
+		chunk = following;
 	}
 
-	buffer = 0;
-	buffers[0][0] = 0;
+	first->next = NULL;
+	current = first;
 	num_strings = 0;
-	next = buffers[0];
-	start = buffers[0];
+	num_chunks = 1;
+	bytes_used = 0;
+	bytes_allocated = first->size;
+
+	next = start = first->data;
+	end = first->data + first->size;
+	*next = 0;
+
+	SetMark();
+}
+
+void StringBuffer::SetMark()
+{
+	mark_chunk = current;
+	mark_next = next;
+	mark_strings = num_strings;
+	mark_bytes_used = bytes_used;
+}
+
+void StringBuffer::ReleaseToMark()
+{
+	Chunk *chunk = mark_chunk->next;
+	while (chunk)
+	{
+		Chunk *following = chunk->next;
+		num_chunks--;
+		bytes_allocated -= chunk->size;
+		FreeChunk(chunk);
+		chunk = following;
+	}
+
+	mark_chunk->next = NULL;
+	current = mark_chunk;
+	num_strings = mark_strings;
+	bytes_used = mark_bytes_used;
+
+	next = start = mark_next;
+	end = current->data + current->size;
+	*next = 0;
+}
+
+void StringBuffer::UseLargePages(bool enable)
+{
+	large_pages = enable;
+}
+
+
+// Allocates a chunk with room for size characters
+StringBuffer::Chunk *StringBuffer::NewChunk(long size)
+{
+	long total = offsetof(Chunk, data) + size;
+	Chunk *chunk = NULL;
+
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+	if (large_pages)
+	{
+		// Round up to whole large pages, and ask for transparent huge pages
+		total = (total + LARGE_PAGE_SIZE - 1) / LARGE_PAGE_SIZE * LARGE_PAGE_SIZE;
+		void *memory = NULL;
+		if (posix_memalign(&memory, LARGE_PAGE_SIZE, total) == 0)
+		{
+			madvise(memory, total, MADV_HUGEPAGE);
+			chunk = (Chunk *) memory;
+		}
+	}
+#endif
+
+	if (!chunk)
+	{
+		chunk = (Chunk *) malloc(total);
+		if (!chunk)
+		{
+			fprintf(stderr, "FATAL - Out of memory for strings\n");
+			exit(1);
+		}
+	}
+
+	chunk->next = NULL;
+	chunk->size = total - offsetof(Chunk, data);
+
+	num_chunks++;
+	bytes_allocated += chunk->size;
+	AllocTrackNew(ALLOC_STRING_CHUNK, total);
+	return chunk;
+}
+
+void StringBuffer::FreeChunk(Chunk *chunk)
+{
+	AllocTrackDelete(ALLOC_STRING_CHUNK, offsetof(Chunk, data) + chunk->size);
+	free(chunk);
 }
 
+
 int StringBuffer::NumStrings() const
 {
 	return num_strings;
 }
 
-char *StringBuffer::AddString(const char *s)
+int StringBuffer::NumChunks() const
 {
-	int len = strlen(s);
-	EnsureBuffer(len + 1);
+	return num_chunks;
+}
 
-	strcpy(next, s);
-	next += (len + 1);
+long StringBuffer::BytesUsed() const
+{
+	return bytes_used;
+}
 
-	char *result = start;
-	start = next;
+long StringBuffer::BytesAllocated() const
+{
+	return bytes_allocated;
+}
 
-	num_strings++;
+void StringBuffer::PrintStatistics(FILE *f) const
+{
+	fprintf(f, "Strings: %d strings, %ld bytes used, %ld bytes allocated in %d chunk(s)%s\n",
+		num_strings, bytes_used, bytes_allocated, num_chunks, large_pages ? " (large pages)" : "");
+}
 
-	return result;
+
+char *StringBuffer::AddString(const char *s)
+{
+	StartString();
+	AppendString(s);
+	return FinishString();
 }
 
 void StringBuffer::StartString()
 {
-	*next = 0;
 	start = next;
+	*next = 0;
 }
 
 void StringBuffer::AppendString(const char *s)
@@ -70,8 +182,7 @@ void StringBuffer::AppendString(const char *s)
 	int len = strlen(s);
 	EnsureBuffer(len + 1);
 
-	char *dest = next;
-	strcpy(dest, s);
+	memcpy(next, s, len + 1);
 	next += len;
 }
 
@@ -83,48 +194,61 @@ void StringBuffer::AppendChar(char c)
 	next++;
 }
 
+void StringBuffer::AppendInt(int i)
+{
+	char digits[16];
+	sprintf(digits, "%d", i);
+	AppendString(digits);
+}
+
 char *StringBuffer::FinishString()
 {
+	EnsureBuffer(1);
 	*next = 0;
 	next++;
-	num_strings++;
 
 	char *result = start;
+	bytes_used += next - start;
+	num_strings++;
+
+	// Keep room for the terminator written by StartString.  The finished string is no longer in progress,
+	// so it is not moved when this starts a new chunk.
 	start = next;
+	EnsureBuffer(1);
 
 	return result;
 }
 
-int StringBuffer::EnsureBuffer(int size)
+const char *StringBuffer::CurrentString()
 {
-	if (next + size <= buffers[buffer] + buffer_size)
-		return buffer_size;
-
-	if (buffer >= MAX_STRING_BUFFERS-1)
-		return 0;
-
-	int total_size = size + (next-start);
-	do {
-		buffer_size *= 2;
-	}
-	while (buffer_size < total_size);
+	EnsureBuffer(1);
+	*next = 0;
+	return start;
+}
 
-	buffer++;
-	char *newbuf = (char *) malloc(buffer_size);
-	buffers[buffer] = newbuf;
+void StringBuffer::DiscardString()
+{
+	next = start;
+	*next = 0;
+}
 
-	if (start != next)
-	{
-		*next = 0;
-		strcpy(newbuf, start);
-		next = newbuf + (next - start);
-		start = newbuf;
-	}
-	else
-	{
-		next = newbuf;
-		start = newbuf;
-	}
 
-	return buffer_size;
+void StringBuffer::EnsureBuffer(int size)
+{
+	if (next + size <= end)
+		return;
+
+	// Move the string in progress to a new chunk.  A string longer than a chunk is given twice the room it
+	// needs, so that building it costs a bounded number of moves.
+	long length = next - start;
+	long needed = length + size;
+	Chunk *chunk = NewChunk(needed > chunk_size ? 2 * needed : chunk_size);
+
+	current->next = chunk;
+	current = chunk;
+
+	memcpy(chunk->data, start, length);
+	start = chunk->data;
+	next = chunk->data + length;
+	end = chunk->data + chunk->size;
 }
@@ -2,35 +2,91 @@
 #ifndef STRING_BUFFER_H
 #define STRING_BUFFER_H
 
-#define MAX_STRING_BUFFERS (64)
+#include <stdio.h>
 
+#define STRING_CHUNK_SIZE       (64*1024)
+#define LARGE_PAGE_SIZE         (2*1024*1024)
+
+// Arena of null-terminated strings, which remain valid until Reset or deletion.
+//
+// Strings are packed into a list of chunks of a fixed size, and the list grows without limit.
+// Completed strings are never moved.  When a string being built with StartString and Append...
+// does not fit in the current chunk, only that string is moved into a new chunk.
+// Strings longer than a chunk are given a larger chunk of their own.
 class StringBuffer
 {
 public:
-	StringBuffer(int initial_size = 4096);
+	StringBuffer(int chunk_size = STRING_CHUNK_SIZE);
 	virtual ~StringBuffer();
 
+	// Frees all strings, keeping the first chunk for reuse
 	void Reset();
 
-	int NumStrings() const;
+	// Records the current end of the buffer, and later frees every string added after it.
+	// Only one mark is kept, and it must not be set while a string is being built.
+	void SetMark();
+	void ReleaseToMark();
+
+	// Back new chunks with large pages where the system supports them, using chunks of LARGE_PAGE_SIZE
+	void UseLargePages(bool enable);
 
 	char *AddString(const char *s);
 
 	void StartString();
 	void AppendString(const char *s);
 	void AppendChar(char c);
+	void AppendInt(int i);
 	char *FinishString();
 
+	// The string in progress, terminated but not finished, for looking up a name before deciding to keep it.
+	// It is valid until the next Append, Finish or Discard.
+	const char *CurrentString();
+
+	// Abandons the string in progress, so that its bytes are reused by the next string
+	void DiscardString();
+
+	// Usage totals
+	int NumStrings() const;
+	int NumChunks() const;
+	long BytesUsed() const;         // Including null-terminators
+	long BytesAllocated() const;
+
+	void PrintStatistics(FILE *f) const;
+
 protected:
-	int EnsureBuffer(int size);
+	// Makes room for size more bytes after next, moving the string in progress if needed
+	void EnsureBuffer(int size);
 
 private:
-	char *buffers[MAX_STRING_BUFFERS];
-	int buffer;
-	int buffer_size;
+	struct Chunk
+	{
+		Chunk *next;
+		long size;
+		char data[1];
+	};
+
+	Chunk *NewChunk(long size);
+	void FreeChunk(Chunk *chunk);
+
+	Chunk *first;
+	Chunk *current;
+	int chunk_size;
+	bool large_pages;
+
 	int num_strings;
+	int num_chunks;
+	long bytes_used;
+	long bytes_allocated;
+
 	char *next;
 	char *start;
+	char *end;
+
+	// State saved by SetMark
+	Chunk *mark_chunk;
+	char *mark_next;
+	int mark_strings;
+	long mark_bytes_used;
 };
 
 #endif
@@ -75,3 +75,28 @@ void *StringMap::Get(int i) const
 
 	return NULL;
 }
+
+
+// Remove by name, return the removed value, or NULL if not found
+void *StringMap::Remove(const char *name)
+{
+	if (name == NULL)
+		return NULL;
+
+	StringMapType::iterator iter = map.find(name);
+
+	// Check if not found
+	if (iter == map.end())
+	{
+		return NULL;
+	}
+
+	void *value = iter->second;
+	map.erase(iter);
+	return value;
+}
+
+void StringMap::Clear()
+{
+	map.clear();
+}
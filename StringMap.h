@@ -28,6 +28,8 @@ public:
 	void *Add(const char *name, void *value);       // Add by name
 	void *Get(const char *name) const;              // Get by name
 	void *Get(int i) const;                         // Get by index
+	void *Remove(const char *name);                 // Remove by name, returning the removed value
+	void Clear();                                   // Remove all, without deleting the values
 
 private:
 	StringMapType map;
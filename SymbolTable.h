@@ -6,9 +6,10 @@
 #include "StringMap.h"
 #include "Variable.h"
 #include "Expression.h"
+#include "AllocTracked.h"
 #include <stdio.h>
 
-class SymbolTable
+class SymbolTable : public AllocTracked<ALLOC_SYMBOL_TABLE>
 {
 public:
 	SymbolTable(bool builtin = false);
@@ -82,6 +82,21 @@ Signal *TF_Module::AddTF(Signal *dest, const TruthFunction &tf)
 	return dest;
 }
 
+int TF_Module::TFCount() const
+{
+	return num_tfs;
+}
+
+const Signal *TF_Module::TFRegister(int i) const
+{
+	return tf_regs[i];
+}
+
+const TruthFunction &TF_Module::TFLogic(int i) const
+{
+	return tf_logic[i];
+}
+
 
 
 /*
@@ -24,6 +24,11 @@ public:
 
 	virtual Signal *AddTF(Signal *dest, const TruthFunction &tf);
 
+	// TF registers, in the order they were added, with their truth functions
+	int TFCount() const;
+	const Signal *TFRegister(int i) const;
+	const TruthFunction &TFLogic(int i) const;
+
 protected:
 	Signal *tf_regs[MAX_TFS];
 	TruthFunction tf_logic[MAX_TFS];
@@ -43,7 +48,7 @@ public:
 	static  const SiliconObjectDefinition *BuiltinDefinition();
 
 	// Defined in TF_GenerateVerilog
-	virtual void GenerateVerilog(FILE *f) const;
+	virtual void GenerateVerilog(FILE *f, bool neutralName = false) const;
 
 protected:
 	virtual bool AssignResources();
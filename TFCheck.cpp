@@ -0,0 +1,104 @@
+#include "TFCheck.h"
+#include "TruthFunction.h"
+#include "FileIO.h"
+#include "Common.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+using namespace std;
+
+
+// Checks one line, returning false if it is a truth function assign which does not match its logic.
+// Lines which are not truth function assigns are skipped.
+static bool CheckLine(char *line, const char *filename, int lineNumber, int &checked)
+{
+	char *comment = strstr(line, "// TF 0x");
+	char *assign = strstr(line, "assign ");
+	if (!comment || !assign || assign > comment)
+		return true;
+
+	char *expr = strchr(assign, '=');
+	char *end = strchr(assign, ';');
+	if (!expr || !end || end > comment)
+		return true;
+
+	*end = '\0';
+	expr++;
+	while (*expr == ' ' || *expr == '\t')
+		expr++;
+
+	// Logic, then argument names in order
+	char *args = NULL;
+	int logic = strtol(comment + strlen("// TF "), &args, 16);
+
+	const char *names[4] = { NULL, NULL, NULL, NULL };
+	char *name = strtok(args, " \t\r\n");
+	for (int i=0; i < 4 && name; i++)
+	{
+		names[i] = name;
+		name = strtok(NULL, " \t\r\n");
+	}
+
+	checked++;
+
+	SourceCodeLocation loc;
+	loc.Filename = filename;
+	loc.Line = lineNumber;
+
+	int result;
+	if (!TruthFunction::EvaluateVerilogExpression(expr, names, result))
+	{
+		yyerrorfl(loc, "Cannot evaluate truth function expression '%s'", expr);
+		return false;
+	}
+
+	if (result != logic)
+	{
+		yyerrorfl(loc, "Expression '%s' computes 0x%04X, expected 0x%04X", expr, result, logic);
+		return false;
+	}
+
+	return true;
+}
+
+
+bool CheckVerilogTruthFunctions(const char *filename)
+{
+	FILE *f = OpenFile(filename, "r");
+	if (!f)
+	{
+		yyerrorfl(FileLocation(filename), "Cannot open Verilog file");
+		return false;
+	}
+
+	int checked = 0;
+	int mismatches = 0;
+	int lineNumber = 0;
+	string line;
+	char buf[1024];
+	while (fgets(buf, sizeof(buf), f))
+	{
+		// Collect lines longer than the buffer
+		line += buf;
+		if (line[line.size()-1] != '\n' && !feof(f))
+			continue;
+
+		lineNumber++;
+		vector<char> text(line.begin(), line.end());
+		text.push_back('\0');
+		line.clear();
+
+		if (!CheckLine(&text[0], filename, lineNumber, checked))
+			mismatches++;
+	}
+
+	bool ok = CloseFile(f);
+	if (!ok)
+		yyerrorfl(FileLocation(filename), "Cannot read Verilog file");
+
+	printf("%s: checked %d truth function(s), %d mismatch(es)\n", filename, checked, mismatches);
+
+	return ok && mismatches == 0;
+}
@@ -0,0 +1,14 @@
+#ifndef TF_CHECK_H
+#define TF_CHECK_H
+
+
+// Checks every truth function assign in a generated Verilog file, which may be compressed.
+// Each assign carries its logic and arguments in a trailing comment, such as
+//     assign Clock$_next = ~Clock;		// TF 0x5555 Clock
+// and its expression is evaluated for all 16 combinations of the arguments and compared with the logic.
+// Reports each mismatch as an error on its line, and a summary to stdout.
+// Returns false if any assign does not match, or the file cannot be read.
+extern bool CheckVerilogTruthFunctions(const char *filename);
+
+
+#endif
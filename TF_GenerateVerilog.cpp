@@ -2,6 +2,6 @@
 #include "TF.h"
 #include "Common.h"
 
-void FloatingTF::GenerateVerilog(FILE *f) const
+void FloatingTF::GenerateVerilog(FILE *f, bool neutralName) const
 {
 }
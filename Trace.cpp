@@ -0,0 +1,167 @@
+#include "Trace.h"
+#include "Module.h"
+#include "FileIO.h"
+
+#include <sys/time.h>
+#include <unistd.h>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+
+struct TraceEvent
+{
+	const char *Name;
+	string ModuleName;
+	string Filename;
+	int Signals, Instances, Connections;
+	int Thread;
+	long long Start;            // Microseconds since tracing was enabled
+	long long Duration;
+};
+
+static bool traceEnabled = false;
+static long long traceStart = 0;
+static vector<TraceEvent> traceEvents;
+
+
+static long long Microseconds()
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return (long long) tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+static int ThreadId()
+{
+#if defined(__linux__) && defined(SYS_gettid)
+	return (int) syscall(SYS_gettid);
+#else
+	return (int) getpid();
+#endif
+}
+
+// Records the start of an event, returning its index
+static int BeginEvent(const char *name)
+{
+	if (!traceEnabled)
+		return -1;
+
+	TraceEvent event;
+	event.Name = name;
+	event.Signals = event.Instances = event.Connections = -1;
+	event.Thread = ThreadId();
+	event.Start = Microseconds() - traceStart;
+	event.Duration = 0;
+
+	traceEvents.push_back(event);
+	return (int) traceEvents.size() - 1;
+}
+
+
+TraceSpan::TraceSpan(const char *name)
+{
+	event = BeginEvent(name);
+}
+
+TraceSpan::TraceSpan(const char *name, const Module *module)
+{
+	event = BeginEvent(name);
+	if (event >= 0 && module)
+	{
+		TraceEvent &e = traceEvents[event];
+		e.ModuleName = module->MangledName();
+		e.Signals = module->SignalCount();
+		e.Instances = module->InstanceCount();
+		e.Connections = module->ConnectionCount();
+	}
+}
+
+TraceSpan::TraceSpan(const char *name, const char *filename)
+{
+	event = BeginEvent(name);
+	if (event >= 0 && filename)
+		traceEvents[event].Filename = filename;
+}
+
+TraceSpan::~TraceSpan()
+{
+	if (event >= 0)
+	{
+		TraceEvent &e = traceEvents[event];
+		e.Duration = Microseconds() - traceStart - e.Start;
+	}
+}
+
+
+void EnableTrace()
+{
+	if (!traceEnabled)
+	{
+		traceEnabled = true;
+		traceStart = Microseconds();
+	}
+}
+
+bool TraceEnabled()
+{
+	return traceEnabled;
+}
+
+
+bool WriteTrace(const char *filename)
+{
+	FILE *f = OpenFile(filename, "w");
+	if (!f)
+		return false;
+
+	int pid = (int) getpid();
+
+	fprintf(f, "{\"traceEvents\":[\n");
+	fprintf(f, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"oasm2verilog\"}}", pid, pid);
+
+	// One named track per thread
+	vector<int> threads;
+	for (int i=0; i < (int) traceEvents.size(); i++)
+	{
+		int thread = traceEvents[i].Thread;
+		bool seen = false;
+		for (int t=0; t < (int) threads.size() && !seen; t++)
+			seen = (threads[t] == thread);
+
+		if (!seen)
+		{
+			threads.push_back(thread);
+			if (thread == pid)
+				fprintf(f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"main\"}}", pid, thread);
+			else
+				fprintf(f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"thread %d\"}}", pid, thread, (int) threads.size() - 1);
+		}
+	}
+
+	for (int i=0; i < (int) traceEvents.size(); i++)
+	{
+		const TraceEvent &e = traceEvents[i];
+		fprintf(f, ",\n{\"name\":\"%s\",\"cat\":\"pass\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%lld,\"dur\":%lld,\"args\":{",
+			e.Name, pid, e.Thread, e.Start, e.Duration);
+
+		if (!e.ModuleName.empty())
+		{
+			fprintf(f, "\"module\":");
+			WriteJsonString(f, e.ModuleName.c_str());
+			fprintf(f, ",\"signals\":%d,\"instances\":%d,\"connections\":%d", e.Signals, e.Instances, e.Connections);
+		}
+		else if (!e.Filename.empty())
+		{
+			fprintf(f, "\"file\":");
+			WriteJsonString(f, e.Filename.c_str());
+		}
+		fprintf(f, "}}");
+	}
+
+	fprintf(f, "\n],\"displayTimeUnit\":\"ms\"}\n");
+
+	return CloseFile(f);
+}
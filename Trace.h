@@ -0,0 +1,37 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdio.h>
+#include <string>
+using namespace std;
+
+class Module;
+
+
+// Timeline of compiler passes, written as Chrome trace JSON (viewable in chrome://tracing or Perfetto).
+//
+// While tracing is enabled, each TraceSpan records one complete event from its construction to its destruction,
+// tagged with a module name and its numbers of signals, instances and connections, or with a filename.
+// Spans nest, and each thread has its own track.
+class TraceSpan
+{
+public:
+	TraceSpan(const char *name);
+	TraceSpan(const char *name, const Module *module);
+	TraceSpan(const char *name, const char *filename);
+	~TraceSpan();
+
+private:
+	int event;                  // Index of the recorded event, or -1 when not tracing
+};
+
+
+// Starts recording spans
+void EnableTrace();
+bool TraceEnabled();
+
+// Writes all spans recorded so far.  Returns false if the file cannot be written.
+bool WriteTrace(const char *filename);
+
+
+#endif
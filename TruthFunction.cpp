@@ -12,14 +12,14 @@ void TruthFunction::Init()
 		Args[i] = NULL;
 	}
 	Logic = 0;
-	Buffer[0] = 0;
+	Postfix = "";
 }
 
 void TruthFunction::Print(FILE *f) const
 {
 	int i;
 
-	fprintf(f, "TF:0x%04X %s", Logic, Buffer);
+	fprintf(f, "TF:0x%04X %s", Logic, Postfix);
 	for (i=0; i < 4; i++)
 	{
 		if (Args[i])
@@ -87,8 +87,7 @@ TruthFunction TruthFunction::True()
 	TruthFunction tf;
 	tf.Init();
 	tf.Logic = 0xFFFF;
-	tf.Buffer[0] = 'T';
-	tf.Buffer[1] = 0;
+	tf.Postfix = "T";
 	return tf;
 }
 
@@ -97,8 +96,7 @@ TruthFunction TruthFunction::False()
 	TruthFunction tf;
 	tf.Init();
 	tf.Logic = 0x0000;
-	tf.Buffer[0] = 'F';
-	tf.Buffer[1] = 0;
+	tf.Postfix = "F";
 	return tf;
 }
 
@@ -119,8 +117,7 @@ TruthFunction TruthFunction::FromSignal(Signal *signal)
 	tf.Init();
 	tf.AddArg(signal);
 	tf.Logic = 0xAAAA;
-	tf.Buffer[0] = '0';
-	tf.Buffer[1] = 0;
+	tf.Postfix = "0";
 	return tf;
 }
 
@@ -128,6 +125,16 @@ TruthFunction TruthFunction::FromSignal(Signal *signal)
 
 // Logic Operations
 
+// Appends operands and an operator into a new postfix expression, in the global string buffer
+static const char *AppendPostfix(const char *postfix, const char *operand, const char *op)
+{
+	strings->StartString();
+	strings->AppendString(postfix);
+	strings->AppendString(operand);
+	strings->AppendString(op);
+	return strings->FinishString();
+}
+
 TruthFunction TruthFunction::NOT_TF() const
 {
 	TruthFunction result = *this;
@@ -136,15 +143,15 @@ TruthFunction TruthFunction::NOT_TF() const
 	// a~
 	if (Logic == 0x0000)
 	{
-		strcpy(result.Buffer, "T");
+		result.Postfix = "T";
 	}
 	else if (Logic == 0xFFFF)
 	{
-		strcpy(result.Buffer, "F");
+		result.Postfix = "F";
 	}
 	else
 	{
-		strcatbuf(result.Buffer, MAX_TF_BUF_LEN, "~");
+		result.Postfix = AppendPostfix(Postfix, "", "~");
 	}
 
 	result.Logic ^= 0xFFFF;
@@ -161,17 +168,15 @@ TruthFunction TruthFunction::AND_TF(const TruthFunction &tf) const
 	if (Logic == 0x0000)
 	{
 		// 0 & x = 0
-		strcpy(result.Buffer, "F");
+		result.Postfix = "F";
 	}
 	else if (Logic == 0xFFFF)
 	{
-		// 1 & x = x
-		strcpy(result.Buffer, Buffer);
+		// 1 & x = x, which is already in result
 	}
 	else
 	{
-		strcatbuf(result.Buffer, MAX_TF_BUF_LEN, Buffer);
-		strcatbuf(result.Buffer, MAX_TF_BUF_LEN, "&");
+		result.Postfix = AppendPostfix(result.Postfix, Postfix, "&");
 	}
 
 	result.Logic &= Logic;
@@ -187,21 +192,19 @@ TruthFunction TruthFunction::OR_TF(const TruthFunction &tf) const
 	// ba|
 	if (Logic == 0x0000)
 	{
-		// 0 | x = x
-		strcpy(result.Buffer, Buffer);
+		// 0 | x = x, which is already in result
 	}
 	else if (Logic == 0xFFFF)
 	{
 		// 1 | x = 1
-		strcpy(result.Buffer, "T");
+		result.Postfix = "T";
 	}
 	else
 	{
-		strcatbuf(result.Buffer, MAX_TF_BUF_LEN, Buffer);
-		strcatbuf(result.Buffer, MAX_TF_BUF_LEN, "|");
+		result.Postfix = AppendPostfix(result.Postfix, Postfix, "|");
 	}
 
-	result.Logic &= Logic;
+	result.Logic |= Logic;
 
 	return result;
 }
@@ -214,19 +217,16 @@ TruthFunction TruthFunction::XOR_TF(const TruthFunction &tf) const
 	// ba^
 	if (Logic == 0x0000)
 	{
-		// 0 ^ x = x
-		strcpy(result.Buffer, Buffer);
+		// 0 ^ x = x, which is already in result
 	}
 	else if (Logic == 0xFFFF)
 	{
 		// 1 ^ x = ~x
-		strcpy(result.Buffer, Buffer);
-		strcatbuf(result.Buffer, MAX_TF_BUF_LEN, "~");
+		result.Postfix = AppendPostfix(result.Postfix, "", "~");
 	}
 	else
 	{
-		strcatbuf(result.Buffer, MAX_TF_BUF_LEN, Buffer);
-		strcatbuf(result.Buffer, MAX_TF_BUF_LEN, "^");
+		result.Postfix = AppendPostfix(result.Postfix, Postfix, "^");
 	}
 
 	result.Logic ^= Logic;
@@ -256,29 +256,6 @@ TruthFunction TruthFunction::Ternary_TF(const TruthFunction &tf1, const TruthFun
 
 // Swap functions
 
-// instance method to modify logic and buffer
-void TruthFunction::SwapLogic(int a, int b)
-{
-	if (a == b) return;
-
-	// Swap Buffer
-	char ca = '0' + a;
-	char cb = '0' + b;
-
-	char *c = Buffer;
-	while (*c)
-	{
-		if (*c == ca)
-			*c = cb;
-		else if (*c == cb)
-			*c = ca;
-		c++;
-	}
-
-	// Swap Logic
-	Logic = SwapLogic(Logic, a, b);
-}
-
 // static function to compute logic
 int TruthFunction::SwapLogic(int logic, int a, int b)
 {
@@ -396,7 +373,7 @@ TruthFunction TruthFunction::Merge(const TruthFunction &tf) const
 	// Result contains Logic of tf argument, possibly modified, and merged Args array
 	TruthFunction result;
 	result.Logic = tf.Logic;
-	strcpy(result.Buffer, tf.Buffer);
+	result.Postfix = tf.Postfix;
 
 	// Start out with original Args array
 	for (i1=0; i1 < 4; i1++)
@@ -404,6 +381,10 @@ TruthFunction TruthFunction::Merge(const TruthFunction &tf) const
 		result.Args[i1] = Args[i1];
 	}
 
+	// Current position in result of each Arg from tf, as Args are swapped into place
+	int position[4] = {0, 1, 2, 3};
+	bool moved = false;
+
 	// Copy each Arg from tf
 	for (i2=0; i2 < 4; i2++)
 	{
@@ -425,85 +406,112 @@ TruthFunction TruthFunction::Merge(const TruthFunction &tf) const
 			return result;
 		}
 
-		if (i1 != i2)
+		result.Args[i1] = sig2;
+
+		int from = position[i2];
+		if (from != i1)
 		{
-			result.Args[i1] = sig2;
-			result.SwapLogic(i2, i1);
+			result.Logic = SwapLogic(result.Logic, from, i1);
+			moved = true;
+
+			// The Arg from tf which was at i1 moves to where this one was
+			for (int k=0; k < 4; k++)
+			{
+				if (position[k] == i1)
+					position[k] = from;
+			}
+			position[i2] = i1;
 		}
 	}
 
+	// Renumber the Args of tf in its postfix expression, once all have found their place
+	if (moved)
+	{
+		strings->StartString();
+		for (const char *c = tf.Postfix; *c; c++)
+		{
+			if (*c >= '0' && *c <= '3')
+				strings->AppendChar('0' + position[*c - '0']);
+			else
+				strings->AppendChar(*c);
+		}
+		result.Postfix = strings->FinishString();
+	}
+
 	return result;
 }
 
 
-// Generate a string Verilog expression of the TF logic
-const char *TruthFunction::ToVerilogExpression(char *buf, int buflen) const
+// Generate a string Verilog expression of the TF logic, in the global string buffer
+const char *TruthFunction::ToVerilogExpression() const
 {
-	if (buflen > 1)
+	// Recursively generate expression
+	bufferLocation = strlen(Postfix) - 1;           // static variable used throughout recursion
+	strings->StartString();
+	if (!WriteVerilogExpression())
 	{
-		// Clear buffer
-		buf[0] = 0;
-
-		// Recursively generate expression
-		bufferLocation = strlen(Buffer) - 1;            // static variable used throughout recursion
-		if (WriteVerilogExpression(buf, buflen-1))
-			return buf;
+		strings->DiscardString();
+		yyerrorf("Unable to generate Verilog expression for truth function 0x%04X", Logic);
+		return "UNKNOWN";
 	}
-	
-	yyerrorf("Unable to generate Verilog expression for truth function longer than %d characters", buflen-1);
-	return "UNKNOWN";
+	const char *expr = strings->FinishString();
+
+	if (!MatchesVerilogExpression(expr))
+		yyerrorf("Internal error:  Verilog expression '%s' does not match truth function 0x%04X", expr, Logic);
+
+	return expr;
 }
 
-// Recursive call to generate verilog expression
-bool TruthFunction::WriteVerilogExpression(char *buf, int buflen) const
+// Recursive call to generate verilog expression, appending to the string in progress
+bool TruthFunction::WriteVerilogExpression() const
 {
 	if (bufferLocation < 0)
 		return false;
 
-	char c = Buffer[bufferLocation];
+	char c = Postfix[bufferLocation];
 	bufferLocation--;
 
 	switch (c)
 	{
-		case 'F':   strcatbuf(buf, buflen, "1'b0");  break;
-		case 'T':   strcatbuf(buf, buflen, "1'b1");  break;
+		case 'F':   strings->AppendString("1'b0");  break;
+		case 'T':   strings->AppendString("1'b1");  break;
 
-		case '0':   strcatbuf(buf, buflen, Args[0]->Name());  break;
-		case '1':   strcatbuf(buf, buflen, Args[1]->Name());  break;
-		case '2':   strcatbuf(buf, buflen, Args[2]->Name());  break;
-		case '3':   strcatbuf(buf, buflen, Args[3]->Name());  break;
+		case '0':   strings->AppendString(Args[0]->Name());  break;
+		case '1':   strings->AppendString(Args[1]->Name());  break;
+		case '2':   strings->AppendString(Args[2]->Name());  break;
+		case '3':   strings->AppendString(Args[3]->Name());  break;
 
 		case '~':
-			strcatbuf(buf, buflen, "~");
-			if (!WriteVerilogExpression(buf, buflen)) return false;
+			strings->AppendChar('~');
+			if (!WriteVerilogExpression()) return false;
 			break;
 			
 		case '|':
-			strcatbuf(buf, buflen, "(");
-			if (!WriteVerilogExpression(buf, buflen)) return false;
-			strcatbuf(buf, buflen, " | ");
-			if (!WriteVerilogExpression(buf, buflen)) return false;
-			strcatbuf(buf, buflen, ")");
+			strings->AppendChar('(');
+			if (!WriteVerilogExpression()) return false;
+			strings->AppendString(" | ");
+			if (!WriteVerilogExpression()) return false;
+			strings->AppendChar(')');
 			break;
 			
 		case '&':
-			strcatbuf(buf, buflen, "(");
-			if (!WriteVerilogExpression(buf, buflen)) return false;
-			strcatbuf(buf, buflen, " & ");
-			if (!WriteVerilogExpression(buf, buflen)) return false;
-			strcatbuf(buf, buflen, ")");
+			strings->AppendChar('(');
+			if (!WriteVerilogExpression()) return false;
+			strings->AppendString(" & ");
+			if (!WriteVerilogExpression()) return false;
+			strings->AppendChar(')');
 			break;
 
 		case '^':
-			strcatbuf(buf, buflen, "(");
-			if (!WriteVerilogExpression(buf, buflen)) return false;
-			strcatbuf(buf, buflen, " ^ ");
-			if (!WriteVerilogExpression(buf, buflen)) return false;
-			strcatbuf(buf, buflen, ")");
+			strings->AppendChar('(');
+			if (!WriteVerilogExpression()) return false;
+			strings->AppendString(" ^ ");
+			if (!WriteVerilogExpression()) return false;
+			strings->AppendChar(')');
 			break;
 
 		default:
-			// Unrecognized character in Buffer
+			// Unrecognized character in Postfix
 			return false;
 	}
 
@@ -513,3 +521,117 @@ bool TruthFunction::WriteVerilogExpression(char *buf, int buflen) const
 // static variable used throughout recursion
 int TruthFunction::bufferLocation = -1;
 
+
+
+// Recursive descent parser for EvaluateVerilogExpression, with Verilog precedence:  ~ and !, then &, ^, |.
+// Every value is a truth table with one bit lane for each of the 16 combinations of the arguments.
+struct ExpressionEvaluator
+{
+	const char *p;
+	const char *const *names;
+	bool ok;
+
+	void SkipSpaces()
+	{
+		while (*p == ' ' || *p == '\t')
+			p++;
+	}
+
+	// Consumes an operator, which may be doubled as a logical operator (&& or ||)
+	bool Accept(char c)
+	{
+		SkipSpaces();
+		if (*p != c)
+			return false;
+		p++;
+		if ((c == '&' || c == '|') && *p == c)
+			p++;
+		return true;
+	}
+
+	int Or()
+	{
+		int value = Xor();
+		while (ok && Accept('|'))
+			value |= Xor();
+		return value;
+	}
+
+	int Xor()
+	{
+		int value = And();
+		while (ok && Accept('^'))
+			value ^= And();
+		return value;
+	}
+
+	int And()
+	{
+		int value = Unary();
+		while (ok && Accept('&'))
+			value &= Unary();
+		return value;
+	}
+
+	int Unary()
+	{
+		if (Accept('~') || Accept('!'))
+			return Unary() ^ 0xFFFF;
+		return Primary();
+	}
+
+	int Primary()
+	{
+		if (Accept('('))
+		{
+			int value = Or();
+			if (!Accept(')'))
+				ok = false;
+			return value;
+		}
+
+		// Constants and signal names, which may include a bit index such as Result[2]
+		SkipSpaces();
+		const char *start = p;
+		while (*p && !strchr(" \t()~!&|^;", *p))
+			p++;
+		int len = p - start;
+
+		if (len == 4 && strncmp(start, "1'b0", 4) == 0)
+			return 0x0000;
+		if (len == 4 && strncmp(start, "1'b1", 4) == 0)
+			return 0xFFFF;
+
+		for (int i=0; i < 4 && len > 0; i++)
+		{
+			if (names[i] && (int) strlen(names[i]) == len && strncmp(start, names[i], len) == 0)
+				return TF_ARG[i];
+		}
+
+		ok = false;
+		return 0;
+	}
+};
+
+bool TruthFunction::EvaluateVerilogExpression(const char *expr, const char *const names[4], int &logic)
+{
+	ExpressionEvaluator evaluator;
+	evaluator.p = expr;
+	evaluator.names = names;
+	evaluator.ok = true;
+
+	logic = evaluator.Or() & 0xFFFF;
+
+	evaluator.SkipSpaces();
+	return evaluator.ok && (*evaluator.p == 0 || *evaluator.p == ';');
+}
+
+bool TruthFunction::MatchesVerilogExpression(const char *expr) const
+{
+	const char *names[4];
+	for (int i=0; i < 4; i++)
+		names[i] = Args[i] ? Args[i]->Name() : NULL;
+
+	int logic;
+	return EvaluateVerilogExpression(expr, names, logic) && logic == Logic;
+}
@@ -11,15 +11,13 @@ class Signal;
 #define TF_ARG2		0xF0F0
 #define TF_ARG3		0xFF00
 
-#define MAX_TF_BUF_LEN      (64)
-
 const int TF_ARG[4] = {TF_ARG0, TF_ARG1, TF_ARG2, TF_ARG3};
 
 struct TruthFunction
 {
 	Signal *Args[4];
 	int Logic;
-	char Buffer[MAX_TF_BUF_LEN];
+	const char *Postfix;        // Expression in postfix form, with Args as '0' to '3', in the global string buffer
 
 	void Init();
 	int NumArgs() const;
@@ -45,15 +43,23 @@ struct TruthFunction
 	TruthFunction NE_TF(const TruthFunction &tf) const;
 	TruthFunction Ternary_TF(const TruthFunction &tf1, const TruthFunction &tf2) const;
 
-	// Generate a string Verilog expression of the TF logic
-	const char *ToVerilogExpression(char *buf, int buflen) const;
+	// Generate a string Verilog expression of the TF logic, in the global string buffer.
+	// The expression is evaluated back and checked against Logic, reporting an error if they differ.
+	const char *ToVerilogExpression() const;
+
+	// Evaluates a Verilog expression of up to 4 named bit arguments for all 16 combinations at once,
+	// one bit lane per combination, giving the truth table in the same form as Logic.
+	// Returns false if the expression cannot be parsed or names an unknown signal.
+	static bool EvaluateVerilogExpression(const char *expr, const char *const names[4], int &logic);
+
+	// Returns true if a Verilog expression of the Args computes Logic
+	bool MatchesVerilogExpression(const char *expr) const;
 
 private:
 	int AddArg(Signal *signal);		// Returns the new TF index, or -1 if none available
 	TruthFunction Merge(const TruthFunction &tf) const;
-	void SwapLogic(int a, int b);
 
-	bool WriteVerilogExpression(char *buf, int buflen) const;
+	bool WriteVerilogExpression() const;
 	static int bufferLocation;      // used in recursion
 
 	static int SwapLogic(int logic, int a, int b);
@@ -0,0 +1,455 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+#include <algorithm>
+#include "parser.h"
+#include "Signal.h"
+#include "TruthFunction.h"
+
+//
+// Microbenchmarks of the core data structures.
+//
+// Each benchmark runs a fixed number of operations per repetition.  After warmup repetitions, the time per
+// operation of each repetition is collected, and the minimum, percentiles and maximum are written to stdout
+// as one JSON object per line, so that results can be compared over time.
+// Build with optimization for meaningful numbers, for example:  make clean bench PROFILE=-O2
+//
+// Usage:  benchDataStructures [-r repetitions] [-w warmups] [filter]
+//   Only benchmarks whose name contains the filter are run.
+//
+
+
+struct Benchmark
+{
+	const char *Name;
+	int Ops;                    // Operations per repetition
+	void (*Setup)();            // Optional, not timed
+	void (*Run)();
+	void (*Teardown)();         // Optional, not timed
+};
+
+
+static double Seconds()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Value at a percentile of sorted samples, interpolating between neighbors
+static double Percentile(const vector<double> &sorted, double p)
+{
+	double position = p / 100 * (sorted.size() - 1);
+	int below = (int) position;
+	if (below + 1 >= (int) sorted.size())
+		return sorted[below];
+
+	double fraction = position - below;
+	return sorted[below] * (1 - fraction) + sorted[below + 1] * fraction;
+}
+
+static void RunBenchmark(const Benchmark &b, int warmups, int repetitions)
+{
+	vector<double> samples;
+	for (int i=0; i < warmups + repetitions; i++)
+	{
+		if (b.Setup)
+			b.Setup();
+
+		double start = Seconds();
+		b.Run();
+		double elapsed = Seconds() - start;
+
+		if (b.Teardown)
+			b.Teardown();
+
+		if (i >= warmups)
+			samples.push_back(elapsed * 1e9 / b.Ops);
+	}
+
+	sort(samples.begin(), samples.end());
+	printf("{\"benchmark\":\"%s\",\"ops\":%d,\"repetitions\":%d,\"ns_per_op\":{\"min\":%.2f,\"p10\":%.2f,\"median\":%.2f,\"p90\":%.2f,\"p99\":%.2f,\"max\":%.2f}}\n",
+		b.Name, b.Ops, repetitions, samples.front(), Percentile(samples, 10), Percentile(samples, 50),
+		Percentile(samples, 90), Percentile(samples, 99), samples.back());
+	fflush(stdout);
+}
+
+
+// Results are accumulated here, so that the work cannot be optimized away
+static volatile long sink;
+
+
+//
+// StringMap
+//
+#define MAP_SIZE        10000
+#define INDEXED_SIZE    1000
+
+static vector<const char*> keys;
+static StringMap *stringMap;
+
+static void MakeKeys()
+{
+	for (int i=0; i < MAP_SIZE; i++)
+	{
+		strings->StartString();
+		strings->AppendString("signal_");
+		strings->AppendInt(i * 7919 % MAP_SIZE);
+		keys.push_back(strings->FinishString());
+	}
+}
+
+static void NewMap()
+{
+	stringMap = new StringMap();
+}
+
+static void FillMap()
+{
+	stringMap = new StringMap();
+	for (int i=0; i < MAP_SIZE; i++)
+		stringMap->Add(keys[i], (void *) keys[i]);
+}
+
+static void DeleteMap()
+{
+	delete stringMap;  stringMap = NULL;
+}
+
+static void StringMapAdd()
+{
+	for (int i=0; i < MAP_SIZE; i++)
+		stringMap->Add(keys[i], (void *) keys[i]);
+}
+
+static void StringMapGet()
+{
+	long found = 0;
+	for (int i=0; i < MAP_SIZE; i++)
+		found += (stringMap->Get(keys[i]) != NULL);
+	sink = found;
+}
+
+static void FillSmallMap()
+{
+	stringMap = new StringMap();
+	for (int i=0; i < INDEXED_SIZE; i++)
+		stringMap->Add(keys[i], (void *) keys[i]);
+}
+
+// Walks the stringMap by index, as the compiler does for signals, instances and modules
+static void StringMapIndexed()
+{
+	long found = 0;
+	int n = stringMap->Count();
+	for (int i=0; i < n; i++)
+		found += (stringMap->Get(i) != NULL);
+	sink = found;
+}
+
+
+//
+// SymbolTable
+//
+#define SCOPE_DEPTH     4
+#define SCOPE_SYMBOLS   100
+
+static SymbolTable *scope;
+
+// Nested scopes as in inner modules, each with its own variables
+static void PushScopes()
+{
+	scope = globalSymbols;
+	for (int depth=0; depth < SCOPE_DEPTH; depth++)
+	{
+		scope = scope->PushScope(new SymbolTable());
+		for (int i=0; i < SCOPE_SYMBOLS; i++)
+			scope->AddVariable(keys[depth * SCOPE_SYMBOLS + i], Expression::FromInt(i));
+	}
+}
+
+static void PopScopes()
+{
+	for (int depth=0; depth < SCOPE_DEPTH; depth++)
+		scope = scope->PopScope();
+}
+
+// Lookups of names from every scope, from the innermost scope
+static void SymbolTableLookup()
+{
+	long found = 0;
+	for (int i=0; i < SCOPE_DEPTH * SCOPE_SYMBOLS; i++)
+		found += (scope->Get(keys[i]) != NULL);
+	sink = found;
+}
+
+
+//
+// StringBuffer
+//
+#define STRING_COUNT    10000
+
+static StringBuffer *buffer;
+
+static void NewBuffer()
+{
+	buffer = new StringBuffer();
+}
+
+static void DeleteBuffer()
+{
+	delete buffer;  buffer = NULL;
+}
+
+static void StringBufferAdd()
+{
+	for (int i=0; i < STRING_COUNT; i++)
+		sink = (long) buffer->AddString(keys[i]);
+}
+
+// Mangled names built from parts, as for delayed signals and inner modules
+static void StringBufferBuild()
+{
+	for (int i=0; i < STRING_COUNT; i++)
+	{
+		buffer->StartString();
+		buffer->AppendString("Outer");
+		buffer->AppendChar('$');
+		buffer->AppendString(keys[i]);
+		buffer->AppendChar('$');
+		buffer->AppendInt(i);
+		sink = (long) buffer->FinishString();
+	}
+}
+
+static void StringBufferChars()
+{
+	for (int i=0; i < STRING_COUNT; i++)
+	{
+		buffer->StartString();
+		for (int c=0; c < 32; c++)
+			buffer->AppendChar('a' + c % 26);
+		sink = (long) buffer->FinishString();
+	}
+}
+
+
+//
+// TruthFunction
+//
+#define TF_COUNT        100000
+
+static Signal *tfSignals[4];
+static TruthFunction tfArgs[4];
+
+static void MakeTFSignals()
+{
+	const char *names[4] = { "a", "b", "c", "d" };
+	for (int i=0; i < 4; i++)
+	{
+		tfSignals[i] = new Signal(names[i], BEHAVIOR_WIRE, DATA_TYPE_BIT);
+		tfArgs[i] = TruthFunction::FromSignal(tfSignals[i]);
+	}
+}
+
+static void TruthFunctionAND()
+{
+	long logic = 0;
+	for (int i=0; i < TF_COUNT; i++)
+		logic += tfArgs[i & 3].AND_TF(tfArgs[(i + 1) & 3]).AND_TF(tfArgs[(i + 2) & 3]).Logic;
+	sink = logic;
+}
+
+static void TruthFunctionOR()
+{
+	long logic = 0;
+	for (int i=0; i < TF_COUNT; i++)
+		logic += tfArgs[i & 3].OR_TF(tfArgs[(i + 1) & 3]).OR_TF(tfArgs[(i + 2) & 3]).Logic;
+	sink = logic;
+}
+
+static void TruthFunctionXOR()
+{
+	long logic = 0;
+	for (int i=0; i < TF_COUNT; i++)
+		logic += tfArgs[i & 3].XOR_TF(tfArgs[(i + 1) & 3]).XOR_TF(tfArgs[(i + 2) & 3]).Logic;
+	sink = logic;
+}
+
+static void TruthFunctionTernary()
+{
+	long logic = 0;
+	for (int i=0; i < TF_COUNT; i++)
+		logic += tfArgs[i & 3].Ternary_TF(tfArgs[(i + 1) & 3], tfArgs[(i + 2) & 3]).Logic;
+	sink = logic;
+}
+
+#define TF_EXPRESSION_COUNT     10000
+
+static TruthFunction tfExpressions[16];
+
+static void MakeTFExpressions()
+{
+	for (int i=0; i < 16; i++)
+	{
+		TruthFunction ab = tfArgs[0].AND_TF(tfArgs[1]);
+		TruthFunction cd = (i & 1) ? tfArgs[2].XOR_TF(tfArgs[3]) : tfArgs[2].OR_TF(tfArgs[3]);
+		tfExpressions[i] = (i & 2) ? ab.OR_TF(cd) : ab.Ternary_TF(cd, tfArgs[(i >> 2) & 3]);
+	}
+}
+
+static void TruthFunctionToVerilog()
+{
+	for (int i=0; i < TF_EXPRESSION_COUNT; i++)
+		sink = (long) tfExpressions[i & 15].ToVerilogExpression();
+}
+
+
+//
+// ExpressionArray
+//
+#define ARRAY_COUNT     10000
+#define ARRAY_SIZE      16
+
+static void ExpressionArrayBuild()
+{
+	for (int i=0; i < ARRAY_COUNT; i++)
+	{
+		Expression array = Expression::Array();
+		for (int v=0; v < ARRAY_SIZE; v++)
+			array.val.array->AddValue(Expression::FromInt(v));
+		array.Delete();
+	}
+}
+
+static Expression sharedArray;
+
+static void MakeSharedArray()
+{
+	sharedArray = Expression::Array();
+	for (int v=0; v < ARRAY_SIZE; v++)
+		sharedArray.val.array->AddValue(Expression::FromInt(v));
+}
+
+static void DeleteSharedArray()
+{
+	sharedArray.Delete();
+}
+
+// Shallow copies and references, as when arrays are assigned to variables and parameters
+static void ExpressionArrayRefCount()
+{
+	for (int i=0; i < ARRAY_COUNT; i++)
+	{
+		Expression alias = sharedArray;
+		alias.IncRef();
+		alias.Delete();
+
+		Expression copy = sharedArray.Copy();
+		copy.Delete();
+	}
+}
+
+
+//
+// Signal
+//
+#define SIGNAL_COUNT    1000
+
+static Module *signalModule;
+static vector<Signal*> baseSignals;
+
+static void MakeSignalModule()
+{
+	signalModule = new Module("bench", NULL, false);
+	baseSignals.clear();
+	for (int i=0; i < SIGNAL_COUNT; i++)
+	{
+		Signal *sig = new Signal(keys[i], BEHAVIOR_REG);
+		signalModule->AddSignal(sig);
+		baseSignals.push_back(sig);
+	}
+}
+
+static void DeleteSignalModule()
+{
+	delete signalModule;  signalModule = NULL;
+}
+
+static void SignalDelay()
+{
+	for (int i=0; i < SIGNAL_COUNT; i++)
+		sink = (long) baseSignals[i]->Delay(1 + i % 5);
+}
+
+static void SignalBitSlice()
+{
+	for (int i=0; i < SIGNAL_COUNT; i++)
+		sink = (long) baseSignals[i]->BitSlice(i % (MAX_REG_BIT_SLICE_INDEX + 1));
+}
+
+
+static const Benchmark benchmarks[] =
+{
+	{ "StringMap.Add",              MAP_SIZE,                   NewMap,             StringMapAdd,           DeleteMap },
+	{ "StringMap.Get",              MAP_SIZE,                   FillMap,            StringMapGet,           DeleteMap },
+	{ "StringMap.GetIndexed",       INDEXED_SIZE,               FillSmallMap,       StringMapIndexed,       DeleteMap },
+	{ "SymbolTable.ScopedLookup",   SCOPE_DEPTH*SCOPE_SYMBOLS,  PushScopes,         SymbolTableLookup,      PopScopes },
+	{ "StringBuffer.AddString",     STRING_COUNT,               NewBuffer,          StringBufferAdd,        DeleteBuffer },
+	{ "StringBuffer.BuildName",     STRING_COUNT,               NewBuffer,          StringBufferBuild,      DeleteBuffer },
+	{ "StringBuffer.AppendChar",    STRING_COUNT,               NewBuffer,          StringBufferChars,      DeleteBuffer },
+	{ "TruthFunction.AND",          TF_COUNT,                   NULL,               TruthFunctionAND,       NULL },
+	{ "TruthFunction.OR",           TF_COUNT,                   NULL,               TruthFunctionOR,        NULL },
+	{ "TruthFunction.XOR",          TF_COUNT,                   NULL,               TruthFunctionXOR,       NULL },
+	{ "TruthFunction.Ternary",      TF_COUNT,                   NULL,               TruthFunctionTernary,   NULL },
+	{ "TruthFunction.ToVerilog",    TF_EXPRESSION_COUNT,        NULL,               TruthFunctionToVerilog, NULL },
+	{ "ExpressionArray.Build",      ARRAY_COUNT,                NULL,               ExpressionArrayBuild,   NULL },
+	{ "ExpressionArray.RefCount",   ARRAY_COUNT,                MakeSharedArray,    ExpressionArrayRefCount, DeleteSharedArray },
+	{ "Signal.Delay",               SIGNAL_COUNT,               MakeSignalModule,   SignalDelay,            DeleteSignalModule },
+	{ "Signal.BitSlice",            SIGNAL_COUNT,               MakeSignalModule,   SignalBitSlice,         DeleteSignalModule },
+};
+
+
+int main(int argc, char *argv[])
+{
+	int repetitions = 25;
+	int warmups = 3;
+	const char *filter = NULL;
+
+	for (int i=1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-r") == 0 && i+1 < argc)
+			repetitions = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-w") == 0 && i+1 < argc)
+			warmups = atoi(argv[++i]);
+		else if (argv[i][0] != '-' && !filter)
+			filter = argv[i];
+		else
+		{
+			fprintf(stderr, "Usage: benchDataStructures [-r repetitions] [-w warmups] [filter]\n");
+			return 1;
+		}
+	}
+
+	if (repetitions < 1)
+		repetitions = 1;
+
+	InitParser();
+	MakeKeys();
+	MakeTFSignals();
+	MakeTFExpressions();
+
+	for (int i=0; i < (int) countof(benchmarks); i++)
+	{
+		if (!filter || strstr(benchmarks[i].Name, filter))
+			RunBenchmark(benchmarks[i], warmups, repetitions);
+	}
+
+	for (int i=0; i < 4; i++)
+		delete tfSignals[i];
+	CleanupParser();
+
+	return errorCount > 0 ? 1 : 0;
+}
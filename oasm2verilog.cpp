@@ -6,21 +6,44 @@
 
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
 #include <vector>
+#include <set>
+#include <map>
+#include <time.h>
+#include <ctype.h>
+#include <algorithm>
 using namespace::std;
 
 #include "parser.h"
+#include "Compiler.h"
+#include "FileIO.h"
+#include "DeadLogic.h"
+#include "Latency.h"
+#include "AluSimulator.h"
+#include "DesignSimulator.h"
+#include "TFCheck.h"
+#include "Trace.h"
+#include "AllocTracked.h"
+#include "SiliconObjectRegistry.h"
+#include "NetlistWriter.h"
+#include "Diagnostics.h"
 
 
-// Version Information
-const char *oasm2verilog_version = "0.3";
-
 // Command-Line Parameters
 vector<const char *> input_filenames;
 vector<ParseMode> input_file_modes;
+vector<const char *> top_module_names;
+vector<const char *> device_filenames;
 
 char *output_filename = NULL;
+char *output_dir = NULL;
+char *netlist_filename = NULL;
 FILE *output_file = NULL;
 
 bool printHelp = false;
@@ -28,19 +51,79 @@ bool printVersion = false;
 bool noEmbeddedOasm = false;
 bool parseOnly = false;
 bool generateReport = false;
-bool warnAsError = false;
+bool reportLatency = false;
+bool shareDefinitions = false;
+bool pruneDeadLogic = false;
+bool deterministic = false;
+bool writeIfChanged = false;
+bool largePageStrings = false;
+bool memoryStatistics = false;
+
+bool writeDependencies = false;
+const char *dependency_filename = NULL;
+
+const char *simulate_alu_name = NULL;
+const char *simulate_name = NULL;
+const char *trace_filename = NULL;
+const char *stimulus_filename = NULL;
+int simulationCycles = 0;
+
+const char *check_tf_filename = NULL;
+
+// Errors and warnings, grouped and written at the end of each phase
+DiagnosticsEngine diagnostics;
+
+// Configurations compiled with --sweep, each a set of var overrides named in the output
+struct SweepConfiguration
+{
+	const char *Name;
+	vector<VarOverride> Overrides;
+};
+
+const char *sweep_filename = NULL;
+vector<SweepConfiguration> sweep_configurations;
+int sweepJobs = 0;
 
 void Usage(FILE *f)
 {
 	fprintf(f, "oasm2verilog [options] [-o <verilog_file>] [-l <library_file>] <oasm_file1> [...]\n");
 	fprintf(f, "  -h                Help                 (this message)\n");
 	fprintf(f, "  -v                Version              (current version %s)\n", oasm2verilog_version);
-	fprintf(f, "  -o [out_file]     Output Verilog file  (defaults to stdout)\n");
-	fprintf(f, "  -l [in_file]      Read library file containing embedded OASM\n");
+	fprintf(f, "  -o [out_file]     Output Verilog file  (defaults to stdout, compressed if named .gz or .zst)\n");
+	fprintf(f, "  -O [out_dir]      Output one Verilog file per module (Top.Inner.v) into out_dir, with a filelist and interface file,\n");
+	fprintf(f, "                    all without a generation timestamp\n");
+	fprintf(f, "  -l [in_file]      Read library file containing embedded OASM (may be .gz or .zst)\n");
 	fprintf(f, "  -n                Do not generate embedded OASM section in Verilog output\n");
+	fprintf(f, "  --netlist [out_file]  Also write the resolved design as a binary netlist, described in NetlistFormat.h\n");
+	fprintf(f, "  --device [in_file]  Read simple silicon object definitions from a device description file (may be repeated)\n");
+	fprintf(f, "  -D [name=value]   Override the value of a file-scope var  (an integer, \"string\" or enumerated value; may be repeated)\n");
+	fprintf(f, "  --sweep [sweep_file]  Compile once per line of sweep_file, \"<config> name=value ...\", adding the\n");
+	fprintf(f, "                    configuration name to the output file (out.<config>.v) or directory (<out_dir>/<config>)\n");
+	fprintf(f, "  -j [n]            Number of configurations compiled at once by --sweep  (defaults to the number of cores)\n");
 	fprintf(f, "  -p                Parse only and report errors.  Do not generate Verilog\n");
+	fprintf(f, "  --top [module]    Only compile modules reachable from this top-level module (may be repeated)\n");
 	fprintf(f, "  -r                Generate report after parsing\n");
+	fprintf(f, "  --latency         Report min/max cycle latency between the ports of each top-level module\n");
+	fprintf(f, "  -s                Share one Verilog module between structurally identical inner definitions\n");
+	fprintf(f, "  --prune-dead      Remove wires, delays, automatic ports and connections which feed no output\n");
+	fprintf(f, "  --simulate-alu [alu] [stimulus_file]  Run the program of an ALU (Outer.Inner for inner ALUs) and trace\n");
+	fprintf(f, "                    each cycle to stdout, instead of generating Verilog.  Only ALU functions whose arithmetic\n");
+	fprintf(f, "                    is fixed by their name are modelled (add, sub, inc, dec, mov, inv, and, or, xor, zero)\n");
+	fprintf(f, "  --simulate [top] [stimulus_file]  Run the whole design under a top-level module and trace its ports\n");
+	fprintf(f, "                    each cycle to stdout, instead of generating Verilog\n");
+	fprintf(f, "  --cycles [n]      Number of cycles to simulate  (defaults to the number of stimulus rows)\n");
+	fprintf(f, "  --check-tf [verilog_file]  Check the truth function assigns of a generated Verilog file against their logic,\n");
+	fprintf(f, "                    without reading OASM\n");
 	fprintf(f, "  -w                Warnings become errors\n");
+	fprintf(f, "  --max-diagnostics [n]  Errors and warnings shown of each kind in each module, with a count of the rest  (defaults to 100, 0 for all)\n");
+	fprintf(f, "  --diagnostics-json  Write errors and warnings as JSON lines\n");
+	fprintf(f, "  -d                Deterministic output, without a generation timestamp\n");
+	fprintf(f, "  --write-if-changed  Leave the output file untouched if its contents would not change  (implies -d)\n");
+	fprintf(f, "  -MD               Write a make dependency file for the output, named <verilog_file>.d or <out_dir>/filelist.f.d\n");
+	fprintf(f, "  -MF [dep_file]    Write the make dependency file to dep_file (implies -MD)\n");
+	fprintf(f, "  --trace [trace_file]  Write a timeline of the passes over each module, as Chrome trace JSON\n");
+	fprintf(f, "  --mem-stats       Report memory of signals, connections, modules and other structures after each phase\n");
+	fprintf(f, "  --large-pages     Back the string arena with large pages where the system supports them\n");
 	fprintf(f, "  --debug           Enable debug mode\n");
 }
 
@@ -49,6 +132,23 @@ void PrintVersion(FILE *f)
 	fprintf(f, "oasm2verilog version %s\n", oasm2verilog_version);
 }
 
+// Splits name=value, in place, into an override of a file-scope var
+bool AddVarOverride(vector<VarOverride> &overrides, char *definition)
+{
+	char *equals = strchr(definition, '=');
+	if (!equals || equals == definition || equals[1] == 0)
+		return false;
+
+	*equals = 0;
+
+	VarOverride override;
+	override.Name = definition;
+	override.Value = equals + 1;
+	overrides.push_back(override);
+	return true;
+}
+
+
 int ParseCommandLine(int argc, char *argv[])
 {
 	int i = 1;
@@ -86,18 +186,167 @@ int ParseCommandLine(int argc, char *argv[])
 			generateReport = true;
 		}
 
+		// Latency report
+		else if (strcmp(arg, "--latency") == 0)
+		{
+			reportLatency = true;
+		}
+
+		// Share equivalent definitions
+		else if (strcmp(arg, "-s") == 0)
+		{
+			shareDefinitions = true;
+		}
+
+		// Dead logic elimination
+		else if (strcmp(arg, "--prune-dead") == 0)
+		{
+			pruneDeadLogic = true;
+		}
+
+		// Simulate one ALU
+		else if (strcmp(arg, "--simulate-alu") == 0)
+		{
+			if (i + 2 >= argc) return 0;
+			simulate_alu_name = argv[++i];
+			stimulus_filename = argv[++i];
+		}
+
+		// Simulate a whole design
+		else if (strcmp(arg, "--simulate") == 0)
+		{
+			if (i + 2 >= argc) return 0;
+			simulate_name = argv[++i];
+			stimulus_filename = argv[++i];
+		}
+
+		else if (strcmp(arg, "--cycles") == 0)
+		{
+			i++;
+			if (i >= argc) return 0;
+			simulationCycles = atoi(argv[i]);
+		}
+
+		// Standalone truth function check
+		else if (strcmp(arg, "--check-tf") == 0)
+		{
+			i++;
+			if (i >= argc) return 0;
+			check_tf_filename = argv[i];
+		}
+
 		// Warn as errors
 		else if (strcmp(arg, "-w") == 0)
 		{
 			warnAsError = true;
 		}
 
+		// Errors and warnings shown of each kind in each module
+		else if (strcmp(arg, "--max-diagnostics") == 0)
+		{
+			i++;
+			if (i >= argc) return 0;
+			diagnostics.Limit = atoi(argv[i]);
+			if (diagnostics.Limit < 0) return 0;
+		}
+
+		// Errors and warnings as JSON lines
+		else if (strcmp(arg, "--diagnostics-json") == 0)
+		{
+			diagnostics.Json = true;
+		}
+
+		// Deterministic output
+		else if (strcmp(arg, "-d") == 0)
+		{
+			deterministic = true;
+		}
+
+		// Only replace output file when changed
+		else if (strcmp(arg, "--write-if-changed") == 0)
+		{
+			// A generation time would change the output on every run
+			writeIfChanged = true;
+			deterministic = true;
+		}
+
+		// Dependency file
+		else if (strcmp(arg, "-MD") == 0)
+		{
+			writeDependencies = true;
+		}
+
+		else if (strcmp(arg, "-MF") == 0)
+		{
+			i++;
+			if (i >= argc) return 0;
+			writeDependencies = true;
+			dependency_filename = argv[i];
+		}
+
 		// Enable debugging
 		else if (strcmp(arg, "--debug") == 0)
 		{
 			yydebug = true;
 		}
 
+		// Device description files
+		else if (strcmp(arg, "--device") == 0)
+		{
+			i++;
+			if (i >= argc) return 0;
+			device_filenames.push_back(argv[i]);
+		}
+
+		// Timeline of passes
+		else if (strcmp(arg, "--trace") == 0)
+		{
+			i++;
+			if (i >= argc) return 0;
+			trace_filename = argv[i];
+		}
+
+		// Memory accounting
+		else if (strcmp(arg, "--mem-stats") == 0)
+		{
+			memoryStatistics = true;
+		}
+
+		// Large pages for the string arena
+		else if (strcmp(arg, "--large-pages") == 0)
+		{
+			largePageStrings = true;
+		}
+
+		// File-scope var override
+		else if (strcmp(arg, "-D") == 0)
+		{
+			i++;
+			if (i >= argc) return 0;
+			if (!AddVarOverride(varOverrides, argv[i]))
+			{
+				yyerrorfl(FileLocation(NULL), "Expected -D name=value: %s", argv[i]);
+				return 0;
+			}
+		}
+
+		// Configurations to compile
+		else if (strcmp(arg, "--sweep") == 0)
+		{
+			i++;
+			if (i >= argc) return 0;
+			sweep_filename = argv[i];
+		}
+
+		// Parallel configurations
+		else if (strcmp(arg, "-j") == 0)
+		{
+			i++;
+			if (i >= argc) return 0;
+			sweepJobs = atoi(argv[i]);
+			if (sweepJobs <= 0) return 0;
+		}
+
 		// Output Verilog file
 		else if (strcmp(arg, "-o") == 0)
 		{
@@ -107,6 +356,30 @@ int ParseCommandLine(int argc, char *argv[])
 			output_filename = argv[i];
 		}
 
+		// Output directory, one file per module
+		else if (strcmp(arg, "-O") == 0)
+		{
+			i++;
+			if (i >= argc) return 0;
+			output_dir = argv[i];
+		}
+
+		// Binary netlist file
+		else if (strcmp(arg, "--netlist") == 0)
+		{
+			i++;
+			if (i >= argc) return 0;
+			netlist_filename = argv[i];
+		}
+
+		// Top-level module
+		else if (strcmp(arg, "--top") == 0)
+		{
+			i++;
+			if (i >= argc) return 0;
+			top_module_names.push_back(argv[i]);
+		}
+
 		// Embedded OASM file
 		else if (strcmp(arg, "-l") == 0)
 		{
@@ -137,210 +410,516 @@ int ParseCommandLine(int argc, char *argv[])
 }
 
 
-bool ResolveInstances()
+// Mark the top-level module containing the definition of each instance in a module and its inner modules.
+// Newly reached modules are added to pending, so that their instances are followed in turn.
+void MarkInstancedModules(const Module *module, set<const Module*> &reachable, vector<const Module*> &pending)
 {
-	bool ok = true;
-	for (int i=0; i < modules.Count(); i++)
+	int ninst = module->InstanceCount();
+	for (int i=0; i < ninst; i++)
 	{
-		Module *module = (Module *) modules.Get(i);
-		if (!module->ResolveInstances())
-			ok = false;
+		const Instance *inst = module->GetInstance(i);
+
+		// Definitions are looked up the same way as in ResolveInstances.  Undefined modules are reported there.
+		const Module *definition = inst->Definition ? inst->Definition : module->LookupModule(inst->DefinitionName);
+		if (definition)
+		{
+			while (definition->ParentModule())
+				definition = definition->ParentModule();
+
+			if (reachable.insert(definition).second)
+				pending.push_back(definition);
+		}
+	}
+
+	int nmodules = module->InnerModuleCount();
+	for (int i=0; i < nmodules; i++)
+	{
+		const Module *innerModule = module->GetInnerModule(i);
+		if (innerModule)
+			MarkInstancedModules(innerModule, reachable, pending);
 	}
-	return ok;
 }
 
 
-bool ResolveConnections()
+// Discard all top-level modules which cannot be reached through instances from the --top modules,
+// so that later passes and generation only process the needed hierarchy
+bool PruneUnreachableModules()
 {
+	set<const Module*> reachable;
+	vector<const Module*> pending;
+
 	bool ok = true;
-	for (int i=0; i < modules.Count(); i++)
+	for (int i=0; i < (int) top_module_names.size(); i++)
 	{
-		Module *module = (Module *) modules.Get(i);
-		if (!module->ResolveConnections())
+		const Module *top = (const Module *) modules.Get(top_module_names[i]);
+		if (!top)
+		{
+			yyerrorfl(FileLocation(NULL), "Top-level module not found: %s", top_module_names[i]);
 			ok = false;
+		}
+		else if (reachable.insert(top).second)
+		{
+			pending.push_back(top);
+		}
 	}
-	return ok;
-}
 
+	if (!ok)
+		return false;
 
-void DeleteModules()
-{
+	while (!pending.empty())
+	{
+		const Module *module = pending.back();
+		pending.pop_back();
+		MarkInstancedModules(module, reachable, pending);
+	}
+
+	// Collect before removing, because removal changes module indexes
+	vector<Module*> unreachable;
 	for (int i=0; i < modules.Count(); i++)
 	{
 		Module *module = (Module *) modules.Get(i);
-		delete module;  module = NULL;
+		if (reachable.find(module) == reachable.end())
+			unreachable.push_back(module);
+	}
+
+	if (yydebug)
+		printf("Unreachable modules discarded: %d of %d\n", (int) unreachable.size(), modules.Count());
+
+	for (int i=0; i < (int) unreachable.size(); i++)
+	{
+		Module *module = unreachable[i];
+		modules.Remove(module->Name());
+		delete module;
 	}
-	//FIXME clear out modules collection
+
+	return true;
 }
 
 
-void GenerateReport(FILE *f)
+// Report memory by category at the end of a phase, with --mem-stats
+void ReportMemory(const char *phase)
 {
-	fprintf(f, "== %d module(s) defined ==\n", modules.Count());
-	for (int i=0; i < modules.Count(); i++)
+	if (memoryStatistics)
+		PrintAllocationStatistics(stderr, phase);
+}
+
+
+// Write a filename for a make rule, escaping characters which are special to make
+void WriteMakeFilename(FILE *f, const char *filename)
+{
+	for (const char *p = filename; *p; p++)
 	{
-		Module *module = (Module *) modules.Get(i);
-		module->Print(f);
+		if (*p == ' ' || *p == '\t' || *p == '#' || *p == ':' || *p == '\\')
+			fputc('\\', f);
+		else if (*p == '$')
+			fputc('$', f);
+		fputc(*p, f);
 	}
-	fprintf(f, "== %d module(s) defined ==\n", modules.Count());
 }
 
 
-// Generate Verilog into the output file provided
-void GenerateVerilog(FILE *f, bool generateEmbeddedOasmSection)
+// Write a make-format dependency file, listing every parsed file and device description as a prerequisite of the output.
+// Each prerequisite also gets an empty rule, so make does not fail when a file is removed.
+// The file is written to a temporary name first, then moved into place if it changed.
+bool WriteDependencyFile(const char *filename, const char *target)
 {
-	// Start with a boilerplate header
-	Module::GenerateVerilogHeader(f);
+	FILE *f = OpenFileIfChanged(filename);
+	if (!f)
+		return false;
 
-	int n = modules.Count();
+	int n = parsedFilenames.size();
 
-	// Generate embedded OASM section in hot comments at the top of the file
-	// These should only be generated for inner modules
-	if (generateEmbeddedOasmSection)
+	WriteMakeFilename(f, target);
+	fprintf(f, ":");
+	for (int i=0; i < n; i++)
 	{
-		fprintf(f, "//+++EMBEDDED_OASM+++\n");
-		for (int i=0; i < n; i++)
-		{
-			Module *module = (Module *) modules.Get(i);
-
-			// Skip extern modules
-			if (!module->IsExtern())
-			{
-				module->GenerateVerilogEmbeddedExtern(f, true);
-			}
-		}
-		fprintf(f, "//+++END_EMBEDDED_OASM+++\n");
-		fprintf(f, "\n");
+		fprintf(f, " \\\n  ");
+		WriteMakeFilename(f, parsedFilenames[i]);
 	}
+	fprintf(f, "\n");
 
-	// Generate Verilog for each non-extern top-level module
-	// Each module will generate its inner modules
 	for (int i=0; i < n; i++)
 	{
-		Module *module = (Module *) modules.Get(i);
-
-		// Skip extern modules
-		if (!module->IsExtern())
-		{
-			module->GenerateVerilog(f);
-		}
+		fprintf(f, "\n");
+		WriteMakeFilename(f, parsedFilenames[i]);
+		fprintf(f, ":\n");
 	}
+
+	bool changed;
+	return CloseFileIfChanged(f, changed);
 }
 
 
-// Main Entry Point
-int main(int argc, char *argv[])
+// Find a module by name, using dotted names such as Outer.Inner for inner modules
+const Module *FindModule(const char *name)
 {
-	if (!ParseCommandLine(argc, argv))
+	string path = name;
+	size_t dot = path.find('.');
+	const Module *module = (const Module *) modules.Get(path.substr(0, dot).c_str());
+
+	while (module && dot != string::npos)
 	{
-		Usage(stderr);
-		return 1;
+		size_t start = dot + 1;
+		dot = path.find('.', start);
+		module = module->GetInnerModule(path.substr(start, dot == string::npos ? string::npos : dot - start).c_str());
 	}
 
-	if (printHelp)
+	return module;
+}
+
+
+// Runs the program of one ALU with inputs from a stimulus file, tracing each cycle to stdout
+bool SimulateAlu(const char *name, const char *filename)
+{
+	const Alu *alu = dynamic_cast<const Alu *>(FindModule(name));
+	if (!alu)
 	{
-		Usage(stdout);
-		return 0;
+		yyerrorfl(FileLocation(NULL), "ALU not found: %s", name);
+		return false;
 	}
 
-	if (printVersion)
+	Stimulus stimulus;
+	if (!stimulus.Read(filename))
+		return false;
+
+	int cycles = simulationCycles > 0 ? simulationCycles : stimulus.Rows();
+
+	AluSimulator simulator(alu);
+	clock_t start = clock();
+	if (!simulator.Run(stimulus, cycles, stdout))
+		return false;
+
+	if (yydebug)
 	{
-		PrintVersion(stdout);
-		return 0;
+		double seconds = (double) (clock() - start) / CLOCKS_PER_SEC;
+		printf("Simulated %d cycles in %.3f seconds\n", cycles, seconds);
 	}
 
-	if (input_filenames.size() == 0)
+	return true;
+}
+
+
+// Runs the whole design under a top-level module with inputs from a stimulus file, tracing its ports each cycle to stdout
+bool SimulateDesign(const char *name, const char *filename)
+{
+	const Module *top = FindModule(name);
+	if (!top)
 	{
-		Usage(stderr);
-		return 1;
+		yyerrorfl(FileLocation(NULL), "Module not found: %s", name);
+		return false;
 	}
 
+	Stimulus stimulus;
+	if (!stimulus.Read(filename))
+		return false;
 
-	// Initialize parser
-	InitParser();
+	int cycles = simulationCycles > 0 ? simulationCycles : stimulus.Rows();
 
-	bool ok = true;
+	DesignSimulator simulator(top);
+	clock_t start = clock();
+	if (!simulator.Run(stimulus, cycles, stdout))
+		return false;
 
-	// Parse each input file from command-line in turn
-	for (int i=0; i < (int) input_filenames.size(); i++)
+	if (yydebug)
 	{
-		const char *input_filename = input_filenames[i];
-		ParseMode input_file_mode = input_file_modes[i];
-
-		FILE *input_file;
-		if (strcmp(input_filename, "-") == 0)
-		{
-			// - means use STDIN
-			input_file = stdin;
-			input_filename = NULL;
-		}
-		else
-		{
-			// open filename
-			input_file = fopen(input_filename, "r");
-			if (!input_file)
-			{
-				fprintf(stderr, "ERROR - Cannot open input file: %s\n", input_filename);
-				ok = false;
-				break;
-			}
-		}
+		double seconds = (double) (clock() - start) / CLOCKS_PER_SEC;
+		printf("Simulated %d cycles in %.3f seconds\n", cycles, seconds);
+	}
 
-		// Call the parser.  Returns 0 if ok, 1 if a parse error occurred, and 2 if a fatal error occurred
-		// Exit immediately if err is 2
-		int err = ParseFile(input_file, input_filename, input_file_mode);
-		if (err == 2)
-			exit(1);
+	return true;
+}
 
-		// Close explicitly opened files
-		if (input_filename)
-			fclose(input_file);
 
-		// Check for errors and stop parsing other files if an error occurred
-		if (errorCount > 0)
-		{
-			ok = false;
-			break;
-		}
+void GenerateReport(FILE *f)
+{
+	fprintf(f, "== %d module(s) defined ==\n", modules.Count());
+	for (int i=0; i < modules.Count(); i++)
+	{
+		Module *module = (Module *) modules.Get(i);
+		module->Print(f);
 	}
+	fprintf(f, "== %d module(s) defined ==\n", modules.Count());
+}
 
 
-	// Perform additional passes after parsing all input files
-	if (ok)
+// Open an output file.  With --write-if-changed, a temporary file next to it is written instead, and hashed as it is written.
+FILE *OpenOutputFile(const char *filename)
+{
+	FILE *f = writeIfChanged ? OpenFileIfChanged(filename) : OpenFile(filename, "w");
+	if (!f)
+		yyerrorfl(FileLocation(filename), "Cannot open output file");
+
+	return f;
+}
+
+
+// Close a file from OpenOutputFile.  With --write-if-changed, the file is only replaced when its contents changed.
+bool CloseOutputFile(FILE *f, const char *filename)
+{
+	// Closing waits for any compression to finish
+	bool ok;
+	if (writeIfChanged)
 	{
-		ok = ResolveInstances();
+		bool changed = true;
+		ok = CloseFileIfChanged(f, changed);
+		if (ok && yydebug && !changed)
+			printf("Output file unchanged: %s\n", filename);
 	}
-
-	if (ok)
+	else
 	{
-		ok = ResolveConnections();
+		ok = CloseFile(f);
 	}
 
+	if (!ok)
+		yyerrorfl(FileLocation(filename), "Cannot write output file");
 
-	// Report warnings
-	if (warnCount > 0)
-	{
-		if (warnCount == 1)
-			fprintf(stderr, "%d warning occurred\n", warnCount);
-		else
-			fprintf(stderr, "%d warnings occurred\n", warnCount);
-	}
+	return ok;
+}
 
-	// Report errors
-	if (errorCount > 0)
+
+// Writes each generated module file into a directory, recording the names written
+class DirectorySink : public OutputSink
+{
+public:
+	DirectorySink(const string &dir) : dir(dir) {}
+
+	virtual bool Write(const char *name, const char *data, size_t length)
 	{
-		ok = false;
-		if (errorCount == 1)
-			fprintf(stderr, "%d error occurred\n", errorCount);
-		else
-			fprintf(stderr, "%d errors occurred\n", errorCount);
+		string filename = dir + "/" + name;
+
+		FILE *f = OpenOutputFile(filename.c_str());
+		if (!f)
+			return false;
+
+		bool ok = (fwrite(data, 1, length, f) == length);
+		if (!CloseOutputFile(f, filename.c_str()) || !ok)
+			return false;
+
+		Filenames.push_back(filename);
+		return true;
 	}
 
+	vector<string> Filenames;
 
-	// Generate a simple report of all parsed modules.
-	if (generateReport)
+private:
+	string dir;
+};
+
+
+// Generate Verilog into a directory, with one file per module, a filelist of all module files,
+// and an interface file carrying the embedded OASM section, which can be read back with -l.
+// None of them carries a generation time, so that only the files of changed modules change.
+// Returns the filelist name through filelist.
+bool GenerateVerilogFiles(const char *dirname, string &filelist)
+{
+	string dir = dirname;
+
+	// Create the directory if it does not already exist
+	struct stat st;
+	if (stat(dirname, &st) != 0 && mkdir(dirname, 0777) != 0)
 	{
-		GenerateReport(stdout);
+		yyerrorfl(FileLocation(dirname), "Cannot create output directory");
+		return false;
+	}
+
+	DirectorySink sink(dir);
+	bool ok = GenerateVerilogModuleFiles(sink);
+	const vector<string> &filenames = sink.Filenames;
+
+	// Interface file
+	if (!noEmbeddedOasm)
+	{
+		string filename = dir + "/interface.v";
+		FILE *f = OpenOutputFile(filename.c_str());
+		if (!f)
+			return false;
+
+		Module::GenerateVerilogHeader(f, false);
+		GenerateVerilogEmbeddedOasm(f);
+
+		if (!CloseOutputFile(f, filename.c_str()))
+			ok = false;
+	}
+
+	// Filelist, one module file per line
+	filelist = dir + "/filelist.f";
+	FILE *f = OpenOutputFile(filelist.c_str());
+	if (!f)
+		return false;
+
+	for (int i=0; i < (int) filenames.size(); i++)
+		fprintf(f, "%s\n", filenames[i].c_str());
+
+	if (!CloseOutputFile(f, filelist.c_str()))
+		ok = false;
+
+	return ok;
+}
+
+
+// Report the number of warnings and errors.  Returns false if any error occurred.
+bool ReportDiagnosticCounts()
+{
+	diagnostics.Flush(stderr);
+
+	// Report warnings
+	if (warnCount > 0)
+	{
+		if (warnCount == 1)
+			fprintf(stderr, "%d warning occurred\n", warnCount);
+		else
+			fprintf(stderr, "%d warnings occurred\n", warnCount);
+	}
+
+	// Report errors
+	if (errorCount > 0)
+	{
+		if (errorCount == 1)
+			fprintf(stderr, "%d error occurred\n", errorCount);
+		else
+			fprintf(stderr, "%d errors occurred\n", errorCount);
+	}
+
+	return errorCount == 0;
+}
+
+
+// Parse one input file from the command-line.  Returns false if it cannot be read or has errors.
+bool ParseInputFile(int i)
+{
+	const char *input_filename = input_filenames[i];
+	ParseMode input_file_mode = input_file_modes[i];
+
+	FILE *input_file;
+	if (strcmp(input_filename, "-") == 0)
+	{
+		// - means use STDIN
+		input_file = stdin;
+		input_filename = NULL;
+	}
+	else
+	{
+		// open filename, decompressing if needed
+		input_file = OpenFile(input_filename, "r");
+		if (!input_file)
+		{
+			yyerrorfl(FileLocation(input_filename), "Cannot open input file");
+			return false;
+		}
+	}
+
+	// Call the parser.  Returns 0 if ok, 1 if a parse error occurred, and 2 if a fatal error occurred
+	// Exit immediately if err is 2
+	int err = ParseFile(input_file, input_filename, input_file_mode);
+	if (err == 2)
+	{
+		diagnostics.Flush(stderr);
+		exit(1);
+	}
+
+	// Close explicitly opened files
+	// A decompression failure is only reported if the parse itself succeeded
+	if (input_filename)
+	{
+		if (!CloseFile(input_file) && err == 0)
+		{
+			yyerrorfl(FileLocation(input_filename), "Cannot read input file");
+			return false;
+		}
+	}
+
+	// Check for errors, so that other files are not parsed after an error
+	return errorCount == 0;
+}
+
+
+// Resolve, optimize and report on the parsed design, then simulate it or generate Verilog.
+// ok is the result of parsing, and the passes after parsing are skipped when it is false.
+bool CompileDesign(bool ok)
+{
+	// Perform additional passes after parsing all input files
+	if (ok && top_module_names.size() > 0)
+	{
+		ok = PruneUnreachableModules();
+	}
+
+	if (ok)
+	{
+		ok = ResolveInstances();
+		ReportMemory("ResolveInstances");
+	}
+
+	if (ok)
+	{
+		ok = ResolveConnections();
+		ReportMemory("ResolveConnections");
+	}
+
+	// Optionally remove logic which cannot affect any output, before generation
+	if (ok && pruneDeadLogic && !parseOnly)
+	{
+		DeadLogicEliminator eliminator;
+		eliminator.Run(modules, stderr);
+
+		for (int i=0; i < (int) eliminator.Removals.size(); i++)
+		{
+			const DeadLogicRemoval &removal = eliminator.Removals[i];
+			fprintf(stderr, "Removed from module '%s': %d wire(s), %d delay(s), %d port(s), %d connection(s)\n",
+				removal.Module.c_str(), removal.Wires, removal.Delays, removal.Ports, removal.Connections);
+		}
+
+		int removed = eliminator.RemovedWires + eliminator.RemovedDelays + eliminator.RemovedPorts + eliminator.RemovedConnections;
+		if (removed > 0)
+		{
+			fprintf(stderr, "Removed dead logic: %d wire(s), %d delay(s), %d port(s), %d connection(s)\n",
+				eliminator.RemovedWires, eliminator.RemovedDelays, eliminator.RemovedPorts, eliminator.RemovedConnections);
+		}
+		ReportMemory("dead logic removal");
+	}
+
+	// Share delay taps of each signal in a single chain, after any dead taps have been removed
+	if (ok && !parseOnly)
+	{
+		BuildDelayChains();
+		ReportMemory("BuildDelayChains");
+	}
+
+	// Optionally share one Verilog module between structurally identical definitions
+	if (ok && shareDefinitions && !parseOnly)
+	{
+		int nshared = ShareEquivalentDefinitions();
+		if (yydebug)
+			printf("Shared module definitions: %d\n", nshared);
+		ReportMemory("ShareEquivalentDefinitions");
+	}
+
+
+	// Report warnings and errors
+	if (!ReportDiagnosticCounts())
+		ok = false;
+
+
+	// Generate a simple report of all parsed modules.
+	if (generateReport)
+	{
+		GenerateReport(stdout);
+	}
+
+	// Report port-to-port latencies of the resolved design
+	if (ok && reportLatency)
+	{
+		LatencyAnalyzer analyzer;
+		analyzer.Report(stdout, modules);
+	}
+
+	// Simulation replaces Verilog generation
+	if (ok && simulate_alu_name)
+	{
+		ok = SimulateAlu(simulate_alu_name, stimulus_filename);
+	}
+	else if (ok && simulate_name)
+	{
+		ok = SimulateDesign(simulate_name, stimulus_filename);
 	}
 
 	if (yydebug)
@@ -350,31 +929,505 @@ int main(int argc, char *argv[])
 	}
 
 	// Produce Verilog output if no errors, and if parseOnly (-p) is not set
-	if (ok && !parseOnly)
+	if (ok && !parseOnly && !simulate_alu_name && !simulate_name)
 	{
-		if (!output_filename)
+		// Name of the generated file which is the target of the dependency file
+		string target;
+
+		if (output_dir)
+		{
+			// One file per module, written to a directory
+			if (!GenerateVerilogFiles(output_dir, target))
+				ok = false;
+		}
+		else if (!output_filename)
 		{
 			output_file = stdout;
+
+			// When -n switch is set, do not generate embedded OASM into Verilog
+			GenerateVerilog(output_file, !noEmbeddedOasm, !deterministic);
 		}
 		else
 		{
-			output_file = fopen(output_filename, "w");
+			output_file = OpenOutputFile(output_filename);
 			if (!output_file)
+				return false;
+
+			// When -n switch is set, do not generate embedded OASM into Verilog
+			GenerateVerilog(output_file, !noEmbeddedOasm, !deterministic);
+
+			if (!CloseOutputFile(output_file, output_filename))
+				ok = false;
+
+			target = output_filename;
+		}
+
+		// Binary netlist, alongside the Verilog
+		if (ok && netlist_filename)
+		{
+			FILE *f = OpenOutputFile(netlist_filename);
+			if (!f)
+				return false;
+
+			NetlistWriter writer;
+			bool written = writer.Write(f, modules);
+			if (!CloseOutputFile(f, netlist_filename) || !written)
+				ok = false;
+		}
+
+		// Dependency file, written only when the output was generated successfully
+		if (ok && writeDependencies)
+		{
+			string filename = dependency_filename ? dependency_filename : target + ".d";
+			if (!WriteDependencyFile(filename.c_str(), target.c_str()))
+			{
+				yyerrorfl(FileLocation(filename.c_str()), "Cannot write dependency file");
+				ok = false;
+			}
+		}
+
+		ReportMemory("Verilog generation");
+	}
+
+	return ok;
+}
+
+
+// Reads the configurations of a sweep file.  Each line names a configuration and lists its overrides,
+// as "<config> name=value ...".  Values in double quotes may contain spaces, and # starts a comment.
+bool ReadSweepFile(const char *filename)
+{
+	FILE *f = OpenFile(filename, "r");
+	if (!f)
+	{
+		yyerrorfl(FileLocation(filename), "Cannot open sweep file");
+		return false;
+	}
+
+	bool ok = true;
+	set<string> names;
+	char *buffer = NULL;
+	size_t size = 0;
+	int line = 0;
+
+	while (getline(&buffer, &size, f) >= 0)
+	{
+		line++;
+
+		// Tokens are kept for the life of the program, as the names and values of overrides
+		char *text = strdup(buffer);
+		vector<char *> tokens;
+		char *p = text;
+		while (*p)
+		{
+			while (*p && isspace(*p))
+				p++;
+			if (*p == 0 || *p == '#')
+				break;
+
+			char *token = p;
+			bool quoted = false;
+			while (*p && (quoted || !isspace(*p)))
+			{
+				if (*p == '"')
+					quoted = !quoted;
+				p++;
+			}
+			if (*p)
+				*p++ = 0;
+
+			tokens.push_back(token);
+		}
+
+		if (tokens.empty())
+		{
+			free(text);
+			continue;
+		}
+
+		SweepConfiguration config;
+		config.Name = tokens[0];
+
+		// Names become part of output filenames
+		bool validName = (config.Name[0] != '.');
+		for (const char *c = config.Name; *c; c++)
+		{
+			if (!isalnum(*c) && *c != '_' && *c != '-' && *c != '.')
+				validName = false;
+		}
+
+		SourceCodeLocation loc;
+		loc.Filename = filename;
+		loc.Line = line;
+
+		if (!validName)
+		{
+			yyerrorfl(loc, "Invalid configuration name: %s", config.Name);
+			ok = false;
+		}
+		else if (!names.insert(config.Name).second)
+		{
+			yyerrorfl(loc, "Configuration '%s' repeated", config.Name);
+			ok = false;
+		}
+
+		for (int i=1; i < (int) tokens.size(); i++)
+		{
+			if (!AddVarOverride(config.Overrides, tokens[i]))
+			{
+				yyerrorfl(loc, "Expected name=value: %s", tokens[i]);
+				ok = false;
+			}
+		}
+
+		sweep_configurations.push_back(config);
+	}
+
+	free(buffer);
+
+	if (!CloseFile(f))
+	{
+		yyerrorfl(FileLocation(filename), "Cannot read sweep file");
+		ok = false;
+	}
+	else if (ok && sweep_configurations.empty())
+	{
+		yyerrorfl(FileLocation(filename), "No configurations in sweep file");
+		ok = false;
+	}
+
+	return ok;
+}
+
+
+// Adds a configuration name to an output filename, before its extensions, so out.v.gz becomes out.<config>.v.gz
+string SweepOutputFilename(const char *filename, const char *config)
+{
+	string name = filename;
+	size_t base = name.rfind('/');
+	base = (base == string::npos) ? 0 : base + 1;
+
+	// A leading dot names a hidden file, rather than starting an extension
+	size_t dot = name.find('.', base + 1);
+	if (dot == string::npos)
+		return name + "." + config;
+
+	return name.substr(0, dot) + "." + config + name.substr(dot);
+}
+
+
+// Compile one sweep configuration, in a child process holding a copy of everything parsed so far.
+// Only files declaring a var which the configuration overrides are parsed again, replacing their modules.
+bool CompileSweepConfiguration(const SweepConfiguration &config, const vector< vector<const char *> > &fileVars, const vector< vector<Module *> > &fileModules)
+{
+	// Warnings of the shared parse were already reported
+	warnCount = 0;
+
+	varOverrides.insert(varOverrides.end(), config.Overrides.begin(), config.Overrides.end());
+
+	int nfiles = input_filenames.size();
+	vector<bool> reparse(nfiles, false);
+	for (int i=0; i < nfiles; i++)
+	{
+		for (int j=0; j < (int) fileVars[i].size(); j++)
+		{
+			for (int k=0; k < (int) config.Overrides.size(); k++)
+			{
+				if (strcmp(fileVars[i][j], config.Overrides[k].Name) == 0)
+					reparse[i] = true;
+			}
+		}
+
+		if (reparse[i])
+		{
+			for (int j=0; j < (int) fileModules[i].size(); j++)
+			{
+				Module *module = fileModules[i][j];
+				modules.Remove(module->Name());
+				delete module;
+			}
+		}
+	}
+
+	// Files parsed again are already listed for dependency output
+	vector<const char *> filenames = parsedFilenames;
+
+	bool ok = true;
+	for (int i=0; ok && i < nfiles; i++)
+	{
+		if (reparse[i])
+			ok = ParseInputFile(i);
+	}
+
+	parsedFilenames = filenames;
+
+	// Each configuration has its own output
+	string outputName;
+	if (output_dir)
+	{
+		outputName = string(output_dir) + "/" + config.Name;
+		output_dir = (char *) outputName.c_str();
+	}
+	else if (output_filename)
+	{
+		outputName = SweepOutputFilename(output_filename, config.Name);
+		output_filename = (char *) outputName.c_str();
+	}
+
+	string netlistName;
+	if (netlist_filename)
+	{
+		netlistName = SweepOutputFilename(netlist_filename, config.Name);
+		netlist_filename = (char *) netlistName.c_str();
+	}
+
+	if (yydebug)
+		printf("Configuration '%s': %d of %d file(s) parsed again\n", config.Name, (int) count(reparse.begin(), reparse.end(), true), nfiles);
+
+	return CompileDesign(ok);
+}
+
+
+// Compile every sweep configuration, each in a process of its own, running up to sweepJobs at once
+bool RunSweep(const vector< vector<const char *> > &fileVars, const vector< vector<Module *> > &fileModules)
+{
+	int jobs = sweepJobs > 0 ? sweepJobs : (int) sysconf(_SC_NPROCESSORS_ONLN);
+	if (jobs < 1)
+		jobs = 1;
+
+	bool ok = true;
+	map<pid_t, const char *> running;
+	int n = sweep_configurations.size();
+	int next = 0;
+
+	while (next < n || !running.empty())
+	{
+		if (next < n && (int) running.size() < jobs)
+		{
+			const SweepConfiguration &config = sweep_configurations[next++];
+
+			// Output buffered so far must not be written again by the child
+			fflush(stdout);
+			fflush(stderr);
+
+			pid_t pid = fork();
+			if (pid == 0)
+			{
+				bool configOk = CompileSweepConfiguration(config, fileVars, fileModules);
+				diagnostics.Flush(stderr);
+				fflush(NULL);
+				_exit(configOk ? 0 : 1);
+			}
+
+			if (pid < 0)
+			{
+				yyerrorfl(FileLocation(NULL), "Cannot start configuration: %s", config.Name);
+				ok = false;
+				next = n;
+			}
+			else
+			{
+				running[pid] = config.Name;
+			}
+			continue;
+		}
+
+		int status = 0;
+		pid_t pid = wait(&status);
+		if (pid < 0)
+			break;
+
+		map<pid_t, const char *>::iterator iter = running.find(pid);
+		if (iter == running.end())
+			continue;
+
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+		{
+			yyerrorfl(FileLocation(NULL), "Configuration '%s' failed", iter->second);
+			ok = false;
+		}
+		running.erase(iter);
+	}
+
+	return ok;
+}
+
+
+// Report command-line overrides which name no file-scope var of any file.  Returns false when warnings are errors.
+bool CheckOverridesUsed(const vector< vector<const char *> > &fileVars)
+{
+	set<string> declared;
+	for (int i=0; i < (int) fileVars.size(); i++)
+		declared.insert(fileVars[i].begin(), fileVars[i].end());
+
+	vector<string> unused;
+	for (int i=0; i < (int) varOverrides.size(); i++)
+	{
+		if (declared.find(varOverrides[i].Name) == declared.end())
+			unused.push_back(string("-D ") + varOverrides[i].Name);
+	}
+	for (int i=0; i < (int) sweep_configurations.size(); i++)
+	{
+		const SweepConfiguration &config = sweep_configurations[i];
+		for (int j=0; j < (int) config.Overrides.size(); j++)
+		{
+			if (declared.find(config.Overrides[j].Name) == declared.end())
+				unused.push_back(string("Configuration '") + config.Name + "' override of " + config.Overrides[j].Name);
+		}
+	}
+
+	// Reported as warnings, which -w makes errors
+	for (int i=0; i < (int) unused.size(); i++)
+		yywarnfl(FileLocation(NULL), "%s does not match any file-scope var", unused[i].c_str());
+
+	return warnAsError ? unused.empty() : true;
+}
+
+
+// Main Entry Point
+int main(int argc, char *argv[])
+{
+	if (!ParseCommandLine(argc, argv))
+	{
+		Usage(stderr);
+		return 1;
+	}
+
+	if (printHelp)
+	{
+		Usage(stdout);
+		return 0;
+	}
+
+	if (printVersion)
+	{
+		PrintVersion(stdout);
+		return 0;
+	}
+
+	// Checking a generated file does not read any OASM
+	if (check_tf_filename)
+	{
+		return CheckVerilogTruthFunctions(check_tf_filename) ? 0 : 1;
+	}
+
+	if (input_filenames.size() == 0)
+	{
+		Usage(stderr);
+		return 1;
+	}
+
+	// Output goes either to a single file or to a directory
+	if (output_filename && output_dir)
+	{
+		yyerrorfl(FileLocation(NULL), "Options -o and -O cannot be used together");
+		return 1;
+	}
+
+	// A dependency file names the output file, or the filelist of an output directory, as its target
+	if (writeDependencies && !output_filename && !output_dir)
+	{
+		yyerrorfl(FileLocation(NULL), "Dependency output requires an output file (-o) or directory (-O)");
+		return 1;
+	}
+
+	// Each sweep configuration writes its own output, so outputs shared by all configurations are not allowed
+	if (sweep_filename)
+	{
+		if (!output_filename && !output_dir && !parseOnly)
+		{
+			yyerrorfl(FileLocation(NULL), "Option --sweep requires an output file (-o) or directory (-O)");
+			return 1;
+		}
+
+		if (simulate_alu_name || simulate_name || trace_filename || dependency_filename)
+		{
+			yyerrorfl(FileLocation(NULL), "Option --sweep cannot be used with --simulate, --simulate-alu, --trace or -MF");
+			return 1;
+		}
+
+		for (int i=0; i < (int) input_filenames.size(); i++)
+		{
+			if (strcmp(input_filenames[i], "-") == 0)
 			{
-				fprintf(stderr, "ERROR - Cannot open output file: %s\n", output_filename);
+				yyerrorfl(FileLocation(NULL), "Option --sweep cannot read standard input, which it may need to parse again");
 				return 1;
 			}
 		}
 
-		// When -n switch is set, do not generate embedded OASM into Verilog
-		GenerateVerilog(output_file, !noEmbeddedOasm);
+		if (!ReadSweepFile(sweep_filename))
+			return 1;
+
+		// Configuration directories are created inside the output directory
+		struct stat st;
+		if (output_dir && stat(output_dir, &st) != 0 && mkdir(output_dir, 0777) != 0)
+		{
+			yyerrorfl(FileLocation(output_dir), "Cannot create output directory");
+			return 1;
+		}
+	}
+
+
+	if (trace_filename)
+		EnableTrace();
+
+	// Diagnostics are held until the end of each phase, from parsing on
+	diagnostics.Install();
+
+	// Initialize parser
+	InitParser();
+	strings->UseLargePages(largePageStrings);
+
+	bool ok = true;
+
+	// Index silicon objects of the device description files, before any OASM refers to them
+	for (int i=0; i < (int) device_filenames.size(); i++)
+	{
+		if (!LoadDeviceDescription(device_filenames[i]))
+			ok = false;
+	}
+
+	// Parse each input file from command-line in turn, noting the file-scope vars and modules of each for --sweep
+	int nfiles = input_filenames.size();
+	vector< vector<const char *> > fileVars(nfiles);
+	vector< vector<Module *> > fileModules(nfiles);
+
+	for (int i=0; ok && i < nfiles; i++)
+	{
+		int firstModule = parsedModules.size();
+		ok = ParseInputFile(i);
+
+		fileVars[i] = fileScopeVars;
+		fileModules[i].assign(parsedModules.begin() + firstModule, parsedModules.end());
+	}
+
+	ReportMemory("parse");
+
+	if (ok)
+		ok = CheckOverridesUsed(fileVars);
+
+	if (sweep_filename)
+	{
+		// Each configuration is compiled from a copy of the parsed design
+		if (!ReportDiagnosticCounts())
+			ok = false;
+		if (ok)
+			ok = RunSweep(fileVars, fileModules);
+	}
+	else
+	{
+		ok = CompileDesign(ok);
 	}
 
+	if (yydebug)
+		strings->PrintStatistics(stdout);
+
 	// Clean up all module data structures
 	DeleteModules();
 
 	// Clean up all parser data structures, including global string buffer
 	CleanupParser();
+	ReportMemory("cleanup");
 
 	if (yydebug)
 	{
@@ -382,6 +1435,17 @@ int main(int argc, char *argv[])
 		printf("ExpressionArray::TotalRefCount after cleanup: %d\n", ExpressionArray::TotalRefCount);
 	}
 
+	// Diagnostics of generation and simulation
+	diagnostics.Flush(stderr);
+	diagnostics.Uninstall();
+
+	// Timeline is written last, after all traced passes
+	if (trace_filename && !WriteTrace(trace_filename))
+	{
+		yyerrorfl(FileLocation(trace_filename), "Cannot write trace file");
+		ok = false;
+	}
+
 	// Return 0 if ok
 	return ok ? 0 : 1;
 }
@@ -1,6 +1,7 @@
 
 %{
 #include "parser.h"
+#include "SiliconObjectRegistry.h"
 %}
 
 /* Parser options */
@@ -88,20 +89,17 @@ common_stmt		: ';'	/* empty statement */
 
 
 var_decl		: _VAR_ _ID_ '=' expr ';'	{	/* Variable definition */
-								if (!symbols->AddVariable($2, $4))
-									yyerrorf("Variable '%s' already defined", $2);
+								addVariable($2, overrideVar($2, $4));
 								$4.Delete();
 							}
 
 			| _VAR_ _ID_ ';'		{	/* Variable declaration with undefined initial value */
-								if (!symbols->AddVariable($2, Expression::Unknown()))
-									yyerrorf("Variable '%s' already defined", $2);
+								addVariable($2, overrideVar($2, Expression::Unknown()));
 							}
 
 			| _VAR_ _ID_ '[' ']' ';'	{	/* Variable declaration for zero-sized array */
 								Expression array = Expression::Array();
-								if (!symbols->AddVariable($2, array))
-									yyerrorf("Variable '%s' already defined", $2);
+								addVariable($2, overrideVar($2, array));
 								array.Delete();
 							}
 
@@ -116,8 +114,7 @@ var_decl		: _VAR_ _ID_ '=' expr ';'	{	/* Variable definition */
 
 								/* Even though errors may have been reported, add the variable, to prevent further errors */
 								Expression array = Expression::Array(sz);
-								if (!symbols->AddVariable($2, array))
-									yyerrorf("Variable '%s' already defined", $2);
+								addVariable($2, overrideVar($2, array));
 
 								array.Delete();
 								$4.Delete();
@@ -131,8 +128,7 @@ var_decl		: _VAR_ _ID_ '=' expr ';'	{	/* Variable definition */
 								}
 
 								/* Even though errors may have been reported, add the variable, to prevent further errors */
-								if (!symbols->AddVariable($2, $6))
-									yyerrorf("Variable '%s' already defined", $2);
+								addVariable($2, overrideVar($2, $6));
 
 								$6.Delete();
 							}
@@ -155,8 +151,7 @@ var_decl		: _VAR_ _ID_ '=' expr ';'	{	/* Variable definition */
 								}
 
 								/* Even though errors may have been reported, add the variable, to prevent further errors */
-								if (!symbols->AddVariable($2, $7))
-									yyerrorf("Variable '%s' already defined", $2);
+								addVariable($2, overrideVar($2, $7));
 
 								$4.Delete();
 								$7.Delete();
@@ -819,6 +814,11 @@ expr	: fcn_call
 
 	| _ID_						{	/* Symbol */
 								Symbol *s = symbols->Get($1);
+
+								/* Enumerated values of silicon objects which have not been used yet */
+								if (!s)
+									s = LookupEnumValue($1);
+
 								if (!s)
 								{
 									$$.type = EXPRESSION_UNKNOWN;
@@ -3,6 +3,7 @@
 #include "SiliconObjectRegistry.h"
 #include "BuiltinFunction.h"
 #include "IllegalNames.h"
+#include "Trace.h"
 #include <typeinfo>
 
 void InitParser()
@@ -43,27 +44,52 @@ void CleanupParser()
 
 int ParseFile(FILE *file, const char *fname, ParseMode mode)
 {
+	TraceSpan span("ParseFile", fname);
+
 	// Add filename to string buffer and set global variable that points to it
 	if (fname)
+	{
 		currentFilename = strings->AddString(fname);
+		parsedFilenames.push_back(currentFilename);
+	}
 	else
+	{
 		currentFilename = NULL;
+	}
 
-	// Open file
+	// Open file, counting lines from the start of it.
+	// Restarting the lexer drops any input left buffered by a parse error in an earlier file.
 	yyin = file;
+	yyrestart(file);
+	yylloc.first_line = 1;
 
 	// Setup lexer to expect the given file type
 	parseModeStart = mode;
 	parseMode = mode;
 
 	// Start new file scope symbol table
+	SymbolTable *outerScope = symbols;
 	symbols = symbols->PushScope(new SymbolTable());
+	fileScopeVars.clear();
 
 	// Parse input file
 	int err = yyparse();
 
-	// Pop back out of file scope
-	symbols = symbols->PopScope();
+	// Pop back out of file scope, and any scopes left open by a parse error
+	while (symbols != outerScope)
+		symbols = symbols->PopScope();
+
+	// A parse error can also leave modules and instructions unfinished.  Delete them, so that another file can be parsed.
+	if (alu_instruction)
+	{
+		delete alu_instruction;  alu_instruction = NULL;
+	}
+	if (module)
+	{
+		while (module->ParentModule())
+			module = module->ParentModule();
+		delete module;  module = NULL;
+	}
 
 	currentFilename = NULL;
 
@@ -95,6 +121,16 @@ ParseMode parseModeStart = PARSE_OASM;
 // Keep track of current filename for error messages
 const char *currentFilename = NULL;
 
+// Every file parsed, for dependency output
+vector<const char *> parsedFilenames;
+
+// Every top-level module defined, in order
+vector<Module *> parsedModules;
+
+// Command-line values of file-scope vars, and the file-scope vars of the current file
+vector<VarOverride> varOverrides;
+vector<const char *> fileScopeVars;
+
 
 /*
  * Calls used by parser during module construction
@@ -470,6 +506,109 @@ void regWarmResetAffects(const DottedIdentifierList &names)
 
 
 
+/*
+ * Command-line overrides of file-scope vars
+ */
+
+// Converts the text of an override to a value, as the same literal or enumerated value would parse in OASM
+static bool overrideValue(const char *text, Expression &value)
+{
+	int len = strlen(text);
+
+	if (len >= 2 && text[0] == '"' && text[len-1] == '"')
+	{
+		strings->StartString();
+		for (int i=1; i < len-1; i++)
+			strings->AppendChar(text[i]);
+		value = Expression::FromString(strings->FinishString());
+		return true;
+	}
+
+	if (strcmp(text, "true") == 0 || strcmp(text, "false") == 0)
+	{
+		value = Expression::FromInt(text[0] == 't');
+		return true;
+	}
+
+	const char *digits = text;
+	int base = 10;
+	if (strncmp(text, "0x", 2) == 0)
+	{
+		digits = text + 2;
+		base = 16;
+	}
+	else if (strncmp(text, "0b", 2) == 0)
+	{
+		digits = text + 2;
+		base = 2;
+	}
+
+	char *end = NULL;
+	long i = strtol(digits, &end, base);
+	if (end != digits && *end == 0)
+	{
+		value = Expression::FromInt(i);
+		return true;
+	}
+
+	Symbol *s = symbols->Get(text);
+	if (!s)
+		s = LookupEnumValue(text);
+
+	if (s && s->SymbolType() == SYMBOL_ENUM_VALUE)
+	{
+		value = ((EnumValue *) s)->ToExpression();
+		return true;
+	}
+
+	return false;
+}
+
+Expression overrideVar(const char *name, const Expression &value)
+{
+	// Only vars outside of any module can be overridden
+	if (module)
+		return value;
+
+	fileScopeVars.push_back(name);
+
+	for (int i = (int) varOverrides.size() - 1; i >= 0; i--)
+	{
+		const VarOverride &override = varOverrides[i];
+		if (strcmp(override.Name, name) != 0)
+			continue;
+
+		Expression result;
+		if (value.type == EXPRESSION_ARRAY)
+		{
+			yyerrorf("Var '%s' is an array, and cannot be overridden on the command line", name);
+		}
+		else if (!overrideValue(override.Value, result))
+		{
+			yyerrorf("Value of -D %s is not an integer, string or enumerated value: %s", name, override.Value);
+		}
+		else
+		{
+			return result;
+		}
+		break;
+	}
+
+	return value;
+}
+
+bool addVariable(const char *name, const Expression &value)
+{
+	if (LookupEnumValue(name) || !symbols->AddVariable(name, value))
+	{
+		yyerrorf("Variable '%s' already defined", name);
+		return false;
+	}
+	return true;
+}
+
+
+
 /*
  * Calls used to create and finish modules
  */
@@ -504,7 +643,11 @@ void endModule()
 			// Inner modules can be reached in later stages by walking the InnerModule list of the global modules
 			if (module->ParentModule() == NULL)
 			{
-				if (modules.Add(module->Name(), module) == NULL)
+				if (modules.Add(module->Name(), module) != NULL)
+				{
+					parsedModules.push_back(module);
+				}
+				else
 				{
 					Module *orig = (Module *) modules.Get(module->Name());
 					if (orig->Location.Filename)
@@ -516,12 +659,19 @@ void endModule()
 		}
 	}
 
-	// Pop out of current module scope
+	// Pop out of current module scope.
+	// A top-level module which was not added is deleted, after its symbols, since nothing else owns it.
+	Module *unowned = NULL;
 	if (module)
+	{
+		if (module->ParentModule() == NULL && modules.Get(module->Name()) != module)
+			unowned = module;
 		module = module->ParentModule();
+	}
 
 	// Pop out of the symbol table.  This will call appropriate destructors.
 	symbols = symbols->PopScope();
+	delete unowned;
 }
 
 
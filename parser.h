@@ -51,6 +51,33 @@ extern StringMap modules;
 extern ParseMode parseMode;
 extern ParseMode parseModeStart;
 
+/*
+ * Names of all files read by ParseFile or LoadDeviceDescription, in order, used for dependency output.
+ * Standard input is not recorded.
+ */
+extern vector<const char *> parsedFilenames;
+
+/*
+ * Every top-level module added by ParseFile, in order
+ */
+extern vector<Module *> parsedModules;
+
+/*
+ * Values for file-scope vars given on the command line (-D name=value), replacing the values declared in the source.
+ * A value is an integer, a "quoted string", true, false, or an enumerated value.  Later overrides of a name win.
+ */
+struct VarOverride
+{
+	const char *Name;
+	const char *Value;
+};
+extern vector<VarOverride> varOverrides;
+
+/*
+ * Names of the file-scope vars declared by the last call to ParseFile
+ */
+extern vector<const char *> fileScopeVars;
+
 
 /*
  * Primary initialization of parser, to be called only once at program startup
@@ -86,6 +113,13 @@ void endObject();
 
 
 
+// Value of a var declaration, replaced by its command-line override for file-scope vars
+Expression overrideVar(const char *name, const Expression &value);
+
+// Add a var to the current scope.  Enumerated values of silicon objects cannot be redefined.
+bool addVariable(const char *name, const Expression &value);
+
+
 // Create new instances in current module
 Instance *addInstance(const char *moduleName, const char *instanceName);
 
@@ -147,6 +181,7 @@ extern int yyparse(void);
 /* Hooks to lex.l */
 extern FILE *yyin;
 extern int yylex(void);
+extern void yyrestart(FILE *file);
 
 /* Required hooks */
 extern void yyerror(char const *errstr);
@@ -0,0 +1,135 @@
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <map>
+#include "Compiler.h"
+
+//
+// Tests of CompilerContext, compiling several times in one context.
+//
+// Checks that only one context exists at a time, that each compilation starts from the built-in definitions
+// and frees its strings, and that errors are returned as diagnostics without affecting the next compilation.
+// Prints each check with its result, and returns the number of failed checks.
+//
+
+
+// Keeps the files generated by the last compilation
+class MapSink : public OutputSink
+{
+public:
+	virtual bool Write(const char *name, const char *data, size_t length)
+	{
+		files[name].assign(data, length);
+		return true;
+	}
+
+	map<string, string> files;
+};
+
+
+static const char *design =
+	"module Top\n"
+	"{\n"
+	"	input word a;\n"
+	"	output word b;\n"
+	"	wire word unused;\n"
+	"	a -> delay(1) -> b;\n"
+	"	a -> unused;\n"
+	"}\n";
+
+static const char *undefinedSymbol =
+	"module Top\n"
+	"{\n"
+	"	input word a;\n"
+	"	output word b;\n"
+	"	var x = missing;\n"
+	"}\n";
+
+
+static int failed = 0;
+
+static void Check(const char *name, bool ok)
+{
+	printf("%s: %s\n", name, ok ? "PASSED" : "FAILED");
+	if (!ok)
+		failed++;
+}
+
+static void PrintDiagnostics(const CompilerContext *context)
+{
+	const vector<Diagnostic> &diagnostics = context->Diagnostics();
+	for (int i=0; i < (int) diagnostics.size(); i++)
+		printf("  %s line %d: %s\n", diagnostics[i].Filename.c_str(), diagnostics[i].Line, diagnostics[i].Message.c_str());
+}
+
+// Compiles one source, and returns the result of Compile
+static bool CompileSource(CompilerContext *context, const char *name, const char *text, const CompileOptions &options, MapSink &sink)
+{
+	sink.files.clear();
+	context->AddSource(name, text, strlen(text));
+	bool ok = context->Compile(options, sink);
+	PrintDiagnostics(context);
+	return ok;
+}
+
+
+int main(int argc, char *argv[])
+{
+	CompilerContext *context = CompilerContext::Create();
+	Check("A context is created", context != NULL);
+	if (!context)
+		return 1;
+
+	Check("A second context is refused while one exists", CompilerContext::Create() == NULL);
+
+	// Device descriptions which cannot be read are reported, and the context is still usable
+	bool loaded = context->LoadDeviceDescription("/nonexistent/device.txt");
+	PrintDiagnostics(context);
+	Check("A missing device description is a diagnostic", !loaded && context->Diagnostics().size() == 1 &&
+		context->Diagnostics()[0].Severity == DIAGNOSTIC_ERROR && context->Diagnostics()[0].Line == 0);
+
+	CompileOptions options;
+	MapSink sink;
+
+	bool ok = CompileSource(context, "first.oa", design, options, sink);
+	Check("A design compiles", ok && sink.files.count("first.v") == 1 && sink.files["first.v"].find("module Top") != string::npos);
+
+	// Strings of each compilation are released to the mark set by the first, so the buffer does not grow
+	long bytesUsed = strings->BytesUsed();
+	for (int i=0; i < 10; i++)
+		ok = CompileSource(context, "first.oa", design, options, sink) && ok;
+	Check("Repeated compilations succeed, and release their strings", ok && strings->BytesUsed() == bytesUsed);
+
+	ok = CompileSource(context, "second.oa", undefinedSymbol, options, sink);
+	const vector<Diagnostic> &diagnostics = context->Diagnostics();
+	Check("Errors are returned as diagnostics, with their location", !ok && sink.files.empty() && diagnostics.size() == 1 &&
+		diagnostics[0].Severity == DIAGNOSTIC_ERROR && diagnostics[0].Filename == "second.oa" && diagnostics[0].Line == 5 &&
+		diagnostics[0].Module == "Top");
+
+	// Top is defined again, since the modules of the failed compilation were freed
+	ok = CompileSource(context, "third.oa", design, options, sink);
+	Check("A compilation after errors succeeds", ok && context->Diagnostics().empty() && sink.files.count("third.v") == 1);
+
+	options.PruneDeadLogic = true;
+	ok = CompileSource(context, "fourth.oa", design, options, sink);
+	const vector<DeadLogicRemoval> &removed = context->RemovedDeadLogic();
+	Check("Removed dead logic is returned", ok && removed.size() == 1 && removed[0].Module == "Top" && removed[0].Wires == 1);
+
+	loaded = context->LoadDeviceDescription("/nonexistent/device.txt");
+	Check("Device descriptions are refused after the first compilation", !loaded && context->Diagnostics().size() == 1);
+
+	delete context;
+
+	context = CompilerContext::Create();
+	Check("A context is created after the previous one is deleted", context != NULL);
+	if (context)
+	{
+		options.PruneDeadLogic = false;
+		ok = CompileSource(context, "fifth.oa", design, options, sink);
+		Check("A design compiles in the new context", ok && sink.files.count("fifth.v") == 1);
+		delete context;
+	}
+
+	printf("\n%d checks failed\n", failed);
+	return failed;
+}
@@ -0,0 +1,343 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+#include "parser.h"
+#include "Compiler.h"
+#include "DesignSimulator.h"
+#include "Stimulus.h"
+
+//
+// Tests of DesignSimulator on small designs, each checking one of its modelling assumptions.
+//
+// Each design is parsed and resolved as oasm2verilog does, then Top is run with the stimulus given, and the trace
+// is compared with the expected one.  Warnings and errors are collected, and compared with the expected ones if any.
+// Prints each test with its result, and returns the number of failed tests.
+//
+
+
+struct DesignTest
+{
+	const char *Name;
+	const char *Source;
+	const char *Stimulus;
+	const char *Trace;          // Without the header line describing words
+	const char *Warning;        // Expected warning, or NULL for none
+	const char *Error;          // Expected error, or NULL for none
+};
+
+
+static const DesignTest tests[] =
+{
+	{
+		"TF registers are clocked, and see the v-bit of word inputs",
+		"TF Toggle\n"
+		"{\n"
+		"	input bit en;\n"
+		"	input word w;\n"
+		"	output reg bit q;\n"
+		"	output reg bit valid;\n"
+		"	q = en ^ q;\n"
+		"	valid = w.v;\n"
+		"}\n"
+		"module Top\n"
+		"{\n"
+		"	input bit en;\n"
+		"	input word in;\n"
+		"	output bit q;\n"
+		"	output bit valid;\n"
+		"	Toggle t;\n"
+		"	en -> t.en;\n"
+		"	in -> t.w;\n"
+		"	t.q -> q;\n"
+		"	t.valid -> valid;\n"
+		"}\n",
+		"en in\n"
+		"1 1\n"
+		"1 0x10002\n"
+		"0 3\n"
+		"1 4\n",
+		"cycle	en	in	q	valid\n"
+		"0	1	00001	0	0\n"
+		"1	1	10002	1	0\n"
+		"2	0	00003	0	1\n"
+		"3	1	00004	0	0\n",
+		NULL,
+		NULL
+	},
+	{
+		"ALU outputs are registered",
+		"ALU Add\n"
+		"{\n"
+		"	input word x;\n"
+		"	input word z;\n"
+		"	output reg word y;\n"
+		"	inst\n"
+		"	{\n"
+		"		y = add(x, z);\n"
+		"	}\n"
+		"}\n"
+		"module Top\n"
+		"{\n"
+		"	input word in;\n"
+		"	output word sum;\n"
+		"	Add a;\n"
+		"	in -> a.x;\n"
+		"	in -> a.z;\n"
+		"	a.y -> sum;\n"
+		"}\n",
+		"in\n"
+		"1\n"
+		"2\n"
+		"3\n",
+		"cycle	in	sum\n"
+		"0	00001	00000\n"
+		"1	00002	00002\n"
+		"2	00003	00004\n",
+		NULL,
+		NULL
+	},
+	{
+		"Delays lag their source by their count, through inner modules",
+		"module Top\n"
+		"{\n"
+		"	input word in;\n"
+		"	output word late;\n"
+		"	output word later;\n"
+		"	module Inner\n"
+		"	{\n"
+		"		input word a;\n"
+		"		output word b;\n"
+		"		a -> delay(1) -> b;\n"
+		"	}\n"
+		"	Inner i;\n"
+		"	in -> delay(2) -> late;\n"
+		"	in -> i.a;\n"
+		"	i.b -> later;\n"
+		"}\n",
+		"in\n"
+		"1\n"
+		"2\n"
+		"3\n"
+		"4\n",
+		"cycle	in	late	later\n"
+		"0	00001	00000	00000\n"
+		"1	00002	00000	00001\n"
+		"2	00003	00001	00002\n"
+		"3	00004	00002	00003\n",
+		NULL,
+		NULL
+	},
+	{
+		"Extern modules are not simulated, and drive 0",
+		"extern module Ext\n"
+		"{\n"
+		"	input word a;\n"
+		"	output word b;\n"
+		"}\n"
+		"module Top\n"
+		"{\n"
+		"	input word in;\n"
+		"	output word out;\n"
+		"	Ext e;\n"
+		"	in -> e.a;\n"
+		"	e.b -> out;\n"
+		"}\n",
+		"in\n"
+		"5\n"
+		"6\n",
+		"cycle	in	out\n"
+		"0	00005	00000\n"
+		"1	00006	00000\n",
+		"Extern module 'Ext' is not simulated, and its outputs are 0",
+		NULL
+	},
+	{
+		"RF_RAM reads are registered, starting from init_data",
+		"RF_RAM Mem\n"
+		"{\n"
+		"	input bit Wr -> wr;\n"
+		"	input word WrAddr -> wr_addr;\n"
+		"	input word WrData -> wr_data0_word;\n"
+		"	input bit Rd -> rd;\n"
+		"	input word RdAddr -> rd_addr;\n"
+		"	output word RdData <- rd_data0_word;\n"
+		"	wr_width = 1;\n"
+		"	rd_width = 1;\n"
+		"	init_data = {7, 8, 9};\n"
+		"}\n"
+		"module Top\n"
+		"{\n"
+		"	input bit wr;\n"
+		"	input bit rden;\n"
+		"	input word addr;\n"
+		"	input word data;\n"
+		"	output word rd;\n"
+		"	Mem m;\n"
+		"	wr -> m.Wr;\n"
+		"	addr -> m.WrAddr;\n"
+		"	addr -> m.RdAddr;\n"
+		"	data -> m.WrData;\n"
+		"	rden -> m.Rd;\n"
+		"	m.RdData -> rd;\n"
+		"}\n",
+		"wr rden addr data\n"
+		"0 1 0 0\n"
+		"0 1 1 0\n"
+		"1 1 1 0x55\n"
+		"0 1 1 0\n"
+		"0 1 2 0\n",
+		"cycle	addr	data	rd	rden	wr\n"
+		"0	00000	00000	00000	1	0\n"
+		"1	00001	00000	00007	1	0\n"
+		"2	00001	00055	00008	1	1\n"
+		"3	00001	00000	00008	1	0\n"
+		"4	00002	00000	00055	1	0\n",
+		NULL,
+		NULL
+	},
+	{
+		"ALUs using a function without a model are not run",
+		"ALU Shift\n"
+		"{\n"
+		"	input word x;\n"
+		"	output reg word y;\n"
+		"	inst\n"
+		"	{\n"
+		"		y = shl(x);\n"
+		"	}\n"
+		"}\n"
+		"module Top\n"
+		"{\n"
+		"	input word in;\n"
+		"	output word out;\n"
+		"	Shift s;\n"
+		"	in -> s.x;\n"
+		"	s.y -> out;\n"
+		"}\n",
+		"in\n"
+		"1\n",
+		"",
+		NULL,
+		"ALU function 'shl' has no verified model, so ALU 'Shift' cannot be simulated"
+	},
+};
+
+
+static vector<string> warnings;
+static vector<string> errors;
+
+static void CollectDiagnostic(DiagnosticSeverity severity, SourceCodeLocation loc, const char *kind, const char *message)
+{
+	if (severity == DIAGNOSTIC_WARNING)
+		warnings.push_back(message);
+	else
+		errors.push_back(message);
+}
+
+
+// Returns the trace of Top, or an empty string if the design or stimulus has errors
+static string Simulate(const DesignTest &test)
+{
+	string trace;
+
+	FILE *source = fmemopen((void *) test.Source, strlen(test.Source), "r");
+	bool ok = ParseFile(source, "test.oa", PARSE_OASM) == 0;
+	fclose(source);
+
+	ok = ok && ResolveInstances() && ResolveConnections();
+	if (ok)
+		BuildDelayChains();
+
+	// Stimulus is read from a file, as with --simulate
+	char filename[] = "/tmp/testDesignSimulatorXXXXXX";
+	int fd = mkstemp(filename);
+	if (fd < 0)
+		return trace;
+	write(fd, test.Stimulus, strlen(test.Stimulus));
+	close(fd);
+
+	Stimulus stimulus;
+	ok = stimulus.Read(filename) && ok;
+	unlink(filename);
+
+	const Module *top = (const Module *) modules.Get("Top");
+	if (ok && top)
+	{
+		char *buffer = NULL;
+		size_t length = 0;
+		FILE *f = open_memstream(&buffer, &length);
+
+		DesignSimulator simulator(top);
+		if (simulator.Run(stimulus, stimulus.Rows(), f))
+		{
+			fclose(f);
+			trace.assign(buffer, length);
+		}
+		else
+		{
+			fclose(f);
+		}
+		free(buffer);
+	}
+
+	DeleteModules();
+	errorCount = 0;
+	warnCount = 0;
+
+	// Drop the description of words at the start
+	if (!trace.empty() && trace[0] == '#')
+		trace.erase(0, trace.find('\n') + 1);
+	return trace;
+}
+
+
+int main(int argc, char *argv[])
+{
+	InitParser();
+	diagnosticHandler = CollectDiagnostic;
+
+	int failed = 0;
+	int ntests = sizeof(tests) / sizeof(tests[0]);
+	for (int i=0; i < ntests; i++)
+	{
+		const DesignTest &test = tests[i];
+		printf("\n%s\n", test.Name);
+
+		warnings.clear();
+		errors.clear();
+		string trace = Simulate(test);
+		printf("%s", trace.c_str());
+
+		bool ok = trace == test.Trace;
+		if (!ok)
+			printf("Expected:\n%s", test.Trace);
+
+		for (size_t w=0; w < warnings.size(); w++)
+			printf("WARNING: %s\n", warnings[w].c_str());
+		if (test.Warning ? warnings.size() != 1 || warnings[0] != test.Warning : !warnings.empty())
+		{
+			printf("Expected warning: %s\n", test.Warning ? test.Warning : "(none)");
+			ok = false;
+		}
+
+		for (size_t e=0; e < errors.size(); e++)
+			printf("ERROR: %s\n", errors[e].c_str());
+		if (test.Error ? errors.size() != 1 || errors[0] != test.Error : !errors.empty())
+		{
+			printf("Expected error: %s\n", test.Error ? test.Error : "(none)");
+			ok = false;
+		}
+
+		printf("%s\n", ok ? "PASSED" : "FAILED");
+		if (!ok)
+			failed++;
+	}
+
+	printf("\n%d of %d tests failed\n", failed, ntests);
+
+	CleanupParser();
+	return failed;
+}
@@ -0,0 +1,371 @@
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <string>
+#include "Compiler.h"
+#include "NetlistFormat.h"
+
+//
+// Tests of the binary netlist, read back as a tool would, from a memory-mapped file.
+//
+// A small design is compiled with --netlist, and every section is walked:  the layout of the header and sections,
+// then every reference between records and into the string section, then a few records by value.
+// Prints each check with its result, and returns the number of failed checks.
+//
+
+
+static const char *design =
+	"ALU Add\n"
+	"{\n"
+	"	input word x;\n"
+	"	input word z;\n"
+	"	output reg word y;\n"
+	"	inst\n"
+	"	{\n"
+	"		y = add(x, z);\n"
+	"	}\n"
+	"}\n"
+	"RF_RAM Mem\n"
+	"{\n"
+	"	input word WrData -> wr_data0_word;\n"
+	"	input word Addr -> wr_addr;\n"
+	"	output word RdData <- rd_data0_word;\n"
+	"	wr_mode = active_low;\n"
+	"	init_data = {7, 8, 9};\n"
+	"}\n"
+	"module Top\n"
+	"{\n"
+	"	input word in;\n"
+	"	output word sum;\n"
+	"	output word late;\n"
+	"	output word rd;\n"
+	"	module Inner\n"
+	"	{\n"
+	"		input word a;\n"
+	"		output word b;\n"
+	"		a -> delay(2) -> b;\n"
+	"	}\n"
+	"	Add a;\n"
+	"	Mem m;\n"
+	"	Inner i;\n"
+	"	in -> a.x;\n"
+	"	in -> a.z;\n"
+	"	a.y -> sum;\n"
+	"	in -> m.WrData;\n"
+	"	in -> m.Addr;\n"
+	"	m.RdData -> rd;\n"
+	"	in -> i.a;\n"
+	"	i.b -> late;\n"
+	"}\n";
+
+
+// Keeps the netlist generated by a compilation
+class NetlistSink : public OutputSink
+{
+public:
+	virtual bool Write(const char *name, const char *data, size_t length)
+	{
+		if (strstr(name, ".oanl"))
+			netlist.assign(data, length);
+		return true;
+	}
+
+	string netlist;
+};
+
+
+static int failed = 0;
+
+static void Check(const char *name, bool ok)
+{
+	printf("%s: %s\n", name, ok ? "PASSED" : "FAILED");
+	if (!ok)
+		failed++;
+}
+
+
+// Sections of a mapped netlist
+static const char *base;
+static const NetlistHeader *header;
+static const char *stringSection;
+static const NetlistModule *moduleRecords;
+static const NetlistSignal *signalRecords;
+static const NetlistInstance *instanceRecords;
+static const NetlistConnection *connectionRecords;
+static const NetlistParameter *parameterRecords;
+static const NetlistParameterValue *valueRecords;
+static const NetlistAluInstruction *aluRecords;
+
+static uint32_t Count(NetlistSectionId id)
+{
+	return header->Sections[id].Count;
+}
+
+static bool ValidString(uint32_t offset)
+{
+	return offset < Count(NETLIST_STRINGS);
+}
+
+static bool ValidIndex(uint32_t index, NetlistSectionId id)
+{
+	return index < Count(id);
+}
+
+static bool ValidRange(uint32_t first, uint32_t n, NetlistSectionId id)
+{
+	return first <= Count(id) && n <= Count(id) - first;
+}
+
+static const char *String(uint32_t offset)
+{
+	return offset == NETLIST_NONE ? "" : stringSection + offset;
+}
+
+
+// Checks the header, and that every section lies within the file, in order, aligned and with the expected record size
+static bool CheckLayout(size_t fileSize)
+{
+	static const uint32_t recordSizes[NETLIST_NUM_SECTIONS] =
+	{
+		1, sizeof(NetlistModule), sizeof(NetlistSignal), sizeof(NetlistInstance), sizeof(NetlistConnection),
+		sizeof(NetlistParameter), sizeof(NetlistParameterValue), sizeof(NetlistAluInstruction)
+	};
+
+	if (memcmp(header->Magic, NETLIST_MAGIC, 4) != 0 || header->Version != NETLIST_VERSION ||
+		header->ByteOrder != NETLIST_BYTE_ORDER || header->FileSize != fileSize)
+		return false;
+
+	uint32_t end = sizeof(NetlistHeader);
+	for (int i=0; i < NETLIST_NUM_SECTIONS; i++)
+	{
+		const NetlistSection &section = header->Sections[i];
+		if (section.Offset % 8 != 0 || section.Offset < end || section.RecordSize != recordSizes[i])
+			return false;
+
+		end = section.Offset + section.Count * section.RecordSize;
+		if (end > header->FileSize)
+			return false;
+	}
+
+	// Strings are null-terminated, including the last
+	uint32_t nstrings = Count(NETLIST_STRINGS);
+	return nstrings == 0 || base[header->Sections[NETLIST_STRINGS].Offset + nstrings - 1] == 0;
+}
+
+// Checks every reference of the records of one module
+static bool CheckModule(uint32_t index)
+{
+	const NetlistModule &m = moduleRecords[index];
+
+	// Parents come before their inner modules
+	if (!ValidString(m.Name) || !ValidString(m.LocalName) || !ValidString(m.TypeName) || !ValidString(m.SourceFile) ||
+		(m.Parent != NETLIST_NONE && m.Parent >= index) || !ValidIndex(m.SharedDefinition, NETLIST_MODULES) ||
+		m.NumPorts > m.NumSignals || !ValidRange(m.FirstSignal, m.NumSignals, NETLIST_SIGNALS) ||
+		!ValidRange(m.FirstInstance, m.NumInstances, NETLIST_INSTANCES) ||
+		!ValidRange(m.FirstConnection, m.NumConnections, NETLIST_CONNECTIONS) ||
+		!ValidRange(m.FirstParameter, m.NumParameters, NETLIST_PARAMETERS) ||
+		!ValidRange(m.FirstAluInstruction, m.NumAluInstructions, NETLIST_ALU_INSTRUCTIONS))
+		return false;
+
+	for (uint32_t i=0; i < m.NumSignals; i++)
+	{
+		const NetlistSignal &s = signalRecords[m.FirstSignal + i];
+		bool isPort = (i < m.NumPorts);
+		if (!ValidString(s.Name) || s.Module != index || isPort != (s.Direction != NETLIST_DIR_NONE) ||
+			(s.BaseSignal != NETLIST_NONE && !ValidIndex(s.BaseSignal, NETLIST_SIGNALS)) ||
+			(s.DelaySource != NETLIST_NONE && !ValidIndex(s.DelaySource, NETLIST_SIGNALS)))
+			return false;
+	}
+
+	for (uint32_t i=0; i < m.NumInstances; i++)
+	{
+		const NetlistInstance &r = instanceRecords[m.FirstInstance + i];
+		if (!ValidString(r.Name) || r.Module != index || !ValidIndex(r.Definition, NETLIST_MODULES))
+			return false;
+	}
+
+	for (uint32_t i=0; i < m.NumConnections; i++)
+	{
+		const NetlistConnection &c = connectionRecords[m.FirstConnection + i];
+		if (c.Module != index || !ValidIndex(c.SourceSignal, NETLIST_SIGNALS) || !ValidIndex(c.DestinationSignal, NETLIST_SIGNALS) ||
+			(c.SourceInstance != NETLIST_NONE && !ValidIndex(c.SourceInstance, NETLIST_INSTANCES)) ||
+			(c.DestinationInstance != NETLIST_NONE && !ValidIndex(c.DestinationInstance, NETLIST_INSTANCES)))
+			return false;
+	}
+
+	for (uint32_t i=0; i < m.NumParameters; i++)
+	{
+		const NetlistParameter &p = parameterRecords[m.FirstParameter + i];
+		if (!ValidString(p.Name) || p.Module != index || !ValidRange(p.FirstValue, p.NumValues, NETLIST_PARAMETER_VALUES))
+			return false;
+
+		for (uint32_t j=0; j < p.NumValues; j++)
+		{
+			const NetlistParameterValue &v = valueRecords[p.FirstValue + j];
+			bool isString = (v.Kind == NETLIST_VALUE_STRING || v.Kind == NETLIST_VALUE_ENUM);
+			if (v.Kind > NETLIST_VALUE_OTHER || (isString ? !ValidString(v.String) : v.String != NETLIST_NONE) ||
+				(v.Kind != NETLIST_VALUE_INT && v.Int != 0))
+				return false;
+		}
+	}
+
+	for (uint32_t i=0; i < m.NumAluInstructions; i++)
+	{
+		const NetlistAluInstruction &r = aluRecords[m.FirstAluInstruction + i];
+		if (r.Module != index || r.NumDests > NETLIST_MAX_ALU_DESTS || r.NumArgs > NETLIST_MAX_ALU_ARGS ||
+			(r.Label != NETLIST_NONE && !ValidString(r.Label)) || (r.Function != NETLIST_NONE && !ValidString(r.Function)))
+			return false;
+
+		for (uint32_t j=0; j < r.NumDests; j++)
+			if (!ValidIndex(r.Dests[j], NETLIST_SIGNALS))
+				return false;
+		for (uint32_t j=0; j < r.NumArgs; j++)
+			if (!(r.ConstantArgs & (1 << j)) && !ValidIndex(r.Args[j], NETLIST_SIGNALS))
+				return false;
+	}
+
+	return true;
+}
+
+// Checks every module, and that the records of all modules together cover every section
+static bool CheckReferences()
+{
+	uint32_t nmodules = Count(NETLIST_MODULES);
+	uint32_t moduleSignals = 0, ninstances = 0, nconnections = 0, nparameters = 0, ninstructions = 0;
+	for (uint32_t i=0; i < nmodules; i++)
+	{
+		if (!CheckModule(i))
+		{
+			printf("  Module %u (%s) has invalid references\n", i, ValidString(moduleRecords[i].Name) ? String(moduleRecords[i].Name) : "?");
+			return false;
+		}
+		moduleSignals += moduleRecords[i].NumSignals;
+		ninstances += moduleRecords[i].NumInstances;
+		nconnections += moduleRecords[i].NumConnections;
+		nparameters += moduleRecords[i].NumParameters;
+		ninstructions += moduleRecords[i].NumAluInstructions;
+	}
+
+	// Signals of no module follow those of all modules
+	for (uint32_t i=moduleSignals; i < Count(NETLIST_SIGNALS); i++)
+	{
+		if (signalRecords[i].Module != NETLIST_NONE || !ValidString(signalRecords[i].Name))
+			return false;
+	}
+
+	return moduleSignals <= Count(NETLIST_SIGNALS) && ninstances == Count(NETLIST_INSTANCES) &&
+		nconnections == Count(NETLIST_CONNECTIONS) && nparameters == Count(NETLIST_PARAMETERS) &&
+		ninstructions == Count(NETLIST_ALU_INSTRUCTIONS);
+}
+
+
+static const NetlistModule *FindModule(const char *name)
+{
+	for (uint32_t i=0; i < Count(NETLIST_MODULES); i++)
+		if (strcmp(String(moduleRecords[i].Name), name) == 0)
+			return &moduleRecords[i];
+	return NULL;
+}
+
+static const NetlistParameter *FindParameter(const NetlistModule *m, const char *name)
+{
+	for (uint32_t i=0; m && i < m->NumParameters; i++)
+		if (strcmp(String(parameterRecords[m->FirstParameter + i].Name), name) == 0)
+			return &parameterRecords[m->FirstParameter + i];
+	return NULL;
+}
+
+
+int main(int argc, char *argv[])
+{
+	CompilerContext *context = CompilerContext::Create();
+	if (!context)
+		return 1;
+
+	CompileOptions options;
+	options.Netlist = true;
+	NetlistSink sink;
+
+	context->AddSource("design.oa", design, strlen(design));
+	bool ok = context->Compile(options, sink);
+	for (int i=0; i < (int) context->Diagnostics().size(); i++)
+		printf("  line %d: %s\n", context->Diagnostics()[i].Line, context->Diagnostics()[i].Message.c_str());
+	Check("The design compiles with a netlist", ok && !sink.netlist.empty());
+
+	// Read back from a mapped file, as tools do
+	char filename[] = "/tmp/testNetlistWriterXXXXXX";
+	int fd = mkstemp(filename);
+	if (fd < 0 || write(fd, sink.netlist.data(), sink.netlist.size()) != (ssize_t) sink.netlist.size())
+	{
+		printf("Cannot write %s\n", filename);
+		return 1;
+	}
+
+	size_t size = sink.netlist.size();
+	base = (const char *) mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	unlink(filename);
+	if (base == MAP_FAILED)
+	{
+		printf("Cannot map %s\n", filename);
+		return 1;
+	}
+
+	header = (const NetlistHeader *) base;
+	bool layout = size >= sizeof(NetlistHeader) && CheckLayout(size);
+	Check("Sections are in order, aligned and within the file", layout);
+
+	if (layout)
+	{
+		stringSection = base + header->Sections[NETLIST_STRINGS].Offset;
+		moduleRecords = (const NetlistModule *) (base + header->Sections[NETLIST_MODULES].Offset);
+		signalRecords = (const NetlistSignal *) (base + header->Sections[NETLIST_SIGNALS].Offset);
+		instanceRecords = (const NetlistInstance *) (base + header->Sections[NETLIST_INSTANCES].Offset);
+		connectionRecords = (const NetlistConnection *) (base + header->Sections[NETLIST_CONNECTIONS].Offset);
+		parameterRecords = (const NetlistParameter *) (base + header->Sections[NETLIST_PARAMETERS].Offset);
+		valueRecords = (const NetlistParameterValue *) (base + header->Sections[NETLIST_PARAMETER_VALUES].Offset);
+		aluRecords = (const NetlistAluInstruction *) (base + header->Sections[NETLIST_ALU_INSTRUCTIONS].Offset);
+
+		bool references = CheckReferences();
+		Check("Every reference is within its section", references);
+
+		if (references)
+		{
+			const NetlistModule *top = FindModule("Top");
+			const NetlistModule *inner = FindModule("Top$Inner");
+			Check("Modules are listed parent first", top && inner && inner->Parent == (uint32_t) (top - moduleRecords) &&
+				top->NumInstances == 3 && top->NumConnections == 8 && top->NumPorts == 4);
+
+			const NetlistModule *mem = FindModule("Mem");
+			const NetlistParameter *mode = FindParameter(mem, "wr_mode");
+			Check("Enumerated values are tagged", mem && strcmp(String(mem->TypeName), "RF_RAM") == 0 && mode &&
+				(mode->Flags & NETLIST_PARAMETER_ASSIGNED) && mode->NumValues == 1 &&
+				valueRecords[mode->FirstValue].Kind == NETLIST_VALUE_ENUM && strcmp(String(valueRecords[mode->FirstValue].String), "active_low") == 0);
+
+			const NetlistParameter *init = FindParameter(mem, "init_data");
+			bool ints = init && init->NumValues == 3;
+			for (uint32_t i=0; ints && i < 3; i++)
+				ints = valueRecords[init->FirstValue + i].Kind == NETLIST_VALUE_INT && valueRecords[init->FirstValue + i].Int == (int32_t) (7 + i);
+			Check("Array elements are tagged ints", ints);
+
+			const NetlistModule *add = FindModule("Add");
+			bool program = add && add->NumAluInstructions == 1;
+			if (program)
+			{
+				const NetlistAluInstruction &r = aluRecords[add->FirstAluInstruction];
+				program = strcmp(String(r.Function), "add") == 0 && r.NumDests == 1 && r.NumArgs == 2 &&
+					strcmp(String(signalRecords[r.Dests[0]].Name), "y") == 0 && strcmp(String(signalRecords[r.Args[1]].Name), "z") == 0;
+			}
+			Check("ALU instructions refer to their signals", program);
+		}
+	}
+
+	munmap((void *) base, size);
+	delete context;
+
+	printf("\n%d checks failed\n", failed);
+	return failed;
+}
@@ -52,6 +52,12 @@ int main(int argc, char *argv[])
 		printf("%s", str3);
 	}
 
+	// A string which fills its chunk exactly is not copied into the next one
+	StringBuffer exact(16);
+	exact.AddString("fifteen_chars__");
+	exact.PrintStatistics(stdout);
+	printf("%s\n", exact.NumChunks() == 2 && exact.BytesAllocated() == 32 ? "PASSED" : "FAILED");
+
 	printf("\n\n== DONE ==\n\n");
 
 	return 0;
@@ -1,27 +1,97 @@
 
 #include <stdio.h>
+#include "parser.h"
 #include "Signal.h"
 #include "TruthFunction.h"
 
 
-void TestTF(char *msg, const TruthFunction &tf)
+// Value of a truth function for values of the signals a, b, c and d
+typedef bool (*ExpectedTF)(bool a, bool b, bool c, bool d);
+
+static bool A(bool a, bool b, bool c, bool d)                   { return a; }
+static bool C(bool a, bool b, bool c, bool d)                   { return c; }
+static bool NotA(bool a, bool b, bool c, bool d)                { return !a; }
+static bool AOrB(bool a, bool b, bool c, bool d)                { return a || b; }
+static bool AAndB_Or_CAndB(bool a, bool b, bool c, bool d)      { return (a && b) || (c && b); }
+static bool AAndB_Xor_DAndC_Xor_B(bool a, bool b, bool c, bool d)   { return (a && b) != ((d && c) != b); }
+static bool DAndC_Or_BAndA(bool a, bool b, bool c, bool d)      { return (d && c) || (b && a); }
+static bool AAndNotB(bool a, bool b, bool c, bool d)            { return a && !b; }
+static bool AAndNotB_Or_D(bool a, bool b, bool c, bool d)       { return (a && !b) || d; }
+static bool AAndNotB_Or_D_And_B(bool a, bool b, bool c, bool d) { return ((a && !b) || d) && b; }
+static bool DAndB(bool a, bool b, bool c, bool d)               { return d && b; }
+static bool DTernaryBC(bool a, bool b, bool c, bool d)          { return d ? b : c; }
+
+static Signal *signals[4];      // a, b, c and d
+static int failed = 0;
+
+
+void TestTF(const char *msg, const TruthFunction &tf)
 {
 	printf("\n%s\n", msg);
 	tf.Print(stdout);
 	printf("\n");
 
-	char buf[16];
-	printf("%s\n", tf.ToVerilogExpression(buf, sizeof(buf)));
+	printf("%s\n", tf.ToVerilogExpression());
+}
+
+
+// Checks the logic and the Verilog expression of a truth function against the expected function of a to d
+void CheckTF(const char *msg, const TruthFunction &tf, ExpectedTF expected)
+{
+	TestTF(msg, tf);
+
+	// Entries with an unused argument set are not checked
+	bool ok = true;
+	for (int index=0; index < 16; index++)
+	{
+		bool values[4] = { false, false, false, false };
+		bool used = true;
+		for (int i=0; i < 4; i++)
+		{
+			if (!(index & (1 << i)))
+				continue;
+			used = false;
+			for (int s=0; s < 4; s++)
+			{
+				if (tf.Args[i] == signals[s])
+				{
+					values[s] = true;
+					used = true;
+				}
+			}
+			if (!used)
+				break;
+		}
+
+		if (used && ((tf.Logic >> index) & 1) != expected(values[0], values[1], values[2], values[3]))
+			ok = false;
+	}
+
+	if (!ok)
+		printf("FAILED:  logic 0x%04X does not match\n", tf.Logic);
+	else if (!tf.MatchesVerilogExpression(tf.ToVerilogExpression()))
+		printf("FAILED:  expression does not match logic 0x%04X\n", tf.Logic);
+	else
+		return;
+
+	failed++;
 }
 
 
 int main(int argc, char *argv[])
 {
+	// Expressions are generated in the global string buffer
+	InitParser();
+
 	Signal *a = new Signal("a", BEHAVIOR_WIRE, DATA_TYPE_BIT, DIR_NONE, 0);
 	Signal *b = new Signal("b", BEHAVIOR_WIRE, DATA_TYPE_BIT, DIR_NONE, 1);
 	Signal *c = new Signal("c", BEHAVIOR_WIRE, DATA_TYPE_BIT, DIR_NONE, 1);
 	Signal *d = new Signal("d", BEHAVIOR_WIRE, DATA_TYPE_BIT, DIR_NONE, 0);
 	Signal *e = new Signal("e", BEHAVIOR_WIRE, DATA_TYPE_BIT, DIR_NONE, 0);
+	signals[0] = a;
+	signals[1] = b;
+	signals[2] = c;
+	signals[3] = d;
 
 	TruthFunction tf_int0 = TruthFunction::FromInt(0);
 	tf_int0.Print(stdout);
@@ -69,14 +139,36 @@ int main(int argc, char *argv[])
 	TruthFunction dTb_c         = tf_d.Ternary_TF(tf_b, tf_c);
 	TruthFunction dAb_O_NdAc    = (tf_d.AND_TF(tf_b)).OR_TF(tf_d.NOT_TF().AND_TF(tf_c));
 
-	TestTF("a && !b",                   aAb );
-	TestTF("(a && !b) || d",            aAbOd );
-	TestTF("((a && !b) || d) && b",     aAbOdAb );
-	TestTF("d && b",                    dAb );
-	TestTF("d ? b : c",                 dTb_c );
-	TestTF("(d && b) || (~d && c)",     dAb_O_NdAc );
-
-	return 0;
+	CheckTF("a && !b",                  aAb,            AAndNotB );
+	CheckTF("(a && !b) || d",           aAbOd,          AAndNotB_Or_D );
+	CheckTF("((a && !b) || d) && b",    aAbOdAb,        AAndNotB_Or_D_And_B );
+	CheckTF("d && b",                   dAb,            DAndB );
+	CheckTF("d ? b : c",                dTb_c,          DTernaryBC );
+	CheckTF("(d && b) || (~d && c)",    dAb_O_NdAc,     DTernaryBC );
+
+	// Operators with a constant operand, which keep the expression of the other operand
+	TruthFunction tf_int1 = TruthFunction::FromInt(1);
+	CheckTF("1 & a",                    tf_int1.AND_TF(tf_a),   A );
+	CheckTF("0 | a",                    tf_int0.OR_TF(tf_a),    A );
+	CheckTF("0 ^ a",                    tf_int0.XOR_TF(tf_a),   A );
+	CheckTF("1 ^ a",                    tf_int1.XOR_TF(tf_a),   NotA );
+	CheckTF("a | b",                    tf_a.OR_TF(tf_b),       AOrB );
+
+	// Merges where an argument has the same index in both functions, and where arguments are swapped more than once
+	CheckTF("(a & b) | (c & b)",        tf_a.AND_TF(tf_b).OR_TF(tf_c.AND_TF(tf_b)),                         AAndB_Or_CAndB );
+	CheckTF("(a & b) ^ ((d & c) ^ b)",  tf_a.AND_TF(tf_b).XOR_TF(tf_d.AND_TF(tf_c).XOR_TF(tf_b)),           AAndB_Xor_DAndC_Xor_B );
+	CheckTF("(d & c) | (b & a)",        tf_d.AND_TF(tf_c).OR_TF(tf_b.AND_TF(tf_a)),                         DAndC_Or_BAndA );
+
+	// Expressions longer than any fixed buffer are kept whole
+	TruthFunction tf_long = tf_c;
+	for (int i=0; i < 40; i++)
+		tf_long = tf_long.XOR_TF(tf_a.AND_TF(tf_b));
+	CheckTF("c ^ (a & b) ^ ... ^ (a & b)",  tf_long,    C );
+
+	printf("\n%d test(s) failed\n", failed);
+
+	CleanupParser();
+	return failed;
 }
 
 